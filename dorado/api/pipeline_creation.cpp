@@ -145,9 +145,8 @@ void create_stereo_duplex_pipeline(PipelineDescriptor& pipeline_desc,
                               std::thread::hardware_concurrency(), 1000)
                     : pipeline_desc.add_node<PairingNode>(
                               {stereo_node},
-                              std::move(std::get<std::map<std::string, std::string>>(
-                                      pairing_parameters)),
-                              2, 1000);
+                              std::move(std::get<utils::DuplexPairList>(pairing_parameters)), 2,
+                              1000);
 
     // Create a duplex split node with the given settings and number of devices.
     // If splitter_settings.enabled is set to false, the splitter node will act
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "read_pipeline/ReadPipeline.h"
+#include "utils/duplex_pair_list.h"
 
 #include <cstdint>
 #include <map>
@@ -21,7 +22,7 @@ class ModBaseRunner;
 using RunnerPtr = std::unique_ptr<ModBaseRunner>;
 }  // namespace modbase
 
-using PairingParameters = std::variant<DuplexPairingParameters, std::map<std::string, std::string>>;
+using PairingParameters = std::variant<DuplexPairingParameters, utils::DuplexPairList>;
 
 namespace api {
 
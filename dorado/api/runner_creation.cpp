@@ -1,7 +1,9 @@
 #include "runner_creation.h"
 
 #include "basecall/ModelRunner.h"
+#include "basecall/cpu_autotune.h"
 #include "basecall/crf_utils.h"
+#include "basecall/decode/Decoder.h"
 #include "modbase/ModBaseModelConfig.h"
 
 #if DORADO_METAL_BUILD
@@ -15,10 +17,70 @@
 #include <cxxpool.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <functional>
 #include <thread>
 
 namespace dorado::api {
 
+namespace {
+
+// CPU runners stage the next batch, run the model and decode the previous batch concurrently,
+// each with its own input slab.
+constexpr size_t NUM_CPU_INPUT_SLABS = 3;
+
+// Chunk sizes for CPU runners, largest first. As on the GPU, simplex basecalling also uses any
+// DORADO_EXTRA_CHUNK_SIZES, to which BasecallerNode routes short reads and read tails. These are
+// normalised like the model's chunk size, and sizes which don't fit between the overlap and the
+// model's chunk size are skipped.
+std::vector<int> get_cpu_chunk_sizes(const basecall::CRFModelConfig& model_config,
+                                     PipelineType pipeline_type) {
+    const int chunk_size = model_config.basecaller.chunk_size();
+    std::vector<int> chunk_sizes{chunk_size};
+    if (pipeline_type != PipelineType::simplex) {
+        return chunk_sizes;
+    }
+    for (int extra_chunk_size : basecall::get_extra_chunk_sizes()) {
+        auto extra_config = model_config;
+        extra_config.basecaller.set_chunk_size(extra_chunk_size);
+        extra_config.normalise_basecaller_params();
+        const int size = extra_config.basecaller.chunk_size();
+        if (size > model_config.basecaller.overlap() && size < chunk_size &&
+            std::find(chunk_sizes.begin(), chunk_sizes.end(), size) == chunk_sizes.end()) {
+            chunk_sizes.push_back(size);
+        }
+    }
+    std::sort(chunk_sizes.begin() + 1, chunk_sizes.end(), std::greater<int>());
+    return chunk_sizes;
+}
+
+// Adds num_runners sets of CPU runners, each with one runner per chunk size in the order
+// BasecallerNode expects. The runners of a set share one instance of the model, which doesn't
+// depend on the chunk size.
+void add_cpu_runners(std::vector<basecall::RunnerPtr>& runners,
+                     const basecall::CRFModelConfig& model_config,
+                     const std::vector<int>& chunk_sizes,
+                     size_t num_runners,
+                     int num_decode_threads) {
+    const auto dtype =
+            basecall::decode::create_decoder(c10::Device(c10::kCPU), model_config)->dtype();
+    for (size_t i = 0; i < num_runners; i++) {
+        const auto module = basecall::load_crf_model(
+                model_config, at::TensorOptions().dtype(dtype).device(at::kCPU));
+        for (int chunk_size : chunk_sizes) {
+            auto chunk_config = model_config;
+            chunk_config.basecaller.set_chunk_size(chunk_size);
+            runners.push_back(std::make_unique<basecall::ModelRunner>(
+                    chunk_config, "cpu", module, num_decode_threads, NUM_CPU_INPUT_SLABS));
+        }
+    }
+    for (size_t i = 1; i < chunk_sizes.size(); ++i) {
+        spdlog::info("- CPU calling: using extra chunk size {}", chunk_sizes[i]);
+    }
+}
+
+}  // namespace
+
 std::pair<std::vector<basecall::RunnerPtr>, size_t> create_basecall_runners(
         const basecall::CRFModelConfig& model_config,
         const std::string& device,
@@ -27,10 +89,6 @@ std::pair<std::vector<basecall::RunnerPtr>, size_t> create_basecall_runners(
         float memory_fraction,
         PipelineType pipeline_type,
         float batch_size_time_penalty) {
-#ifdef __APPLE__
-    (void)pipeline_type;
-#endif
-
     std::vector<basecall::RunnerPtr> runners;
 
     // Default is 1 device.  CUDA path may alter this.
@@ -41,13 +99,26 @@ std::pair<std::vector<basecall::RunnerPtr>, size_t> create_basecall_runners(
         spdlog::warn("CPU basecalling is not supported on this platform. Results may be incorrect");
 #endif  // #ifdef DORADO_TX2
 
+        if (model_config.basecaller.batch_size() == 0) {
+            // Nothing was forced, so pick the batch size and threading by timing this host.
+            // Each runner's model keeps the process' torch thread count, so runners are what
+            // spread the model across the cores.
+            const auto settings = basecall::autotune_cpu_basecalling(
+                    model_config, memory_fraction, num_cpu_runners, NUM_CPU_INPUT_SLABS);
+            spdlog::info("- CPU calling: {}", settings.to_string());
+            auto tuned_config = model_config;
+            tuned_config.basecaller.set_batch_size(settings.batch_size);
+            add_cpu_runners(runners, tuned_config, get_cpu_chunk_sizes(tuned_config, pipeline_type),
+                            settings.num_runners, settings.decode_threads);
+            return {std::move(runners), num_devices};
+        }
+
         if (num_cpu_runners == 0) {
             num_cpu_runners = basecall::auto_calculate_num_runners(model_config, memory_fraction);
         }
         spdlog::debug("- CPU calling: set num_cpu_runners to {}", num_cpu_runners);
-        for (size_t i = 0; i < num_cpu_runners; i++) {
-            runners.push_back(std::make_unique<basecall::ModelRunner>(model_config, device));
-        }
+        add_cpu_runners(runners, model_config, get_cpu_chunk_sizes(model_config, pipeline_type),
+                        num_cpu_runners, 4);
         if (runners.back()->batch_size() != (size_t)model_config.basecaller.batch_size()) {
             spdlog::debug("- CPU calling: set batch_size to {}", runners.back()->batch_size());
         }
@@ -128,7 +199,8 @@ std::vector<modbase::RunnerPtr> create_modbase_runners(
     int remora_callers = 1;
     if (device == "cpu") {
         modbase_devices.push_back(device);
-        remora_batch_size = 128;
+        // Tuned for each model by the caller.
+        remora_batch_size = 0;
         remora_runners_per_caller = 1;
         remora_callers = std::thread::hardware_concurrency();
     }
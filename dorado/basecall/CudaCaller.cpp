@@ -235,17 +235,13 @@ void CudaCaller::determine_batch_dims(float memory_limit_fraction,
     // (adaptive sampling) we only want one (short) chunk size so that all those reads go into
     // the same queue and complete as fast as possible.
     if (m_pipeline_type == PipelineType::simplex) {
-        const char *env_extra_chunk_sizes = std::getenv("DORADO_EXTRA_CHUNK_SIZES");
-        if (env_extra_chunk_sizes != nullptr) {
-            constexpr char SEPARATOR = ';';
-            std::string env_string(env_extra_chunk_sizes);
-            for (size_t start = 0, end = 0; end != std::string::npos; start = end + 1) {
-                int T_out = (std::atoi(env_string.c_str() + start) / m_config.stride_inner()) *
-                            scale_factor;
+        const auto extra_chunk_sizes = get_extra_chunk_sizes();
+        if (!extra_chunk_sizes.empty()) {
+            for (int extra_chunk_size : extra_chunk_sizes) {
+                int T_out = (extra_chunk_size / m_config.stride_inner()) * scale_factor;
                 if (T_out > 0) {
                     m_batch_dims.push_back({granularity, T_out * m_config.stride, T_out});
                 }
-                end = env_string.find(SEPARATOR, start);
             }
         } else {
             // Use other chunk sizes as a fraction of the requested one
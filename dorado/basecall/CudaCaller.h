@@ -41,6 +41,7 @@ public:
     c10::Device device() const { return m_options.device(); }
     const CRFModelConfig &config() const { return m_config; }
     int batch_timeout_ms() const { return m_low_latency ? 100 : 60000; }
+    bool is_low_latency() const { return m_low_latency; }
 
     std::string get_name() const { return std::string("CudaCaller_") + m_device; }
 
@@ -33,6 +33,7 @@ const CRFModelConfig &CudaModelRunner::config() const { return m_caller->config(
 size_t CudaModelRunner::chunk_size() const { return m_input.size(2); }
 size_t CudaModelRunner::batch_size() const { return m_input.size(0); }
 int CudaModelRunner::batch_timeout_ms() const { return m_caller->batch_timeout_ms(); }
+bool CudaModelRunner::is_low_latency() const { return m_caller->is_low_latency(); }
 void CudaModelRunner::terminate() { m_caller->terminate(); }
 void CudaModelRunner::restart() { m_caller->restart(); }
 
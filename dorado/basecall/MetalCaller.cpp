@@ -217,7 +217,8 @@ MetalLSTMCaller::MetalLSTMCaller(const CRFModelConfig &model_config, float memor
     constexpr int n_base = 4;
     m_states = pow(n_base, model_config.state_len);
 
-    auto state_dict = load_crf_model_weights(model_config);
+    // The Metal model converts the float weights as it lays them out for its kernels.
+    auto state_dict = load_crf_model_weights(model_config, torch::kFloat32);
 
     assert(model_config.has_normalised_basecaller_params());
     const auto chunk_size = model_config.basecaller.chunk_size();
@@ -524,7 +525,7 @@ void MetalTxCaller::load_tx_model(const CRFModelConfig &model_config) {
 
     m_model = nn::TxModel(model_config, options);
 
-    auto state_dict = load_crf_model_weights(model_config);
+    auto state_dict = load_crf_model_weights(model_config, scalar_type);
     m_model->load_state_dict(state_dict);
     m_model->to(options.dtype().toScalarType());
     m_model->to(options.device());
@@ -3,19 +3,44 @@
 #include "crf_utils.h"
 #include "decode/Decoder.h"
 #include "nn/CRFModel.h"
+#include "utils/dev_utils.h"
+
+#include <algorithm>
 
 namespace dorado::basecall {
 
-ModelRunner::ModelRunner(const CRFModelConfig &model_config, const std::string &device)
+ModelRunner::ModelRunner(const CRFModelConfig &model_config,
+                         const std::string &device,
+                         int num_decode_threads,
+                         size_t num_input_slabs)
+        : ModelRunner(model_config,
+                      device,
+                      torch::nn::ModuleHolder<torch::nn::AnyModule>(nullptr),
+                      num_decode_threads,
+                      num_input_slabs) {}
+
+ModelRunner::ModelRunner(const CRFModelConfig &model_config,
+                         const std::string &device,
+                         torch::nn::ModuleHolder<torch::nn::AnyModule> module,
+                         int num_decode_threads,
+                         size_t num_input_slabs)
         : m_config(model_config),
           m_decoder(decode::create_decoder(device, model_config)),
           // TODO: m_options.dtype() depends on the device as TxModel uses kHalf in cuda which is not supported on CPU
           m_options(at::TensorOptions().dtype(m_decoder->dtype()).device(device)),
-          m_module(load_crf_model(model_config, m_options)) {
+          m_module(module.is_empty() ? load_crf_model(model_config, m_options) : std::move(module)),
+          m_forward_queue(num_input_slabs),
+          m_decode_queue(num_input_slabs) {
     assert(model_config.has_normalised_basecaller_params());
 
     m_decoder_options.q_shift = model_config.qbias;
     m_decoder_options.q_scale = model_config.qscale;
+    m_decoder_options.num_cpu_threads = num_decode_threads;
+    m_decoder_options.adaptive_beam = utils::get_dev_opt<bool>("adaptive_beam", false);
+    m_decoder_options.min_beam_width =
+            utils::get_dev_opt<size_t>("min_beam_width", m_decoder_options.min_beam_width);
+    m_decoder_options.adaptive_beam_margin = utils::get_dev_opt<float>(
+            "adaptive_beam_margin", m_decoder_options.adaptive_beam_margin);
 
     // Should have set batch_size to non-zero value if device == cpu
     assert(model_config.basecaller.batch_size() > 0);
@@ -23,27 +48,135 @@ ModelRunner::ModelRunner(const CRFModelConfig &model_config, const std::string &
     const auto C = model_config.num_features;
     const auto T = model_config.basecaller.chunk_size();
 
-    m_input_NCT =
-            at::zeros({N, C, T}, at::TensorOptions().dtype(m_decoder->dtype()).device(at::kCPU));
+    for (size_t i = 0; i < std::max(num_input_slabs, size_t(1)); ++i) {
+        m_input_slabs.push_back(at::zeros(
+                {N, C, T}, at::TensorOptions().dtype(m_decoder->dtype()).device(at::kCPU)));
+    }
+
+    m_slab_in_use.resize(m_input_slabs.size(), false);
+
+    if (m_input_slabs.size() > 1) {
+        m_last_activity_change = std::chrono::steady_clock::now();
+        m_forward_thread = std::thread([this] { forward_thread_fn(); });
+        m_decode_thread = std::thread([this] { decode_thread_fn(); });
+    }
 }
 
-std::vector<decode::DecodedChunk> ModelRunner::call_chunks(int num_chunks) {
-    at::InferenceMode guard;
+ModelRunner::~ModelRunner() {
+    m_forward_queue.terminate();
+    if (m_forward_thread.joinable()) {
+        m_forward_thread.join();
+    }
+    m_decode_queue.terminate();
+    if (m_decode_thread.joinable()) {
+        m_decode_thread.join();
+    }
+}
+
+at::Tensor ModelRunner::run_forward(size_t slab_idx) {
+    dorado::stats::Timer timer;
+    update_activity(1, 0);
+    auto scores_TNC = m_module->forward(m_input_slabs[slab_idx].to(m_options.device()))
+                              .transpose(0, 1)
+                              .contiguous();
+    update_activity(-1, 0);
+    m_model_ms += timer.GetElapsedMS();
+    return scores_TNC;
+}
+
+std::vector<decode::DecodedChunk> ModelRunner::run_decode(const at::Tensor &scores_TNC,
+                                                          int num_chunks) {
     dorado::stats::Timer timer;
-    auto scores_TNC =
-            m_module->forward(m_input_NCT.to(m_options.device())).transpose(0, 1).contiguous();
-    const auto forward_ms = timer.GetElapsedMS();
+    update_activity(0, 1);
     auto decoded_chunks = m_decoder->beam_search_part_2(
             m_decoder->beam_search_part_1({scores_TNC, num_chunks, m_decoder_options}));
-    const auto forward_plus_decode_ms = timer.GetElapsedMS();
+    update_activity(0, -1);
+    m_decode_ms += timer.GetElapsedMS();
     ++m_num_batches_called;
-    m_model_ms += forward_ms;
-    m_decode_ms += forward_plus_decode_ms - forward_ms;
     return decoded_chunks;
 }
 
+std::vector<decode::DecodedChunk> ModelRunner::call_chunks(int num_chunks) {
+    if (m_input_slabs.size() > 1) {
+        return call_chunks_async(num_chunks).get();
+    }
+    at::InferenceMode guard;
+    return run_decode(run_forward(0), num_chunks);
+}
+
+std::future<std::vector<decode::DecodedChunk>> ModelRunner::call_chunks_async(int num_chunks) {
+    if (m_input_slabs.size() == 1) {
+        return ModelRunnerBase::call_chunks_async(num_chunks);
+    }
+    auto batch = std::make_unique<Batch>();
+    batch->slab_idx = m_staging_slab_idx;
+    batch->num_chunks = num_chunks;
+    auto results = batch->results.get_future();
+    {
+        std::lock_guard lock(m_slab_mutex);
+        m_slab_in_use[m_staging_slab_idx] = true;
+    }
+    m_forward_queue.try_push(std::move(batch));
+    m_staging_slab_idx = (m_staging_slab_idx + 1) % m_input_slabs.size();
+    m_staging_slab_free = false;
+    return results;
+}
+
+void ModelRunner::forward_thread_fn() {
+    at::InferenceMode guard;
+    std::unique_ptr<Batch> batch;
+    while (m_forward_queue.try_pop(batch) == utils::AsyncQueueStatus::Success) {
+        try {
+            batch->scores_TNC = run_forward(batch->slab_idx);
+        } catch (...) {
+            batch->results.set_exception(std::current_exception());
+            release_slab(batch->slab_idx);
+            continue;
+        }
+        m_decode_queue.try_push(std::move(batch));
+    }
+}
+
+void ModelRunner::decode_thread_fn() {
+    at::InferenceMode guard;
+    std::unique_ptr<Batch> batch;
+    while (m_decode_queue.try_pop(batch) == utils::AsyncQueueStatus::Success) {
+        try {
+            batch->results.set_value(run_decode(batch->scores_TNC, batch->num_chunks));
+        } catch (...) {
+            batch->results.set_exception(std::current_exception());
+        }
+        // The results are ready before the slab can be reused.
+        release_slab(batch->slab_idx);
+    }
+}
+
+void ModelRunner::release_slab(size_t slab_idx) {
+    {
+        std::lock_guard lock(m_slab_mutex);
+        m_slab_in_use[slab_idx] = false;
+    }
+    m_slab_released.notify_all();
+}
+
+void ModelRunner::update_activity(int forward_delta, int decode_delta) {
+    std::lock_guard lock(m_activity_mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (m_num_forwards_running > 0 && m_num_decodes_running > 0) {
+        m_overlap_time += now - m_last_activity_change;
+    }
+    m_last_activity_change = now;
+    m_num_forwards_running += forward_delta;
+    m_num_decodes_running += decode_delta;
+}
+
 void ModelRunner::accept_chunk(int chunk_idx, const at::Tensor &chunk_CT) {
-    m_input_NCT.index_put_({chunk_idx, at::indexing::Ellipsis}, chunk_CT);
+    if (!m_staging_slab_free) {
+        std::unique_lock lock(m_slab_mutex);
+        m_slab_released.wait(lock, [this] { return !m_slab_in_use[m_staging_slab_idx]; });
+        m_staging_slab_free = true;
+    }
+    m_input_slabs[m_staging_slab_idx].index_put_({chunk_idx, at::indexing::Ellipsis}, chunk_CT);
 }
 
 stats::NamedStats ModelRunner::sample_stats() const {
@@ -51,6 +184,15 @@ stats::NamedStats ModelRunner::sample_stats() const {
     stats["batches_called"] = double(m_num_batches_called);
     stats["model_ms"] = double(m_model_ms);
     stats["decode_ms"] = double(m_decode_ms);
+    if (m_input_slabs.size() > 1) {
+        std::lock_guard lock(m_activity_mutex);
+        const auto overlap_ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(m_overlap_time).count();
+        stats["forward_decode_overlap_ms"] = double(overlap_ms);
+        // Fraction of the decode time which was hidden behind forward calls.
+        stats["forward_decode_overlap_ratio"] =
+                m_decode_ms > 0 ? double(overlap_ms) / double(m_decode_ms) : 0.0;
+    }
     return stats;
 }
 
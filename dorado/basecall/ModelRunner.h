@@ -3,40 +3,99 @@
 #include "CRFModelConfig.h"
 #include "ModelRunnerBase.h"
 #include "decode/Decoder.h"
+#include "utils/AsyncQueue.h"
 #include "utils/stats.h"
 
 #include <torch/nn.h>
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace dorado::basecall {
 
 class ModelRunner final : public ModelRunnerBase {
 public:
-    ModelRunner(const CRFModelConfig &model_config, const std::string &device);
+    // With more than one input slab, batches are called by a pipeline of a forward thread and a
+    // decode thread, so that the next batch can be staged while the model runs on this one and the
+    // previous one is decoded. Accepting chunks into a slab whose batch hasn't been decoded yet
+    // waits until it has.
+    ModelRunner(const CRFModelConfig &model_config,
+                const std::string &device,
+                int num_decode_threads = 4,
+                size_t num_input_slabs = 1);
+    // As above, but running |module|, which was loaded for model_config on device, so that several
+    // runners can share one instance of the model.
+    ModelRunner(const CRFModelConfig &model_config,
+                const std::string &device,
+                torch::nn::ModuleHolder<torch::nn::AnyModule> module,
+                int num_decode_threads,
+                size_t num_input_slabs);
+    ~ModelRunner();
     void accept_chunk(int chunk_idx, const at::Tensor &chunk) final;
     std::vector<decode::DecodedChunk> call_chunks(int num_chunks) final;
+    std::future<std::vector<decode::DecodedChunk>> call_chunks_async(int num_chunks) final;
+    size_t num_input_slabs() const final { return m_input_slabs.size(); }
     const CRFModelConfig &config() const final { return m_config; };
-    size_t chunk_size() const final { return m_input_NCT.size(2); }
-    size_t batch_size() const final { return m_input_NCT.size(0); }
+    size_t chunk_size() const final { return m_input_slabs.front().size(2); }
+    size_t batch_size() const final { return m_input_slabs.front().size(0); }
     void terminate() final {}
     void restart() final {}
     std::string get_name() const final { return "ModelRunner"; }
     stats::NamedStats sample_stats() const final;
 
 private:
+    struct Batch {
+        size_t slab_idx;
+        int num_chunks;
+        at::Tensor scores_TNC;
+        std::promise<std::vector<decode::DecodedChunk>> results;
+    };
+
+    at::Tensor run_forward(size_t slab_idx);
+    std::vector<decode::DecodedChunk> run_decode(const at::Tensor &scores_TNC, int num_chunks);
+    void forward_thread_fn();
+    void decode_thread_fn();
+    // Tracks how many forward and decode calls are running, to measure how much they overlap.
+    void update_activity(int forward_delta, int decode_delta);
+    void release_slab(size_t slab_idx);
+
     const CRFModelConfig m_config;
     std::unique_ptr<decode::Decoder> m_decoder;
     at::TensorOptions m_options;
     decode::DecoderOptions m_decoder_options;
     torch::nn::ModuleHolder<torch::nn::AnyModule> m_module{nullptr};
-    at::Tensor m_input_NCT;
+    std::vector<at::Tensor> m_input_slabs;
+    // Slab which accept_chunk writes to.
+    size_t m_staging_slab_idx = 0;
+    // Whether the staging slab is known to be free, so accept_chunk needn't check.
+    bool m_staging_slab_free = true;
+    // Whether each slab holds a batch which hasn't been decoded yet.
+    std::vector<bool> m_slab_in_use;
+    std::mutex m_slab_mutex;
+    std::condition_variable m_slab_released;
+
+    utils::AsyncQueue<std::unique_ptr<Batch>> m_forward_queue;
+    utils::AsyncQueue<std::unique_ptr<Batch>> m_decode_queue;
+    std::thread m_forward_thread;
+    std::thread m_decode_thread;
 
     // Performance monitoring stats.
     std::atomic<int64_t> m_num_batches_called = 0;
     std::atomic<int64_t> m_model_ms = 0;
     std::atomic<int64_t> m_decode_ms = 0;
+
+    mutable std::mutex m_activity_mutex;
+    int m_num_forwards_running = 0;
+    int m_num_decodes_running = 0;
+    std::chrono::steady_clock::time_point m_last_activity_change;
+    // Time during which a forward and a decode were running at the same time.
+    std::chrono::steady_clock::duration m_overlap_time{};
 };
 
 }  // namespace dorado::basecall
@@ -3,6 +3,7 @@
 #include "decode/Decoder.h"
 #include "utils/stats.h"
 
+#include <future>
 #include <string>
 #include <vector>
 
@@ -20,11 +21,22 @@ public:
     virtual ~ModelRunnerBase() = default;
     virtual void accept_chunk(int chunk_idx, const at::Tensor &chunk) = 0;
     virtual std::vector<decode::DecodedChunk> call_chunks(int num_chunks) = 0;
+    // Starts calling the accepted chunks and returns their results asynchronously. Runners with
+    // more than one input slab can accept the chunks of the next batch while this one is called,
+    // as long as no more than num_input_slabs() batches are outstanding.
+    virtual std::future<std::vector<decode::DecodedChunk>> call_chunks_async(int num_chunks) {
+        std::promise<std::vector<decode::DecodedChunk>> results;
+        results.set_value(call_chunks(num_chunks));
+        return results.get_future();
+    }
+    virtual size_t num_input_slabs() const { return 1; }
     virtual const CRFModelConfig &config() const = 0;
     virtual size_t chunk_size() const = 0;
     virtual size_t batch_size() const = 0;
     // Timeout is short for simplex, longer for duplex which gets a subset of reads
     virtual int batch_timeout_ms() const { return is_duplex_model(config()) ? 5000 : 100; }
+    // Whether the runner is set up for the simplex_low_latency pipeline.
+    virtual bool is_low_latency() const { return false; }
     virtual void terminate() = 0;
     virtual void restart() = 0;
     virtual std::string get_name() const = 0;
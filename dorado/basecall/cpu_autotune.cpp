@@ -0,0 +1,313 @@
+#include "cpu_autotune.h"
+
+#include "CRFModelConfig.h"
+#include "ModelRunner.h"
+#include "crf_utils.h"
+#include "decode/Decoder.h"
+#include "utils/fs_utils.h"
+#include "utils/weight_cache.h"
+
+#include <ATen/Functions.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace dorado::basecall {
+
+namespace {
+
+// Chunk size used when timing. Throughput per sample is close to constant with chunk size for
+// the CPU models, so timing shorter chunks keeps the autotune pass quick.
+constexpr int TUNING_CHUNK_SIZE = 2000;
+// Timed batches per runner for each candidate, after one untimed batch.
+constexpr int TUNING_BATCHES = 3;
+// Larger batches than this are never tried, so a cached one is from a corrupt file.
+constexpr int MAX_BATCH_SIZE = 4096;
+
+std::string host_name() {
+#ifdef _WIN32
+    const char *name = std::getenv("COMPUTERNAME");
+    return name ? name : "";
+#else
+    char name[256] = {};
+    gethostname(name, sizeof(name) - 1);
+    return name;
+#endif
+}
+
+int host_num_threads() { return std::max(1, int(std::thread::hardware_concurrency())); }
+
+// Where the settings for this setup are cached, if the user has a cache directory.
+std::optional<std::filesystem::path> cache_path(const CRFModelConfig &model_config,
+                                                size_t num_runners,
+                                                size_t num_input_slabs) {
+    const auto cache_dir = utils::get_user_cache_dir("cpu_autotune");
+    if (!cache_dir) {
+        return std::nullopt;
+    }
+
+    // Key on the model and its contents, the chunk size, how the runners are set up and the host.
+    const auto model_path = std::filesystem::canonical(model_config.model_path);
+    std::ostringstream key;
+    key << model_path.string() << ';' << utils::directory_fingerprint(model_path) << ';'
+        << model_config.basecaller.chunk_size() << ';' << num_runners << ';' << num_input_slabs
+        << ';' << host_name() << ';' << host_num_threads();
+    return *cache_dir / (utils::cache_file_stem(model_path, key.str()) + ".txt");
+}
+
+// Runs all the runners concurrently on synthetic input, returning samples per second. The runners
+// share |module|, so the model is only loaded once for all the candidates.
+double measure_throughput(const CRFModelConfig &config,
+                          const torch::nn::ModuleHolder<torch::nn::AnyModule> &module,
+                          const CPUBasecallSettings &settings,
+                          size_t num_input_slabs) {
+    std::vector<std::unique_ptr<ModelRunner>> runners;
+    for (size_t i = 0; i < settings.num_runners; ++i) {
+        runners.push_back(std::make_unique<ModelRunner>(config, "cpu", module,
+                                                        settings.decode_threads, num_input_slabs));
+    }
+    const auto chunk =
+            at::randn({config.num_features, int64_t(runners.front()->chunk_size())}, at::kFloat);
+
+    // Each runner is driven the way BasecallerNode drives it, staging the next batch while up to
+    // num_input_slabs - 1 earlier batches are called.
+    auto run_batches = [&](int num_batches) {
+        std::vector<std::thread> threads;
+        for (auto &runner : runners) {
+            threads.emplace_back([&runner, &chunk, num_batches, num_input_slabs,
+                                  batch_size = settings.batch_size] {
+                at::InferenceMode inference_mode_guard;
+                std::deque<std::future<std::vector<decode::DecodedChunk>>> in_flight;
+                for (int i = 0; i < num_batches; ++i) {
+                    for (int j = 0; j < batch_size; ++j) {
+                        runner->accept_chunk(j, chunk);
+                    }
+                    in_flight.push_back(runner->call_chunks_async(batch_size));
+                    while (in_flight.size() >= num_input_slabs) {
+                        in_flight.front().get();
+                        in_flight.pop_front();
+                    }
+                }
+                for (auto &results : in_flight) {
+                    results.get();
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    };
+
+    // The first batch includes one-off setup costs.
+    run_batches(1);
+    const auto start = std::chrono::steady_clock::now();
+    run_batches(TUNING_BATCHES);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double num_samples = double(settings.num_runners) * TUNING_BATCHES *
+                               settings.batch_size * runners.front()->chunk_size();
+    return num_samples / elapsed.count();
+}
+
+}  // namespace
+
+std::string CPUBasecallSettings::to_string() const {
+    std::ostringstream str;
+    str << "batch_size:" << batch_size << " num_runners:" << num_runners
+        << " decode_threads:" << decode_threads;
+    return str.str();
+}
+
+namespace details {
+
+bool is_valid(const CPUBasecallSettings &settings, int num_threads, size_t num_runners) {
+    const bool runners_ok = num_runners > 0 ? settings.num_runners == num_runners
+                                            : settings.num_runners > 0 &&
+                                                      settings.num_runners <= size_t(num_threads);
+    return runners_ok && settings.batch_size > 0 && settings.batch_size <= MAX_BATCH_SIZE &&
+           settings.decode_threads > 0 &&
+           settings.decode_threads <= std::min(num_threads, settings.batch_size);
+}
+
+std::optional<CPUBasecallSettings> load_cpu_basecall_settings(const std::filesystem::path &path,
+                                                              int num_threads,
+                                                              size_t num_runners) {
+    std::ifstream file(path);
+    if (!file) {
+        return std::nullopt;
+    }
+    // Read signed values, so that negative ones are caught rather than wrapped.
+    int64_t batch_size = 0, cached_num_runners = 0, decode_threads = 0;
+    if (file >> batch_size >> cached_num_runners >> decode_threads && batch_size > 0 &&
+        cached_num_runners > 0 && decode_threads > 0 && batch_size <= MAX_BATCH_SIZE &&
+        decode_threads <= num_threads) {
+        const CPUBasecallSettings settings{int(batch_size), size_t(cached_num_runners),
+                                           int(decode_threads)};
+        if (is_valid(settings, num_threads, num_runners)) {
+            return settings;
+        }
+    }
+    spdlog::debug("Ignoring invalid CPU autotune cache {}", path.string());
+    return std::nullopt;
+}
+
+void save_cpu_basecall_settings(const std::filesystem::path &path,
+                                const CPUBasecallSettings &settings) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::ofstream file(path);
+    file << settings.batch_size << ' ' << settings.num_runners << ' ' << settings.decode_threads
+         << '\n';
+    if (!file) {
+        spdlog::debug("Failed to write CPU autotune cache {}", path.string());
+    }
+}
+
+CPUBasecallSettings select_cpu_basecall_settings(
+        const std::vector<int> &batch_sizes,
+        const std::function<size_t(int)> &max_num_runners,
+        size_t num_runners,
+        int num_threads,
+        const std::function<double(const CPUBasecallSettings &)> &measure_throughput) {
+    auto make_settings = [num_threads](int batch_size, size_t runners) {
+        CPUBasecallSettings settings{};
+        settings.batch_size = batch_size;
+        settings.num_runners = runners;
+        settings.decode_threads = std::clamp(num_threads / int(runners), 1, batch_size);
+        return settings;
+    };
+    if (batch_sizes.empty()) {
+        return make_settings(128, std::max(num_runners, size_t(1)));
+    }
+
+    CPUBasecallSettings best{};
+    double best_throughput = -1;
+    // Measures a candidate, returning its throughput and keeping it if it's the best so far.
+    auto try_settings = [&](int batch_size, size_t runners) {
+        const auto settings = make_settings(batch_size, runners);
+        const double throughput = measure_throughput(settings);
+        if (throughput > best_throughput) {
+            best_throughput = throughput;
+            best = settings;
+        }
+        return throughput;
+    };
+
+    // Coarse pass: pick the runner count at the middle batch size, doubling the runners until the
+    // throughput drops, since more runners than that only compete for the same cores.
+    const size_t mid_idx = batch_sizes.size() / 2;
+    const int mid_batch_size = batch_sizes[mid_idx];
+    const size_t min_runners = num_runners > 0 ? num_runners : 1;
+    const size_t max_runners = num_runners > 0 ? num_runners : max_num_runners(mid_batch_size);
+    double prev_throughput = 0;
+    for (size_t runners = min_runners; runners <= max_runners; runners *= 2) {
+        const double throughput = try_settings(mid_batch_size, runners);
+        if (throughput < prev_throughput) {
+            break;
+        }
+        prev_throughput = throughput;
+    }
+    const double mid_throughput = best_throughput;
+    const size_t best_runners = best.num_runners;
+
+    // Fine pass: with that runner count, try larger and then smaller batch sizes, stopping in each
+    // direction as soon as the throughput doesn't improve. Runner counts which are too many for a
+    // batch size are reduced to its limit.
+    auto runners_for = [&](int batch_size) {
+        return num_runners > 0 ? num_runners
+                               : std::max(size_t(1),
+                                          std::min(best_runners, max_num_runners(batch_size)));
+    };
+    bool larger_improved = false;
+    prev_throughput = mid_throughput;
+    for (size_t i = mid_idx + 1; i < batch_sizes.size(); ++i) {
+        const double throughput = try_settings(batch_sizes[i], runners_for(batch_sizes[i]));
+        if (throughput <= prev_throughput) {
+            break;
+        }
+        larger_improved = true;
+        prev_throughput = throughput;
+    }
+    if (!larger_improved) {
+        prev_throughput = mid_throughput;
+        for (size_t i = mid_idx; i-- > 0;) {
+            const double throughput = try_settings(batch_sizes[i], runners_for(batch_sizes[i]));
+            if (throughput <= prev_throughput) {
+                break;
+            }
+            prev_throughput = throughput;
+        }
+    }
+    return best;
+}
+
+}  // namespace details
+
+CPUBasecallSettings autotune_cpu_basecalling(const CRFModelConfig &model_config,
+                                             float memory_fraction,
+                                             size_t num_runners,
+                                             size_t num_input_slabs) {
+    const int num_threads = host_num_threads();
+    const auto path = cache_path(model_config, num_runners, num_input_slabs);
+    if (path) {
+        if (auto settings = details::load_cpu_basecall_settings(*path, num_threads, num_runners)) {
+            spdlog::debug("- CPU calling: using cached settings from {}", path->string());
+            return *settings;
+        }
+    }
+
+    spdlog::info(
+            "> Tuning CPU basecalling settings for this model and host, which is only done once");
+    const auto tuning_start = std::chrono::steady_clock::now();
+    CRFModelConfig tuning_config = model_config;
+    tuning_config.basecaller.set_chunk_size(
+            std::min(model_config.basecaller.chunk_size(), TUNING_CHUNK_SIZE));
+    tuning_config.normalise_basecaller_params();
+
+    auto max_num_runners = [&](int batch_size) {
+        CRFModelConfig batch_config = model_config;
+        batch_config.basecaller.set_batch_size(batch_size);
+        return auto_calculate_num_runners(batch_config, memory_fraction);
+    };
+    // The CPU model doesn't depend on the batch size, so one instance serves every candidate.
+    const auto dtype = decode::create_decoder(c10::Device(c10::kCPU), tuning_config)->dtype();
+    const auto module =
+            load_crf_model(tuning_config, at::TensorOptions().dtype(dtype).device(at::kCPU));
+    int num_measured = 0;
+    auto measure = [&](const CPUBasecallSettings &settings) {
+        tuning_config.basecaller.set_batch_size(settings.batch_size);
+        const double throughput =
+                measure_throughput(tuning_config, module, settings, num_input_slabs);
+        const std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - tuning_start;
+        spdlog::info("- CPU calling: candidate {} ({}) -> {:.3e} samples/s, {:.1f}s elapsed",
+                     ++num_measured, settings.to_string(), throughput, elapsed.count());
+        return throughput;
+    };
+    const auto best = details::select_cpu_basecall_settings({64, 128, 256}, max_num_runners,
+                                                            num_runners, num_threads, measure);
+
+    if (path) {
+        details::save_cpu_basecall_settings(*path, best);
+    }
+    return best;
+}
+
+}  // namespace dorado::basecall
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dorado::basecall {
+
+struct CRFModelConfig;
+
+// Settings for CPU basecalling chosen by autotune_cpu_basecalling.
+struct CPUBasecallSettings {
+    int batch_size;
+    size_t num_runners;
+    // Threads used by each runner's decoder.
+    int decode_threads;
+
+    std::string to_string() const;
+};
+
+namespace details {
+// Exposed for testability.
+// Whether settings could have been chosen by autotune on a host with num_threads threads, for
+// num_runners runners if that is non-zero.
+bool is_valid(const CPUBasecallSettings &settings, int num_threads, size_t num_runners);
+
+// Reads settings saved by save_cpu_basecall_settings, or nullopt if the file is missing,
+// malformed or holds settings for which is_valid fails.
+std::optional<CPUBasecallSettings> load_cpu_basecall_settings(const std::filesystem::path &path,
+                                                              int num_threads,
+                                                              size_t num_runners);
+void save_cpu_basecall_settings(const std::filesystem::path &path,
+                                const CPUBasecallSettings &settings);
+
+// Measures candidates with measure_throughput and returns the one with the most samples per
+// second, searching coarse to fine so that few candidates are timed. First, at the middle of
+// batch_sizes (which are ascending), runner counts are doubled from 1 up to
+// max_num_runners(batch_size) until the throughput drops, unless num_runners is non-zero, in which
+// case only that many runners are tried. Then, with the best runner count, larger batch sizes are
+// tried until the throughput stops improving, and if the first of those didn't improve it,
+// smaller ones likewise. The num_threads threads are split evenly between the runners' decoders.
+CPUBasecallSettings select_cpu_basecall_settings(
+        const std::vector<int> &batch_sizes,
+        const std::function<size_t(int)> &max_num_runners,
+        size_t num_runners,
+        int num_threads,
+        const std::function<double(const CPUBasecallSettings &)> &measure_throughput);
+}  // namespace details
+
+// Times a few synthetic batches of model_config on the CPU for candidate batch sizes and runner
+// counts, and returns the settings with the best throughput. Progress is logged for each
+// candidate, since tuning large models takes a while. Runners are timed the way they're
+// called, with num_input_slabs batches in flight. If num_runners is non-zero it is kept, and only
+// the batch size and decode threads are tuned for it.
+// The number of runners tried is limited by auto_calculate_num_runners for each batch size.
+// The result is cached per model, runner count and host in the user's cache directory, so only the
+// first call for a given model does any work.
+CPUBasecallSettings autotune_cpu_basecalling(const CRFModelConfig &model_config,
+                                             float memory_fraction,
+                                             size_t num_runners,
+                                             size_t num_input_slabs);
+
+}  // namespace dorado::basecall
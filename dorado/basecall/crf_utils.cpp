@@ -4,9 +4,15 @@
 #include "nn/CRFModel.h"
 #include "nn/TxModel.h"
 #include "utils/memory_utils.h"
+#include "utils/module_utils.h"
 #include "utils/tensor_utils.h"
+#include "utils/weight_cache.h"
+
+#include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <cstdlib>
+#include <sstream>
 #include <thread>
 
 using namespace torch::nn;
@@ -246,11 +252,54 @@ std::vector<at::Tensor> load_crf_model_weights(const CRFModelConfig &model_confi
                                    model_config.bias);
 }
 
+std::vector<at::Tensor> load_crf_model_weights(const CRFModelConfig &model_config,
+                                               at::ScalarType dtype) {
+    auto convert = [dtype](std::vector<at::Tensor> weights) {
+        for (auto &weight : weights) {
+            if (weight.is_floating_point()) {
+                weight = weight.to(dtype).contiguous();
+            }
+        }
+        return weights;
+    };
+
+    const char *cache_dir = std::getenv("DORADO_WEIGHT_CACHE_DIR");
+    if (cache_dir == nullptr || *cache_dir == '\0') {
+        return convert(load_crf_model_weights(model_config));
+    }
+
+    // The cache file is specific to the model path and dtype, and is rewritten if the contents of
+    // the model directory change.
+    const auto model_path = std::filesystem::canonical(model_config.model_path);
+    const std::string dtype_name = c10::toString(dtype);
+    const auto fingerprint = utils::directory_fingerprint(model_path) + dtype_name;
+    // Keying the name on the full path keeps models with the same directory name apart.
+    const auto cache_name =
+            utils::cache_file_stem(model_path, model_path.string()) + '_' + dtype_name + ".weights";
+    const auto cache_path = std::filesystem::path(cache_dir) / cache_name;
+
+    if (auto cached_weights = utils::load_weight_cache(cache_path, fingerprint)) {
+        spdlog::debug("Loaded model weights from cache {}", cache_path.string());
+        return std::move(*cached_weights);
+    }
+
+    auto weights = convert(load_crf_model_weights(model_config));
+    try {
+        utils::save_weight_cache(cache_path, fingerprint, weights);
+        spdlog::debug("Wrote model weights to cache {}", cache_path.string());
+    } catch (const std::exception &e) {
+        spdlog::warn("Failed to write model weight cache: {}", e.what());
+    }
+    return weights;
+}
+
 ModuleHolder<AnyModule> load_lstm_model(const CRFModelConfig &model_config,
                                         const at::TensorOptions &options) {
     auto model = nn::CRFModel(model_config);
-    auto state_dict = load_crf_model_weights(model_config);
-    model->load_state_dict(state_dict);
+    auto state_dict = load_crf_model_weights(model_config, options.dtype().toScalarType());
+    // Cached weights are already in the runtime dtype, so on the CPU the parameters are used in
+    // place from the mapped cache file rather than being copied out of it.
+    utils::share_state_dict(*model, state_dict);
     model->to(options.dtype().toScalarType());
     model->to(options.device());
     model->eval();
@@ -263,8 +312,8 @@ ModuleHolder<AnyModule> load_lstm_model(const CRFModelConfig &model_config,
 ModuleHolder<AnyModule> load_tx_model(const CRFModelConfig &model_config,
                                       const at::TensorOptions &options) {
     auto model = nn::TxModel(model_config, options);
-    auto state_dict = load_crf_model_weights(model_config);
-    model->load_state_dict(state_dict);
+    auto state_dict = load_crf_model_weights(model_config, options.dtype().toScalarType());
+    utils::share_state_dict(*model, state_dict);
     model->to(options.dtype().toScalarType());
     model->to(options.device());
     model->eval();
@@ -282,6 +331,24 @@ ModuleHolder<AnyModule> load_crf_model(const CRFModelConfig &model_config,
     return load_lstm_model(model_config, options);
 }
 
+std::vector<int> get_extra_chunk_sizes() {
+    const char *env_extra_chunk_sizes = std::getenv("DORADO_EXTRA_CHUNK_SIZES");
+    if (env_extra_chunk_sizes == nullptr) {
+        return {};
+    }
+    constexpr char SEPARATOR = ';';
+    std::vector<int> chunk_sizes;
+    std::string env_string(env_extra_chunk_sizes);
+    for (size_t start = 0, end = 0; end != std::string::npos; start = end + 1) {
+        const int chunk_size = std::atoi(env_string.c_str() + start);
+        if (chunk_size > 0) {
+            chunk_sizes.push_back(chunk_size);
+        }
+        end = env_string.find(SEPARATOR, start);
+    }
+    return chunk_sizes;
+}
+
 size_t auto_calculate_num_runners(const CRFModelConfig &model_config, float memory_fraction) {
     auto model_name = std::filesystem::canonical(model_config.model_path).filename().string();
 
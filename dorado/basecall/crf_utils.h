@@ -11,9 +11,20 @@ struct CRFModelConfig;
 
 std::vector<at::Tensor> load_crf_model_weights(const CRFModelConfig& model_config);
 
+// As above, with floating point weights converted to dtype. If DORADO_WEIGHT_CACHE_DIR is set,
+// the converted weights are written there as a single file after the first load, and later loads
+// map that file instead of deserialising each weight.
+std::vector<at::Tensor> load_crf_model_weights(const CRFModelConfig& model_config,
+                                               at::ScalarType dtype);
+
 torch::nn::ModuleHolder<torch::nn::AnyModule> load_crf_model(const CRFModelConfig& model_config,
                                                              const torch::TensorOptions& options);
 
+// Chunk sizes, in samples, given as a ';' separated list by DORADO_EXTRA_CHUNK_SIZES, which
+// simplex basecalling uses alongside the model's chunk size for short reads and read tails.
+// Values which aren't positive are skipped.
+std::vector<int> get_extra_chunk_sizes();
+
 size_t auto_calculate_num_runners(const CRFModelConfig& model_config, float memory_fraction);
 
 }  // namespace dorado::basecall
@@ -8,6 +8,7 @@
 #include <math.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <vector>
 
 namespace {
@@ -101,7 +102,7 @@ std::vector<DecodedChunk> CPUDecoder::beam_search_part_2(DecodeData data) const
     const auto scores_cpu = data.data.to(at::kCPU);
     const auto num_chunks = data.num_chunks;
     const auto& options = data.options;
-    int num_threads = std::min(num_chunks, 4);
+    int num_threads = std::clamp(options.num_cpu_threads, 1, std::max(num_chunks, 1));
     int chunks_per_thread = num_chunks / num_threads;
     int num_threads_with_one_more_chunk = num_chunks % num_threads;
 
@@ -134,10 +135,11 @@ std::vector<DecodedChunk> CPUDecoder::beam_search_part_2(DecodeData data) const
 
             // Iter over n in nTC, passing TC tensors to beam_search_decode
             for (int chunk_idx = 0; chunk_idx < t_num_chunks; chunk_idx++) {
-                auto decode_result = beam_search_decode(t_scores[chunk_idx], bwd[chunk_idx],
-                                                        posts[chunk_idx], options.beam_width,
-                                                        options.beam_cut, options.blank_score,
-                                                        options.q_shift, options.q_scale, 1.0f);
+                auto decode_result = beam_search_decode(
+                        t_scores[chunk_idx], bwd[chunk_idx], posts[chunk_idx], options.beam_width,
+                        options.beam_cut, options.blank_score, options.q_shift, options.q_scale,
+                        1.0f, options.adaptive_beam ? options.min_beam_width : 0,
+                        options.adaptive_beam_margin);
                 chunk_results[t_first_chunk + chunk_idx] = DecodedChunk{
                         std::get<0>(decode_result),
                         std::get<1>(decode_result),
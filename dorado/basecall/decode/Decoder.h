@@ -21,12 +21,20 @@ struct DecodedChunk {
 
 struct DecoderOptions {
     size_t beam_width = 32;
+    // With adaptive_beam, the CPU decoder narrows the beam towards min_beam_width in blocks where
+    // the posterior strongly favours one path, halving it for each adaptive_beam_margin of score
+    // between the best and second best candidates.
+    bool adaptive_beam = false;
+    size_t min_beam_width = 4;
+    float adaptive_beam_margin = 2.0;
     float beam_cut = 100.0;
     float blank_score = 2.0;
     float q_shift = 0.0;
     float q_scale = 1.0;
     float temperature = 1.0;
     bool move_pad = false;
+    // Number of threads the CPU decoder splits a batch between.
+    int num_cpu_threads = 4;
 };
 
 struct DecodeData {
@@ -136,7 +136,10 @@ float beam_search(const T* const scores,
                   std::vector<uint8_t>& moves,
                   std::vector<float>& qual_data,
                   float score_scale,
-                  float posts_scale) {
+                  float posts_scale,
+                  size_t adaptive_min_width,
+                  float adaptive_beam_margin,
+                  size_t& num_beam_elements) {
     const size_t num_states = 1ull << num_state_bits;
     const auto states_mask = static_cast<state_t>(num_states - 1);
 
@@ -307,6 +310,26 @@ float beam_search(const T* const scores,
             ++new_elem_count;
         }
 
+        // Width of the beam for this block, which is narrowed where the best candidate is well
+        // ahead of the rest. Candidate scores include the back guide, so the margin between the
+        // best two says how strongly the posterior favours one path. Halve the beam for each
+        // adaptive_beam_margin of it, down to adaptive_min_width.
+        size_t block_beam_width = max_beam_width;
+        if (adaptive_min_width < max_beam_width) {
+            float second_score = std::numeric_limits<float>::lowest();
+            bool found_max = false;
+            for (size_t i = 0; i < new_elem_count; ++i) {
+                if (current_scores[i] == max_score && !found_max) {
+                    found_max = true;
+                } else {
+                    second_score = std::max(second_score, current_scores[i]);
+                }
+            }
+            const float margin = max_score - second_score;
+            const int num_halvings = int(std::min(margin / adaptive_beam_margin, 16.0f));
+            block_beam_width = std::max(adaptive_min_width, max_beam_width >> num_halvings);
+        }
+
         // Starting point for finding the cutoff score is the beam cut score
         float beam_cutoff_score = max_score - log_beam_cut;
 
@@ -357,17 +380,17 @@ float beam_search(const T* const scores,
         // Count the elements which meet the min score
         size_t elem_count = get_elem_count();
 
-        if (elem_count > max_beam_width) {
+        if (elem_count > block_beam_width) {
             // Need to find a score which doesn't return too many scores, but doesn't reduce beam width too much
             size_t min_beam_width =
-                    (max_beam_width * 8) / 10;  // 80% of beam width is the minimum we accept.
+                    (block_beam_width * 8) / 10;  // 80% of beam width is the minimum we accept.
             float low_score = beam_cutoff_score;
             float hi_score = max_score;
             int num_guesses = 1;
             constexpr int MAX_GUESSES = 10;
-            while ((elem_count > max_beam_width || elem_count < min_beam_width) &&
+            while ((elem_count > block_beam_width || elem_count < min_beam_width) &&
                    num_guesses < MAX_GUESSES) {
-                if (elem_count > max_beam_width) {
+                if (elem_count > block_beam_width) {
                     // Make a higher guess
                     low_score = beam_cutoff_score;
                     beam_cutoff_score = (beam_cutoff_score + hi_score) / 2.0f;  // binary search.
@@ -392,13 +415,13 @@ float beam_search(const T* const scores,
             }
 
             // Clamp the element count to the max beam width in case of failure 2 from above.
-            elem_count = std::min(elem_count, max_beam_width);
+            elem_count = std::min(elem_count, block_beam_width);
         }
 
         size_t write_idx = 0;
         for (size_t read_idx = 0; read_idx < new_elem_count; ++read_idx) {
             if (current_scores[read_idx] >= beam_cutoff_score) {
-                if (write_idx < max_beam_width) {
+                if (write_idx < block_beam_width) {
                     prev_beam_front[write_idx] = current_beam_front[read_idx];
                     prev_scores[write_idx] = current_scores[read_idx];
                     ++write_idx;
@@ -407,6 +430,7 @@ float beam_search(const T* const scores,
                 }
             }
         }
+        num_beam_elements += write_idx;
 
         // At the last timestep, we need to ensure the best path corresponds to element 0.
         // The other elements don't matter.
@@ -528,7 +552,10 @@ std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
         float fixed_stay_score,
         float q_shift,
         float q_scale,
-        float byte_score_scale) {
+        float byte_score_scale,
+        size_t min_beam_width,
+        float adaptive_beam_margin,
+        size_t* num_beam_elements) {
     const int num_blocks = int(scores_t.size(0));
     const int num_states = get_num_states(scores_t.size(1));
     const int num_state_bits = static_cast<int>(std::log2(num_states));
@@ -551,6 +578,11 @@ std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
     std::vector<uint8_t> moves(num_blocks);
     std::vector<float> qual_data(num_blocks * NUM_BASES);
 
+    // A minimum width of 0 is the same as a fixed beam.
+    const size_t adaptive_min_width =
+            (min_beam_width > 0 && adaptive_beam_margin > 0.0f) ? min_beam_width : max_beam_width;
+
+    size_t beam_elements = 0;
     const size_t scores_block_stride = scores_block_contig.stride(0);
     if (scores_t.dtype() == at::ScalarType::Float) {
         // If the scores are floats, so must the other tensors.
@@ -565,7 +597,8 @@ std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
 
         beam_search<float, float>(scores, scores_block_stride, back_guides, posts, num_state_bits,
                                   num_blocks, max_beam_width, beam_cut, fixed_stay_score, states,
-                                  moves, qual_data, 1.0f, 1.0f);
+                                  moves, qual_data, 1.0f, 1.0f, adaptive_min_width,
+                                  adaptive_beam_margin, beam_elements);
     } else if (scores_t.dtype() == at::kChar) {
         // If the scores are 8 bit, the posterior probabilities must be 16 bit (Apple path).
         if (posts_t.dtype() != at::ScalarType::Short) {
@@ -580,7 +613,8 @@ std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
         beam_search<int8_t, int16_t>(scores, scores_block_stride, back_guides, posts,
                                      num_state_bits, num_blocks, max_beam_width, beam_cut,
                                      fixed_stay_score, states, moves, qual_data, byte_score_scale,
-                                     posts_scale);
+                                     posts_scale, adaptive_min_width, adaptive_beam_margin,
+                                     beam_elements);
 
     } else if (scores_t.dtype() == at::kHalf) {
         if (posts_t.dtype() != at::ScalarType::Float) {
@@ -593,13 +627,18 @@ std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
         const auto posts = posts_contig->data_ptr<float>();
         beam_search<c10::Half, float>(scores, scores_block_stride, back_guides, posts,
                                       num_state_bits, num_blocks, max_beam_width, beam_cut,
-                                      fixed_stay_score, states, moves, qual_data, 1.0f, 1.0f);
+                                      fixed_stay_score, states, moves, qual_data, 1.0f, 1.0f,
+                                      adaptive_min_width, adaptive_beam_margin, beam_elements);
 
     } else {
         throw std::runtime_error(std::string("beam_search_decode: unsupported tensor type ") +
                                  std::string(scores_t.dtype().name()));
     }
 
+    if (num_beam_elements) {
+        *num_beam_elements = beam_elements;
+    }
+
     auto [sequence, qstring] = generate_sequence(moves, states, qual_data, q_shift, q_scale);
 
     return {std::move(sequence), std::move(qstring), std::move(moves)};
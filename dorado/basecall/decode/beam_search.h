@@ -9,6 +9,9 @@
 #include <vector>
 
 namespace dorado::basecall::decode {
+// If min_beam_width is non-zero, the beam is narrowed from max_beam_width towards min_beam_width in
+// blocks where the best path is ahead of the rest by multiples of adaptive_beam_margin. If
+// num_beam_elements is set, it receives the number of beam elements kept over all blocks.
 std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
         const at::Tensor& scores_t,
         const at::Tensor& back_guides_t,
@@ -18,5 +21,8 @@ std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
         float fixed_stay_score,
         float q_shift,
         float q_scale,
-        float byte_score_scale);
+        float byte_score_scale,
+        size_t min_beam_width = 0,
+        float adaptive_beam_margin = 0.0f,
+        size_t* num_beam_elements = nullptr);
 }  // namespace dorado::basecall::decode
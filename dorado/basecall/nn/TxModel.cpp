@@ -6,6 +6,7 @@
 #include "utils/gpu_profiling.h"
 
 #include <ATen/Functions.h>
+#include <ATen/Parallel.h>
 #include <ATen/TensorIndexing.h>
 #include <c10/core/ScalarType.h>
 #include <c10/core/TensorOptions.h>
@@ -33,7 +34,9 @@ static bool koi_can_use_cutlass() {
 }
 #endif
 
+#include <algorithm>
 #include <filesystem>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -63,6 +66,153 @@ torch::Tensor scaled_dot_product_attention_naive(const torch::Tensor &q,
     return torch::matmul(weights, v);
 }
 
+namespace {
+
+float dot_product(const float *a, const float *b, int64_t size) {
+    // Independent partial sums so that the compiler can vectorise the loop.
+    constexpr int64_t kLanes = 8;
+    float sums[kLanes] = {};
+    int64_t i = 0;
+    for (; i + kLanes <= size; i += kLanes) {
+        for (int64_t j = 0; j < kLanes; ++j) {
+            sums[j] += a[i + j] * b[i + j];
+        }
+    }
+    float sum = 0;
+    for (; i < size; ++i) {
+        sum += a[i] * b[i];
+    }
+    for (int64_t j = 0; j < kLanes; ++j) {
+        sum += sums[j];
+    }
+    return sum;
+}
+
+}  // namespace
+
+at::Tensor local_attention_cpu(const at::Tensor &qkv_NT3HD,
+                               const at::Tensor &cos_freqs,
+                               const at::Tensor &sin_freqs,
+                               const std::pair<int, int> &attn_window) {
+    if (!qkv_NT3HD.device().is_cpu() || qkv_NT3HD.scalar_type() != at::kFloat) {
+        throw std::runtime_error("local_attention_cpu expects float32 CPU tensors.");
+    }
+    const auto qkv = qkv_NT3HD.contiguous();
+    const int64_t N = qkv.size(0);
+    const int64_t T = qkv.size(1);
+    const int64_t H = qkv.size(3);
+    const int64_t D = qkv.size(4);
+    const int64_t half_D = D / 2;
+    const auto cos_TD = cos_freqs.narrow(0, 0, T).reshape({T, half_D}).to(at::kFloat).contiguous();
+    const auto sin_TD = sin_freqs.narrow(0, 0, T).reshape({T, half_D}).to(at::kFloat).contiguous();
+    // Not a structured binding, since those can't be captured by the lambda below in C++17.
+    const int win_upper = attn_window.first;
+    const int win_lower = attn_window.second;
+    const float scale = 1.f / std::sqrt(float(D));
+
+    auto out_NTHD = at::empty({N, T, H, D}, qkv.options());
+    const float *qkv_ptr = qkv.data_ptr<float>();
+    const float *cos_ptr = cos_TD.data_ptr<float>();
+    const float *sin_ptr = sin_TD.data_ptr<float>();
+    float *out_ptr = out_NTHD.data_ptr<float>();
+
+    // Queries are processed in blocks of kBlockQ, against blocks of kBlockK keys, so that a block
+    // of rotated keys stays in cache while it is used by every query in the block. Each query only
+    // visits keys inside its attention window, with the softmax computed online so that no score
+    // matrix is ever materialised.
+    constexpr int64_t kBlockQ = 32;
+    constexpr int64_t kBlockK = 64;
+
+    at::parallel_for(0, N * H, 1, [&](int64_t begin, int64_t end) {
+        std::vector<float> q_rot(T * D), k_rot(T * D);
+        std::vector<float> scores(kBlockK);
+        std::vector<float> row_max(kBlockQ), row_sum(kBlockQ), acc(kBlockQ * D);
+
+        for (int64_t nh = begin; nh < end; ++nh) {
+            const int64_t n = nh / H;
+            const int64_t h = nh % H;
+            // Element (t, i, d) of this head, where i selects q, k or v.
+            auto qkv_row = [&](int64_t t, int64_t i) {
+                return qkv_ptr + ((n * T + t) * 3 + i) * H * D + h * D;
+            };
+
+            // Apply the rotary embedding to q and k, pairing the first and second halves of each
+            // head as RotaryEmbedding does.
+            for (int64_t t = 0; t < T; ++t) {
+                const float *cos_t = cos_ptr + t * half_D;
+                const float *sin_t = sin_ptr + t * half_D;
+                for (int64_t i = 0; i < 2; ++i) {
+                    const float *src = qkv_row(t, i);
+                    float *dst = (i == 0 ? q_rot.data() : k_rot.data()) + t * D;
+                    for (int64_t d = 0; d < half_D; ++d) {
+                        const float x1 = src[d];
+                        const float x2 = src[d + half_D];
+                        dst[d] = cos_t[d] * x1 - sin_t[d] * x2;
+                        dst[d + half_D] = sin_t[d] * x1 + cos_t[d] * x2;
+                    }
+                }
+            }
+
+            for (int64_t qb = 0; qb < T; qb += kBlockQ) {
+                const int64_t qe = std::min(T, qb + kBlockQ);
+                // Query t attends to keys [t - win_upper, t + win_lower].
+                const int64_t kb = std::max<int64_t>(0, qb - win_upper);
+                const int64_t ke = std::min<int64_t>(T, qe + win_lower);
+                std::fill(row_max.begin(), row_max.end(), -std::numeric_limits<float>::infinity());
+                std::fill(row_sum.begin(), row_sum.end(), 0.f);
+                std::fill(acc.begin(), acc.end(), 0.f);
+
+                for (int64_t kbb = kb; kbb < ke; kbb += kBlockK) {
+                    const int64_t kbe = std::min(ke, kbb + kBlockK);
+                    for (int64_t t = qb; t < qe; ++t) {
+                        const int64_t lo = std::max<int64_t>(kbb, t - win_upper);
+                        const int64_t hi = std::min<int64_t>(kbe, t + win_lower + 1);
+                        if (lo >= hi) {
+                            continue;
+                        }
+                        const float *q_t = q_rot.data() + t * D;
+                        float block_max = -std::numeric_limits<float>::infinity();
+                        for (int64_t j = lo; j < hi; ++j) {
+                            const float s = dot_product(q_t, k_rot.data() + j * D, D) * scale;
+                            scores[j - lo] = s;
+                            block_max = std::max(block_max, s);
+                        }
+
+                        // Rescale what has been accumulated so far to the new running maximum.
+                        const int64_t i = t - qb;
+                        float *acc_i = acc.data() + i * D;
+                        const float new_max = std::max(row_max[i], block_max);
+                        const float correction = std::exp(row_max[i] - new_max);
+                        row_sum[i] *= correction;
+                        for (int64_t d = 0; d < D; ++d) {
+                            acc_i[d] *= correction;
+                        }
+                        for (int64_t j = lo; j < hi; ++j) {
+                            const float p = std::exp(scores[j - lo] - new_max);
+                            row_sum[i] += p;
+                            const float *v_j = qkv_row(j, 2);
+                            for (int64_t d = 0; d < D; ++d) {
+                                acc_i[d] += p * v_j[d];
+                            }
+                        }
+                        row_max[i] = new_max;
+                    }
+                }
+
+                for (int64_t t = qb; t < qe; ++t) {
+                    const int64_t i = t - qb;
+                    const float inv_sum = row_sum[i] > 0 ? 1.f / row_sum[i] : 0.f;
+                    float *out_t = out_ptr + ((n * T + t) * H + h) * D;
+                    for (int64_t d = 0; d < D; ++d) {
+                        out_t[d] = acc[i * D + d] * inv_sum;
+                    }
+                }
+            }
+        }
+    });
+    return out_NTHD;
+}
+
 RMSNormImpl::RMSNormImpl(int hidden_size_) : hidden_size(hidden_size_) {
     weight = at::ones({hidden_size});
     register_parameter("weight", weight, false);
@@ -261,8 +411,14 @@ at::Tensor MultiHeadAttentionImpl::forward(at::Tensor x) {
     const int64_t T = x.size(1);
     const int64_t C = x.size(2);
 
+    // On CPU, the rotary embedding and windowed attention are done by a single blocked kernel
+    // which only computes scores inside the attention window.
+    const bool use_cpu_attention = x.device().is_cpu() && x.scalar_type() == at::kFloat &&
+                                   utils::get_dev_opt<bool>("use_cpu_local_attention", true);
+
 #if DORADO_CUDA_BUILD
-    bool use_koi_rote = utils::get_dev_opt<bool>("use_koi_rote", true) && d_model <= 512;
+    bool use_koi_rote = !use_cpu_attention && utils::get_dev_opt<bool>("use_koi_rote", true) &&
+                        d_model <= 512;
     if (use_koi_rote) {
         if (!wqkv_transposed) {
             auto w = wqkv->weight;
@@ -289,6 +445,18 @@ at::Tensor MultiHeadAttentionImpl::forward(at::Tensor x) {
         // in_feat=512, out_feat=1536 (3*in), nhead=8, head_dim=64=(512/8), dim_ff=2048
         qkv = wqkv(x).view({N, T, 3, nhead, head_dim});
     }
+    if (use_cpu_attention) {
+        {
+            utils::ScopedProfileRange spr("ROTE_MEA", 3);
+            rotary_emb->assert_forward_dims(qkv);
+            auto buffers = rotary_emb->named_buffers();
+            attn_output_ntc = local_attention_cpu(qkv, buffers["cos_freqs"],
+                                                  buffers["sin_freqs"], attn_window)
+                                      .view({N, T, C});
+        }
+        utils::ScopedProfileRange spr("OUTP", 3);
+        return out_proj(attn_output_ntc);
+    }
     {
         utils::ScopedProfileRange spr("ROTE", 3);
 #if DORADO_CUDA_BUILD
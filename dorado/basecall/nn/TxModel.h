@@ -24,6 +24,15 @@ torch::Tensor scaled_dot_product_attention_naive(const torch::Tensor &q,
                                                  const torch::Tensor &v,
                                                  const torch::Tensor &mask);
 
+// Windowed self-attention for float32 CPU tensors, with the rotary embedding applied to q and k.
+// qkv_NT3HD is the (unrotated) output of the qkv projection and cos_freqs/sin_freqs are the
+// RotaryEmbedding buffers. Query t attends to keys [t - attn_window.first, t + attn_window.second].
+// Returns the attention output as NTHD.
+at::Tensor local_attention_cpu(const at::Tensor &qkv_NT3HD,
+                               const at::Tensor &cos_freqs,
+                               const at::Tensor &sin_freqs,
+                               const std::pair<int, int> &attn_window);
+
 struct RMSNormImpl : torch::nn::Module {
     RMSNormImpl(int hidden_size_);
     at::Tensor forward(at::Tensor x);
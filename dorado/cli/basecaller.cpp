@@ -94,16 +94,14 @@ void set_basecaller_params(const argparse::ArgumentParser& arg,
                                    get_opt("--chunksize"), get_opt("--overlap"),
                                    get_opt("--batchsize"));
 
-    if (device == "cpu" && model_config.basecaller.batch_size() == 0) {
-        // Force the batch size to 128
-        // TODO: This is tuned for LSTM models - investigate Tx
-        model_config.basecaller.set_batch_size(128);
-    }
+    // On CPU a batch size of 0 is resolved by timing the model when the runners are created.
 #if DORADO_METAL_BUILD
-    else if (device == "metal" && model_config.is_tx_model() &&
-             model_config.basecaller.batch_size() == 0) {
+    if (device == "metal" && model_config.is_tx_model() &&
+        model_config.basecaller.batch_size() == 0) {
         model_config.basecaller.set_batch_size(32);
     }
+#else
+    (void)device;
 #endif
 
     model_config.normalise_basecaller_params();
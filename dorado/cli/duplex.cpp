@@ -23,7 +23,7 @@
 #if DORADO_CUDA_BUILD
 #include "utils/cuda_utils.h"
 #endif
-#include "utils/duplex_utils.h"
+#include "utils/duplex_pair_list.h"
 #include "utils/fs_utils.h"
 #include "utils/log_utils.h"
 #include "utils/parameters.h"
@@ -39,6 +39,7 @@
 #include <spdlog/spdlog.h>
 #include <torch/utils.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
@@ -329,6 +330,12 @@ int duplex(int argc, char* argv[]) {
 
     cli::add_minimap2_arguments(parser, alignment::DEFAULT_MM_PRESET);
     cli::add_internal_arguments(parser);
+    parser.hidden.add_argument("--pairing-signal-spill-threshold")
+            .help("Move the signal of reads in the duplex pairing cache to a file in the system "
+                  "temporary directory once the cached signal exceeds this many megabytes. 0 "
+                  "disables spilling.")
+            .default_value(0)
+            .scan<'i', int>();
 
     std::set<fs::path> temp_model_paths;
     try {
@@ -351,16 +358,15 @@ int duplex(int argc, char* argv[]) {
         auto mod_bases = parser.visible.get<std::vector<std::string>>("--modified-bases");
         auto mod_bases_models = parser.visible.get<std::string>("--modified-bases-models");
 
-        std::map<std::string, std::string> template_complement_map;
         auto read_list = utils::load_read_list(parser.visible.get<std::string>("--read-ids"));
 
-        std::unordered_set<std::string> read_list_from_pairs;
+        utils::DuplexPairList pair_list;
 
         if (!pairs_file.empty()) {
             spdlog::info("> Loading pairs file");
-            template_complement_map = utils::load_pairs_file(pairs_file);
-            read_list_from_pairs = utils::get_read_list_from_pairs(template_complement_map);
-            spdlog::info("> Pairs file loaded with {} reads.", read_list_from_pairs.size());
+            pair_list =
+                    utils::DuplexPairList::load(pairs_file, std::thread::hardware_concurrency());
+            spdlog::info("> Pairs file loaded with {} reads.", pair_list.num_reads());
         } else {
             spdlog::info(
                     "> No duplex pairs file provided, pairing will be performed automatically");
@@ -401,7 +407,7 @@ int duplex(int argc, char* argv[]) {
 
         size_t num_reads = 0;
         if (basespace_duplex) {
-            num_reads = read_list_from_pairs.size();
+            num_reads = pair_list.num_reads();
         } else {
             num_reads = DataLoader::get_num_reads(reads, read_list, {}, recursive_file_loading);
             if (num_reads == 0) {
@@ -474,19 +480,12 @@ int duplex(int argc, char* argv[]) {
                 return EXIT_FAILURE;
             }
 
-            spdlog::info("> Loading reads");
-            auto read_map = read_bam(reads, read_list_from_pairs);
-
-            for (auto& [key, read] : read_map) {
-                client_info_init_func(read->read_common);
-            }
-
             spdlog::info("> Starting Basespace Duplex Pipeline");
             threads = threads == 0 ? std::thread::hardware_concurrency() : threads;
 
-            pipeline_desc.add_node<BaseSpaceDuplexCallerNode>({read_filter_node},
-                                                              std::move(template_complement_map),
-                                                              std::move(read_map), threads);
+            // Reads are streamed from the file as the pairs are called, rather than loaded first.
+            pipeline_desc.add_node<BaseSpaceDuplexCallerNode>(
+                    {read_filter_node}, std::move(pair_list), reads, threads);
 
             pipeline = Pipeline::create(std::move(pipeline_desc), &stats_reporters);
             if (pipeline == nullptr) {
@@ -623,11 +622,14 @@ int duplex(int argc, char* argv[]) {
             spdlog::info("> Starting Stereo Duplex pipeline");
 
             PairingParameters pairing_parameters;
-            if (template_complement_map.empty()) {
-                pairing_parameters =
-                        DuplexPairingParameters{ReadOrder::BY_CHANNEL, DEFAULT_DUPLEX_CACHE_DEPTH};
+            if (pair_list.empty()) {
+                const auto spill_threshold_mb =
+                        parser.hidden.get<int>("--pairing-signal-spill-threshold");
+                pairing_parameters = DuplexPairingParameters{
+                        ReadOrder::BY_CHANNEL, DEFAULT_DUPLEX_CACHE_DEPTH,
+                        size_t(std::max(spill_threshold_mb, 0)) << 20};
             } else {
-                pairing_parameters = std::move(template_complement_map);
+                pairing_parameters = std::move(pair_list);
             }
 
             auto mean_qscore_start_pos = models.model_config.mean_qscore_start_pos;
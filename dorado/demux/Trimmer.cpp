@@ -237,6 +237,8 @@ void Trimmer::trim_sequence(SimplexRead& read, std::pair<int, int> trim_interval
                                                 trim_interval.second * num_modbase_channels};
         read.read_common.base_mod_probs =
                 utils::trim_quality(read.read_common.base_mod_probs, modbase_interval);
+        // The sparse probabilities are indexed by base, so are trimmed like the sequence.
+        read.read_common.sparse_base_mod_probs.trim(trim_interval);
     }
 }
 
@@ -3,6 +3,7 @@
 #include "ModbaseScaler.h"
 #include "MotifMatcher.h"
 #include "nn/ModBaseModel.h"
+#include "utils/dev_utils.h"
 #include "utils/sequence_utils.h"
 
 #if DORADO_CUDA_BUILD
@@ -17,10 +18,68 @@
 #include <TargetConditionals.h>
 #endif
 
+#include <algorithm>
 #include <chrono>
+#include <map>
+#include <utility>
 
 using namespace std::chrono_literals;
 
+namespace {
+
+// Times the model at each candidate batch size and picks the smallest whose throughput is within
+// 5% of the best, since larger batches only add latency once the model is saturated. Every caller
+// of the same model shares the result, and tuning is serialised so that timings don't interfere.
+int autotune_cpu_batch_size(const std::filesystem::path& model_path,
+                            bool quantized,
+                            torch::nn::ModuleHolder<torch::nn::AnyModule>& module,
+                            const dorado::modbase::ModBaseModelConfig& params,
+                            const at::TensorOptions& opts) {
+    static std::mutex tuned_batch_sizes_mutex;
+    static std::map<std::pair<std::string, bool>, int> tuned_batch_sizes;
+
+    std::lock_guard lock(tuned_batch_sizes_mutex);
+    const auto key = std::make_pair(model_path.string(), quantized);
+    if (auto it = tuned_batch_sizes.find(key); it != tuned_batch_sizes.end()) {
+        return it->second;
+    }
+
+    const auto sig_len = static_cast<int64_t>(params.context_before + params.context_after);
+    const auto kmer_len = static_cast<int64_t>(params.bases_after + params.bases_before + 1);
+    constexpr int NUM_TIMED_ITERS = 3;
+
+    std::vector<std::pair<int, double>> chunks_per_sec;
+    for (int batch_size : {32, 64, 128, 256, 512}) {
+        auto input_sigs = torch::randn({batch_size, 1, sig_len}, opts);
+        auto input_seqs = torch::zeros(
+                {batch_size, sig_len, dorado::utils::BaseInfo::NUM_BASES * kmer_len},
+                opts.dtype(torch::kInt8));
+        // Warmup
+        module->forward(input_sigs, input_seqs);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_TIMED_ITERS; ++i) {
+            module->forward(input_sigs, input_seqs);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        chunks_per_sec.emplace_back(batch_size, batch_size * NUM_TIMED_ITERS / elapsed.count());
+    }
+
+    const auto best_rate = std::max_element(chunks_per_sec.begin(), chunks_per_sec.end(),
+                                            [](const auto& a, const auto& b) {
+                                                return a.second < b.second;
+                                            })->second;
+    const auto tuned = std::find_if(
+            chunks_per_sec.begin(), chunks_per_sec.end(),
+            [best_rate](const auto& rate) { return rate.second >= 0.95 * best_rate; });
+    spdlog::debug("Modbase model {}: CPU batch size {} ({:.0f} chunks/s)",
+                  model_path.filename().string(), tuned->first, tuned->second);
+    tuned_batch_sizes[key] = tuned->first;
+    return tuned->first;
+}
+
+}  // namespace
+
 namespace dorado::modbase {
 
 struct ModBaseCaller::ModBaseTask {
@@ -39,11 +98,14 @@ struct ModBaseCaller::ModBaseTask {
 
 ModBaseCaller::ModBaseData::ModBaseData(const std::filesystem::path& model_path,
                                         at::TensorOptions opts,
-                                        int batch_size_)
+                                        int batch_size_,
+                                        bool quantize)
         : params(load_modbase_model_config(model_path)),
-          module_holder(load_modbase_model(model_path, opts)),
+          module_holder(load_modbase_model(model_path, opts, quantize)),
           matcher(params),
-          batch_size(batch_size_) {
+          batch_size(batch_size_ > 0 ? batch_size_
+                                     : autotune_cpu_batch_size(model_path, quantize, module_holder,
+                                                               params, opts)) {
     if (params.refine_do_rough_rescale) {
         scaler = std::make_unique<ModBaseScaler>(params.refine_kmer_levels, params.refine_kmer_len,
                                                  params.refine_kmer_center_idx);
@@ -71,6 +133,10 @@ std::vector<size_t> ModBaseCaller::ModBaseData::get_motif_hits(const std::string
     return matcher.get_motif_hits(seq);
 }
 
+std::vector<std::vector<size_t>> ModBaseCaller::get_all_motif_hits(const std::string& seq) const {
+    return m_motif_matcher->get_all_motif_hits(seq);
+}
+
 ModBaseCaller::ModBaseCaller(const std::vector<std::filesystem::path>& model_paths,
                              int batch_size,
                              const std::string& device)
@@ -99,14 +165,27 @@ ModBaseCaller::ModBaseCaller(const std::vector<std::filesystem::path>& model_pat
     m_caller_data.reserve(m_num_models);
     m_task_threads.reserve(m_num_models);
 
+    // int8 inference is opt-in, since it slightly changes the modified base probabilities.
+    const bool quantize = m_options.device().is_cpu() &&
+                          utils::get_dev_opt<bool>("modbase_cpu_int8", false);
+
     for (size_t model_id = 0; model_id < m_num_models; ++model_id) {
         const auto& model_path = model_paths[model_id];
 
         at::InferenceMode guard;
-        auto caller_data = std::make_unique<ModBaseData>(model_path, m_options, batch_size);
+        auto caller_data =
+                std::make_unique<ModBaseData>(model_path, m_options, batch_size, quantize);
         m_caller_data.push_back(std::move(caller_data));
     }
 
+    std::vector<std::string> motifs;
+    std::vector<size_t> motif_offsets;
+    for (const auto& caller_data : m_caller_data) {
+        motifs.push_back(caller_data->params.motif);
+        motif_offsets.push_back(caller_data->params.motif_offset);
+    }
+    m_motif_matcher = std::make_unique<MotifMatcher>(motifs, motif_offsets);
+
     start_threads();
 }
 
@@ -159,8 +238,15 @@ at::Tensor ModBaseCaller::call_chunks(size_t model_id,
                                       int num_chunks) {
     NVTX3_FUNC_RANGE();
     auto& caller_data = m_caller_data[model_id];
-    auto task = std::make_shared<ModBaseTask>(input_sigs.to(m_options.device()),
-                                              input_seqs.to(m_options.device()), num_chunks);
+    auto sigs = input_sigs.to(m_options.device());
+    auto seqs = input_seqs.to(m_options.device());
+    if (m_options.device().is_cpu() && num_chunks < sigs.size(0)) {
+        // GPU batches keep a fixed shape, but on CPU there's no point running the model over the
+        // unused rows of a partial batch.
+        sigs = sigs.narrow(0, 0, num_chunks);
+        seqs = seqs.narrow(0, 0, num_chunks);
+    }
+    auto task = std::make_shared<ModBaseTask>(sigs, seqs, num_chunks);
     {
         std::lock_guard<std::mutex> lock(caller_data->input_lock);
         caller_data->input_queue.push_front(task);
@@ -30,9 +30,11 @@ public:
         friend class ModBaseCaller;
 
     public:
+        // A batch_size_ of 0 picks the fastest for the model, which is only supported on CPU.
         ModBaseData(const std::filesystem::path& model_path,
                     at::TensorOptions opts,
-                    int batch_size_);
+                    int batch_size_,
+                    bool quantize);
         std::vector<size_t> get_motif_hits(const std::string& seq) const;
 
         const ModBaseModelConfig params;
@@ -77,6 +79,8 @@ public:
         return m_caller_data[caller_id];
     }
     size_t num_model_callers() const { return m_caller_data.size(); }
+    // Motif hits of every model in seq, indexed by model, found in a single pass.
+    std::vector<std::vector<size_t>> get_all_motif_hits(const std::string& seq) const;
 
 private:
     void start_threads();
@@ -87,6 +91,7 @@ private:
     at::TensorOptions m_options;
     std::atomic<bool> m_terminate{false};
     std::vector<std::unique_ptr<ModBaseData>> m_caller_data;
+    std::unique_ptr<MotifMatcher> m_motif_matcher;
     std::vector<std::unique_ptr<std::thread>> m_task_threads;
 
     // Performance monitoring stats.
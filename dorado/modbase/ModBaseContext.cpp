@@ -91,7 +91,7 @@ std::vector<bool> ModBaseContext::get_sequence_mask(std::string_view sequence) c
 void ModBaseContext::update_mask(std::vector<bool>& mask,
                                  const std::string& sequence,
                                  const std::vector<std::string>& modbase_alphabet,
-                                 const std::vector<uint8_t>& modbase_probs,
+                                 const utils::SparseModBaseProbs& modbase_probs,
                                  uint8_t threshold) const {
     // Iterate over the provided alphabet and find all the bases that may be modified.
     size_t num_channels = modbase_alphabet.size();
@@ -107,12 +107,22 @@ void ModBaseContext::update_mask(std::vector<bool>& mask,
                 // not be updated, regardless of the threshold.
                 continue;
             }
-            for (size_t base_idx = 0; base_idx < sequence.size(); base_idx++) {
-                if (sequence[base_idx] == current_cardinal) {
-                    if (modbase_probs[base_idx * num_channels + channel_idx] >= threshold) {
+            if (threshold == 0) {
+                // Every base passes, including those with no row.
+                for (size_t base_idx = 0; base_idx < sequence.size(); base_idx++) {
+                    if (sequence[base_idx] == current_cardinal) {
                         mask[base_idx] = true;
                     }
                 }
+                continue;
+            }
+            const auto& positions = modbase_probs.positions();
+            for (size_t row_idx = 0; row_idx < positions.size(); row_idx++) {
+                const size_t base_idx = positions[row_idx];
+                if (base_idx < sequence.size() && sequence[base_idx] == current_cardinal &&
+                    modbase_probs.row(row_idx)[channel_idx] >= threshold) {
+                    mask[base_idx] = true;
+                }
             }
         }
     }
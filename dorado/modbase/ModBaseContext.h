@@ -1,5 +1,7 @@
 #pragma once
 
+#include "utils/modbase_probs.h"
+
 #include <array>
 #include <map>
 #include <memory>
@@ -81,11 +83,13 @@ public:
      *  as any such bases should only have their mask values determined by whether the context
      *  is satisfied for that position in the sequence. The threshold is thus ignored for those
      *  bases.
+     * 
+     *  Bases with no row in modbase_probs have a modification probability of 0.
      */
     void update_mask(std::vector<bool>& mask,
                      const std::string& sequence,
                      const std::vector<std::string>& modbase_alphabet,
-                     const std::vector<uint8_t>& modbase_probs,
+                     const utils::SparseModBaseProbs& modbase_probs,
                      uint8_t threshold) const;
 
 private:
@@ -91,6 +91,10 @@ std::vector<size_t> ModBaseRunner::get_motif_hits(size_t caller_id, const std::s
     return m_caller->caller_data(caller_id)->get_motif_hits(seq);
 }
 
+std::vector<std::vector<size_t>> ModBaseRunner::get_all_motif_hits(const std::string& seq) const {
+    return m_caller->get_all_motif_hits(seq);
+}
+
 const ModBaseModelConfig& ModBaseRunner::caller_params(size_t caller_id) const {
     return m_caller->caller_data(caller_id)->params;
 }
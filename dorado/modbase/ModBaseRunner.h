@@ -29,9 +29,11 @@ public:
                             const std::vector<int>& seq_ints,
                             const std::vector<uint64_t>& seq_to_sig_map) const;
     std::vector<size_t> get_motif_hits(size_t caller_id, const std::string& seq) const;
+    // Motif hits of every caller, indexed by caller_id.
+    std::vector<std::vector<size_t>> get_all_motif_hits(const std::string& seq) const;
     const ModBaseModelConfig& caller_params(size_t caller_id) const;
     size_t num_callers() const;
-    size_t batch_size() const { return m_input_sigs[0].size(0); }
+    size_t batch_size(size_t caller_id) const { return m_input_sigs[caller_id].size(0); }
     void terminate();
     void restart();
     std::string get_name() const;
@@ -126,15 +126,15 @@ int ModBaseEncoder::compute_sample_pos(int base_pos) const {
     return int(m_sample_offsets[base_offset]);
 }
 
-namespace {
+namespace details {
 
-// Fallback path for non-AVX / kmer lengths not specifically optimised.
+// Fallback path for non-AVX, and the reference for the vectorised paths.
 std::vector<int8_t> encode_kmer_generic(const std::vector<int>& seq,
                                         const std::vector<int>& seq_mappings,
                                         int bases_before,
                                         int bases_after,
-                                        int context_samples,
-                                        int kmer_len) {
+                                        int context_samples) {
+    const int kmer_len = bases_before + bases_after + 1;
     const size_t seq_len = seq.size() - bases_before - bases_after;
     std::vector<int8_t> output(kmer_len * utils::BaseInfo::NUM_BASES * context_samples);
 
@@ -156,18 +156,9 @@ std::vector<int8_t> encode_kmer_generic(const std::vector<int>& seq,
     return output;
 }
 
-// For non-AVX we use the generic path that handles any kmer length.
-#if ENABLE_AVX2_IMPL
-__attribute__((target("default")))
-#endif
-std::vector<int8_t>
-encode_kmer_len9(const std::vector<int>& seq,
-                 const std::vector<int>& seq_mappings,
-                 int bases_before,
-                 int bases_after,
-                 int context_samples) {
-    return encode_kmer_generic(seq, seq_mappings, bases_before, bases_after, context_samples, 9);
-}
+}  // namespace details
+
+namespace {
 
 #if ENABLE_AVX2_IMPL
 __attribute__((target("avx2"))) std::vector<int8_t> encode_kmer_len9(
@@ -260,20 +251,154 @@ __attribute__((target("avx2"))) std::vector<int8_t> encode_kmer_len9(
 
     return output_t;
 }
+
+// GCC vector extension types, so that one implementation can be compiled for each instruction set.
+typedef int32_t Int32x8 __attribute__((vector_size(32)));
+typedef int32_t Int32x16 __attribute__((vector_size(64)));
+
+// Encodes kmers of any length, holding each one-hot kmer row in kNumVectors vectors of type Vec.
+// Rows are written with whole vector stores which may run past the end of the row; the excess is
+// overwritten by the next row, and the final row in the output is copied exactly.
+// Always inlined so that it is compiled for the target of the caller.
+template <typename Vec, int kNumVectors>
+__attribute__((always_inline)) inline std::vector<int8_t> encode_kmer_vectorised(
+        const std::vector<int>& seq,
+        const std::vector<int>& seq_mappings,
+        int bases_before,
+        int bases_after,
+        int context_samples) {
+    constexpr size_t kLanes = sizeof(Vec) / sizeof(int32_t);
+    const size_t kmer_len = size_t(bases_before + bases_after + 1);
+    const size_t row_bytes = kmer_len * sizeof(int32_t);
+    const size_t seq_len = seq.size() - bases_before - bases_after;
+    std::vector<int8_t> output(row_bytes * context_samples);
+    std::byte* output_ptr = reinterpret_cast<std::byte*>(output.data());
+    const std::byte* const output_end = output_ptr + output.size();
+
+    for (size_t seq_pos = 0; seq_pos < seq_len; ++seq_pos) {
+        Vec row[kNumVectors];
+        for (int v = 0; v < kNumVectors; ++v) {
+            const size_t first_base = seq_pos + v * kLanes;
+            Vec bases{};
+            if (first_base + kLanes <= seq.size()) {
+                std::memcpy(&bases, &seq[first_base], sizeof(Vec));
+            } else {
+                // Lanes beyond the end of the sequence are never part of the output.
+                for (size_t i = first_base; i < seq.size(); ++i) {
+                    bases[i - first_base] = seq[i];
+                }
+            }
+            // 1 << (base << 3), with -1 sequence indices producing zero elements.
+            row[v] = ((Vec{} + 1) << ((bases & 3) << 3)) & (bases >= 0);
+        }
+
+        const int count = seq_mappings[seq_pos + 1] - seq_mappings[seq_pos];
+        for (int i = 0; i < count; ++i) {
+            if (output_ptr + sizeof(row) <= output_end) {
+                // memcpy will be translated to single vector writes.
+                for (int v = 0; v < kNumVectors; ++v) {
+                    std::memcpy(output_ptr + v * sizeof(Vec), &row[v], sizeof(Vec));
+                }
+            } else {
+                std::memcpy(output_ptr, row, row_bytes);
+            }
+            output_ptr += row_bytes;
+        }
+    }
+    return output;
+}
+
+template <typename Vec>
+__attribute__((always_inline)) inline std::vector<int8_t> encode_kmer_any_len(
+        const std::vector<int>& seq,
+        const std::vector<int>& seq_mappings,
+        int bases_before,
+        int bases_after,
+        int context_samples) {
+    constexpr int kLanes = int(sizeof(Vec) / sizeof(int32_t));
+    const int kmer_len = bases_before + bases_after + 1;
+    switch ((kmer_len + kLanes - 1) / kLanes) {
+    case 1:
+        return encode_kmer_vectorised<Vec, 1>(seq, seq_mappings, bases_before, bases_after,
+                                              context_samples);
+    case 2:
+        return encode_kmer_vectorised<Vec, 2>(seq, seq_mappings, bases_before, bases_after,
+                                              context_samples);
+    case 3:
+        return encode_kmer_vectorised<Vec, 3>(seq, seq_mappings, bases_before, bases_after,
+                                              context_samples);
+    case 4:
+        return encode_kmer_vectorised<Vec, 4>(seq, seq_mappings, bases_before, bases_after,
+                                              context_samples);
+    default:
+        // Far longer than any model's kmer.
+        return details::encode_kmer_generic(seq, seq_mappings, bases_before, bases_after,
+                                            context_samples);
+    }
+}
+#endif
+
+// For non-AVX we use the generic path that handles any kmer length.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+std::vector<int8_t>
+encode_kmer_simd(const std::vector<int>& seq,
+                 const std::vector<int>& seq_mappings,
+                 int bases_before,
+                 int bases_after,
+                 int context_samples) {
+    return details::encode_kmer_generic(seq, seq_mappings, bases_before, bases_after,
+                                        context_samples);
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2"))) std::vector<int8_t> encode_kmer_simd(
+        const std::vector<int>& seq,
+        const std::vector<int>& seq_mappings,
+        int bases_before,
+        int bases_after,
+        int context_samples) {
+    // The hand-written kernel for the most common kmer length is still the fastest.
+    if (bases_before + bases_after + 1 == 9) {
+        return encode_kmer_len9(seq, seq_mappings, bases_before, bases_after, context_samples);
+    }
+    return encode_kmer_any_len<Int32x8>(seq, seq_mappings, bases_before, bases_after,
+                                        context_samples);
+}
+
+__attribute__((target("avx512f"))) std::vector<int8_t> encode_kmer_simd(
+        const std::vector<int>& seq,
+        const std::vector<int>& seq_mappings,
+        int bases_before,
+        int bases_after,
+        int context_samples) {
+    if (bases_before + bases_after + 1 == 9) {
+        return encode_kmer_len9(seq, seq_mappings, bases_before, bases_after, context_samples);
+    }
+    return encode_kmer_any_len<Int32x16>(seq, seq_mappings, bases_before, bases_after,
+                                         context_samples);
+}
 #endif
 
 }  // namespace
 
+namespace details {
+
+std::vector<int8_t> encode_kmer(const std::vector<int>& seq,
+                                const std::vector<int>& seq_mappings,
+                                int bases_before,
+                                int bases_after,
+                                int context_samples) {
+    return encode_kmer_simd(seq, seq_mappings, bases_before, bases_after, context_samples);
+}
+
+}  // namespace details
+
 std::vector<int8_t> ModBaseEncoder::encode_kmer(const std::vector<int>& seq,
                                                 const std::vector<int>& seq_mappings) const {
-    // Specialised version for the case of kmer_len 9 that can be faster.
-    if (m_kmer_len == 9) {
-        return encode_kmer_len9(seq, seq_mappings, m_bases_before, m_bases_after,
+    return details::encode_kmer(seq, seq_mappings, m_bases_before, m_bases_after,
                                 m_context_samples);
-    }
-
-    return encode_kmer_generic(seq, seq_mappings, m_bases_before, m_bases_after, m_context_samples,
-                               m_kmer_len);
 }
 
 }  // namespace dorado::modbase
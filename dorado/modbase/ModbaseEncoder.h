@@ -6,6 +6,27 @@
 
 namespace dorado::modbase {
 
+// Exposed for testability
+namespace details {
+
+// One-hot encodes the kmer centred on each base of seq, repeated for each of the samples assigned
+// to that base by seq_mappings. seq is padded with bases_before/bases_after bases, which are -1
+// where they lie outside the read.
+// encode_kmer dispatches to the fastest implementation for the kmer length and CPU, which must
+// match encode_kmer_generic.
+std::vector<int8_t> encode_kmer_generic(const std::vector<int>& seq,
+                                        const std::vector<int>& seq_mappings,
+                                        int bases_before,
+                                        int bases_after,
+                                        int context_samples);
+std::vector<int8_t> encode_kmer(const std::vector<int>& seq,
+                                const std::vector<int>& seq_mappings,
+                                int bases_before,
+                                int bases_after,
+                                int context_samples);
+
+}  // namespace details
+
 class ModBaseEncoder {
 private:
     int m_bases_before;
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <ATen/core/TensorBody.h>
+#include <c10/util/Half.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <utility>
@@ -9,6 +11,16 @@
 
 namespace dorado::modbase {
 
+namespace details {
+// Exposed for testability.
+// Writes src[i] * scale + offset to dest[i], computed in float and rounded to half once.
+void scale_samples(c10::Half* dest,
+                   const c10::Half* src,
+                   size_t count,
+                   float scale,
+                   float offset);
+}  // namespace details
+
 /// Calculates new scaling values for improved modified base detection
 class ModBaseScaler {
 private:
@@ -16,19 +28,6 @@ private:
     const size_t m_kmer_len;
     const size_t m_centre_index;
 
-    /** Get the index in the model kmer_levels corresponding to the input kmer
-     *  @param int_kmer_start Pointer to the start of the kmer in the sequence
-     *  @param kmer_len The length of the kmer
-     *  @return The index of the kmer
-     */
-    static inline size_t index_from_int_kmer(const int* int_kmer_start, size_t kmer_len);
-
-    /** Get the expected normalized daq levels for in the input basecall sequence.
-     *  @param int_seq The basecall sequence, encoded as integers with A=0, C=1, G=2, T=3
-     *  @return A vector of the expected normalized daq level for each base
-     */
-    std::vector<float> extract_levels(const std::vector<int>& int_seq) const;
-
     /** Calculate the new offset and scale 
      *  @param samples The normalized samples for the basecalled sequence
      *  @param seq_to_sig_map The indices of the samples corresponding to moves in the move table
@@ -45,9 +44,16 @@ private:
                                               size_t max_bases) const;
 
 public:
+    /** Get the expected normalized daq levels for in the input basecall sequence.
+     *  The kmer index is rolled along the sequence rather than recomputed for each position.
+     *  @param int_seq The basecall sequence, encoded as integers with A=0, C=1, G=2, T=3
+     *  @return A vector of the expected normalized daq level for each base
+     */
+    std::vector<float> extract_levels(const std::vector<int>& int_seq) const;
+
     /**
      * Scale the input signal based on the expected kmer levels of the input basecalled sequence
-     * @param signal The signal for the basecalled sequence
+     * @param signal The signal for the basecalled sequence, as a contiguous float16 tensor
      * @param seq_ints The basecall sequence, encoded as integers with A=0, C=1, G=2, T=3
      * @param seq_to_sig_map The indices of the samples corresponding to moves in the move table
      * @return The rescaled input signal
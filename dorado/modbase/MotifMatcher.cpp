@@ -4,8 +4,7 @@
 
 #include <nvtx3/nvtx3.hpp>
 
-#include <iterator>
-#include <regex>
+#include <stdexcept>
 #include <unordered_map>
 
 namespace {
@@ -16,28 +15,21 @@ const std::unordered_map<char, std::string> IUPAC_CODES = {
         {'G', "G"},
         {'T', "T"},
         {'U', "T"},  // basecalls will have "T"s instead of "U"s
-        {'R', "[AG]"},
-        {'Y', "[CT]"}, 
-        {'S', "[GC]"}, 
-        {'W', "[AT]"},
-        {'K', "[GT]"}, 
-        {'M', "[AC]"}, 
-        {'B', "[CGT]"},
-        {'D', "[AGT]"},
-        {'H', "[ACT]"},
-        {'V', "[ACG]"},
-        {'N', "[ACGT]"},
+        {'R', "AG"},
+        {'Y', "CT"},
+        {'S', "GC"},
+        {'W', "AT"},
+        {'K', "GT"},
+        {'M', "AC"},
+        {'B', "CGT"},
+        {'D', "AGT"},
+        {'H', "ACT"},
+        {'V', "ACG"},
+        {'N', "ACGT"},
         // clang-format on
 };
 
-std::string expand_motif_regex(const std::string& motif) {
-    std::string motif_regex = "(";
-    for (auto base : motif) {
-        motif_regex += IUPAC_CODES.at(base);
-    }
-    motif_regex += ")";
-    return motif_regex;
-}
+constexpr size_t MAX_WORD_BITS = 64;
 
 }  // namespace
 
@@ -47,23 +39,76 @@ MotifMatcher::MotifMatcher(const ModBaseModelConfig& model_config)
         : MotifMatcher(model_config.motif, model_config.motif_offset) {}
 
 MotifMatcher::MotifMatcher(const std::string& motif, size_t offset)
-        : m_motif(expand_motif_regex(motif)), m_motif_offset(offset) {}
+        : MotifMatcher(std::vector<std::string>{motif}, std::vector<size_t>{offset}) {}
+
+MotifMatcher::MotifMatcher(const std::vector<std::string>& motifs,
+                           const std::vector<size_t>& offsets) {
+    if (motifs.size() != offsets.size()) {
+        throw std::invalid_argument("MotifMatcher: expected an offset for each motif.");
+    }
+    for (size_t i = 0; i < motifs.size(); ++i) {
+        add_motif(i, motifs[i], offsets[i]);
+    }
+    m_num_motifs = motifs.size();
+}
+
+void MotifMatcher::add_motif(size_t motif_idx, const std::string& motif, size_t offset) {
+    if (motif.empty() || motif.size() > MAX_WORD_BITS) {
+        throw std::invalid_argument("MotifMatcher: motif '" + motif + "' must have 1 to " +
+                                    std::to_string(MAX_WORD_BITS) + " bases.");
+    }
+
+    // Pack the motif into the last word if it fits, otherwise start a new one.
+    size_t first_bit = 0;
+    if (!m_words.empty()) {
+        const auto& last_word = m_words.back();
+        for (size_t bit = 0; bit < MAX_WORD_BITS; ++bit) {
+            if (last_word.end_bits & (uint64_t(1) << bit)) {
+                first_bit = bit + 1;
+            }
+        }
+    }
+    if (m_words.empty() || first_bit + motif.size() > MAX_WORD_BITS) {
+        m_words.emplace_back();
+        first_bit = 0;
+    }
+
+    auto& word = m_words.back();
+    for (size_t i = 0; i < motif.size(); ++i) {
+        const auto& bases = IUPAC_CODES.at(motif[i]);
+        for (char base : bases) {
+            word.char_masks[static_cast<unsigned char>(base)] |= uint64_t(1) << (first_bit + i);
+        }
+    }
+    word.start_bits |= uint64_t(1) << first_bit;
+    word.end_bits |= uint64_t(1) << (first_bit + motif.size() - 1);
+    word.ends.push_back({uint64_t(1) << (first_bit + motif.size() - 1), motif_idx, motif.size(),
+                         offset});
+}
 
 std::vector<size_t> MotifMatcher::get_motif_hits(std::string_view seq) const {
+    return std::move(get_all_motif_hits(seq).front());
+}
+
+std::vector<std::vector<size_t>> MotifMatcher::get_all_motif_hits(std::string_view seq) const {
     NVTX3_FUNC_RANGE();
-    std::vector<size_t> context_hits;
-
-    std::regex regex(m_motif);
-    auto start = std::cbegin(seq);
-    auto end = std::cend(seq);
-    auto pos = start;
-    // string_view on linux uses `const_iterator=const char*`,
-    // but on Windows it's a `std::_String_view_iterator<_Traits>`
-    std::match_results<decltype(pos)> motif_match;
-    while (std::regex_search(pos, end, motif_match, regex)) {
-        auto hit = std::distance(start, pos) + motif_match.position(0) + m_motif_offset;
-        context_hits.push_back(hit);
-        pos += motif_match.position(0) + 1;
+    std::vector<std::vector<size_t>> context_hits(m_num_motifs);
+
+    for (const auto& word : m_words) {
+        uint64_t state = 0;
+        for (size_t pos = 0; pos < seq.size(); ++pos) {
+            state = ((state << 1) | word.start_bits) &
+                    word.char_masks[static_cast<unsigned char>(seq[pos])];
+            const uint64_t matched_ends = state & word.end_bits;
+            if (matched_ends == 0) {
+                continue;
+            }
+            for (const auto& end : word.ends) {
+                if (matched_ends & end.end_bit) {
+                    context_hits[end.motif_idx].push_back(pos + 1 - end.motif_length + end.offset);
+                }
+            }
+        }
     }
     return context_hits;
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -7,16 +9,45 @@
 namespace dorado::modbase {
 
 struct ModBaseModelConfig;
+
+// Finds the positions of IUPAC motifs in a sequence. The motifs are compiled into bitmask tables
+// once, at construction, and then matched with a bit-parallel shift-and scan which finds the hits
+// of every motif in a single pass over the sequence.
 class MotifMatcher {
 public:
     MotifMatcher(const ModBaseModelConfig& model_config);
     MotifMatcher(const std::string& motif, size_t offset);
+    // Matches all of motifs at once. offsets[i] is the offset of the hit within motifs[i].
+    MotifMatcher(const std::vector<std::string>& motifs, const std::vector<size_t>& offsets);
 
+    // Hits of the first motif, as positions in seq of the base at the motif offset.
     std::vector<size_t> get_motif_hits(std::string_view seq) const;
+    // Hits of each motif, in the order the motifs were given.
+    std::vector<std::vector<size_t>> get_all_motif_hits(std::string_view seq) const;
 
 private:
-    const std::string m_motif;
-    const size_t m_motif_offset;
+    // Up to 64 motif positions matched together in one shift-and state word. Bit i of the state
+    // is set when the sequence so far ends with the first i + 1 bases of the motif at that bit.
+    struct MotifWord {
+        // For each character, the motif positions which accept it.
+        std::array<uint64_t, 256> char_masks{};
+        // The first position of each motif, where a match can start at any base.
+        uint64_t start_bits = 0;
+        // The last position of each motif.
+        uint64_t end_bits = 0;
+        struct MotifEnd {
+            uint64_t end_bit;
+            size_t motif_idx;
+            size_t motif_length;
+            size_t offset;
+        };
+        std::vector<MotifEnd> ends;
+    };
+
+    void add_motif(size_t motif_idx, const std::string& motif, size_t offset);
+
+    size_t m_num_motifs = 0;
+    std::vector<MotifWord> m_words;
 };
 
 }  // namespace dorado::modbase
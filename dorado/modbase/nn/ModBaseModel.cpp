@@ -3,24 +3,51 @@
 #include "utils/module_utils.h"
 #include "utils/tensor_utils.h"
 
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <ATen/core/stack.h>
+#include <spdlog/spdlog.h>
 #include <toml.hpp>
 #include <torch/torch.h>
 
+#include <algorithm>
+#include <optional>
 #include <stdexcept>
 
 using namespace torch::nn;
 using namespace torch::indexing;
 
 namespace {
+
+// Layers with fewer inputs than this per output are left in fp32, since quantising their
+// activations would cost more than the int8 matmul saves.
+constexpr int64_t MIN_QUANTIZED_INPUT_SIZE = 64;
+
+bool can_quantize(const at::TensorOptions& options) {
+    if (options.device().type() != c10::kCPU) {
+        return false;
+    }
+    const auto& engines = at::globalContext().supportedQEngines();
+    return std::any_of(engines.begin(), engines.end(),
+                       [](at::QEngine engine) { return engine != at::QEngine::NoQEngine; });
+}
+
 template <class Model>
 ModuleHolder<AnyModule> populate_model(Model&& model,
                                        const std::filesystem::path& path,
-                                       at::TensorOptions options) {
+                                       at::TensorOptions options,
+                                       bool quantize) {
     auto state_dict = model->load_weights(path);
     model->load_state_dict(state_dict);
     model->to(options.dtype_opt().value().toScalarType());
     model->to(options.device_opt().value());
     model->eval();
+    if (quantize) {
+        if (can_quantize(options)) {
+            model->quantize();
+        } else {
+            spdlog::warn("int8 modbase inference is only supported on CPU, using fp32.");
+        }
+    }
 
     auto module = AnyModule(model);
     auto holder = ModuleHolder<AnyModule>(module);
@@ -32,19 +59,54 @@ namespace dorado::modbase {
 
 namespace nn {
 
-struct UnpaddedConvolutionImpl : Module {
-    UnpaddedConvolutionImpl(int size, int outsize, int k, int stride) {
-        conv = register_module("conv", Conv1d(Conv1dOptions(size, outsize, k).stride(stride)));
-        activation = register_module("activation", SiLU());
-    }
+DynamicQuantizedLinear::DynamicQuantizedLinear(const at::Tensor& weight, const at::Tensor& bias) {
+    static const auto prepack_op =
+            c10::Dispatcher::singleton().findSchemaOrThrow("quantized::linear_prepack", "");
+
+    // Symmetric per output channel quantisation of the weights.
+    const auto weight_f32 = weight.to(torch::kFloat32).contiguous();
+    const auto scales = (weight_f32.abs().amax(1) / 127.f).clamp_min(1e-8f).to(torch::kDouble);
+    const auto zero_points = torch::zeros({weight_f32.size(0)}, torch::kLong);
+    const auto quantized_weight =
+            at::quantize_per_channel(weight_f32, scales, zero_points, 0, torch::kQInt8);
+
+    torch::jit::Stack stack{quantized_weight, bias.defined()
+                                                      ? c10::IValue(bias.to(torch::kFloat32))
+                                                      : c10::IValue()};
+    prepack_op.callBoxed(&stack);
+    m_packed_params = std::move(stack.at(0));
+}
 
-    at::Tensor forward(const at::Tensor& x) { return activation(conv(x)); }
+at::Tensor DynamicQuantizedLinear::forward(const at::Tensor& x) const {
+    static const auto linear_op =
+            c10::Dispatcher::singleton().findSchemaOrThrow("quantized::linear_dynamic", "");
+    // Reduced range activations avoid saturating fbgemm's 16 bit intermediate sums.
+    torch::jit::Stack stack{x.contiguous(), m_packed_params, true};
+    linear_op.callBoxed(&stack);
+    return stack.at(0).toTensor();
+}
 
-    Conv1d conv{nullptr};
-    SiLU activation{nullptr};
-};
+UnpaddedConvolutionImpl::UnpaddedConvolutionImpl(int size, int outsize, int k, int stride)
+        : kernel_size(k), conv_stride(stride) {
+    conv = register_module("conv", Conv1d(Conv1dOptions(size, outsize, k).stride(stride)));
+    activation = register_module("activation", SiLU());
+}
+
+at::Tensor UnpaddedConvolutionImpl::forward(const at::Tensor& x) {
+    if (!int8_conv) {
+        return activation(conv(x));
+    }
+    // Convolution as a matmul over the unfolded (N, T_out, C * k) input windows.
+    auto windows = x.unfold(2, kernel_size, conv_stride).permute({0, 2, 1, 3}).flatten(2);
+    return activation(int8_conv->forward(windows).permute({0, 2, 1}));
+}
 
-TORCH_MODULE(UnpaddedConvolution);
+void UnpaddedConvolutionImpl::quantize() {
+    const auto& weight = conv->weight;
+    if (weight.size(1) * weight.size(2) >= MIN_QUANTIZED_INPUT_SIZE) {
+        int8_conv.emplace(weight.flatten(1), conv->bias);
+    }
+}
 
 struct ModBaseConvModelImpl : Module {
     ModBaseConvModelImpl(int size, int kmer_len, int num_out) {
@@ -86,13 +148,21 @@ struct ModBaseConvModelImpl : Module {
         z = merge_conv4(z);
 
         z = z.flatten(1);
-        z = linear(z);
+        z = int8_linear ? int8_linear->forward(z) : linear(z);
 
         z = z.softmax(1);
 
         return z;
     }
 
+    void quantize() {
+        for (auto conv : {sig_conv1, sig_conv2, sig_conv3, seq_conv1, seq_conv2, seq_conv3,
+                           merge_conv1, merge_conv2, merge_conv3, merge_conv4}) {
+            conv->quantize();
+        }
+        int8_linear.emplace(linear->weight, linear->bias);
+    }
+
     void load_state_dict(const std::vector<at::Tensor>& weights) {
         utils::load_state_dict(*this, weights);
     }
@@ -114,6 +184,7 @@ struct ModBaseConvModelImpl : Module {
     UnpaddedConvolution merge_conv3{nullptr};
     UnpaddedConvolution merge_conv4{nullptr};
     Linear linear{nullptr};
+    std::optional<DynamicQuantizedLinear> int8_linear;
 };
 
 const std::vector<std::string> ModBaseConvModelImpl::weight_tensors{
@@ -169,21 +240,30 @@ struct ModBaseConvLSTMModelImpl : Module {
         z = merge_conv1(z);
         z = z.permute({2, 0, 1});
 
-        auto [z1, h1] = lstm1(z);
+        auto z1 = std::get<0>(lstm1(z));
         z1 = activation(z1);
 
         z1 = z1.flip(0);
-        auto [z2, h2] = lstm2(z1);
+        auto z2 = std::get<0>(lstm2(z1));
         z2 = activation(z2);
         z2 = z2.flip(0);
 
         z = z2.index({-1}).permute({0, 1});
-        z = linear(z);
+        z = int8_linear ? int8_linear->forward(z) : linear(z);
         z = z.softmax(1);
 
         return z;
     }
 
+    void quantize() {
+        // The LSTMs stay in fp32. An int8 LSTM has to step through time outside torch's fused
+        // LSTM kernel, which costs more than the int8 matmuls save.
+        for (auto conv : {sig_conv1, sig_conv2, sig_conv3, seq_conv1, seq_conv2, merge_conv1}) {
+            conv->quantize();
+        }
+        int8_linear.emplace(linear->weight, linear->bias);
+    }
+
     void load_state_dict(const std::vector<at::Tensor>& weights) {
         utils::load_state_dict(*this, weights);
     }
@@ -206,6 +286,8 @@ struct ModBaseConvLSTMModelImpl : Module {
 
     Linear linear{nullptr};
     SiLU activation{nullptr};
+
+    std::optional<DynamicQuantizedLinear> int8_linear;
 };
 
 const std::vector<std::string> ModBaseConvLSTMModelImpl::weight_tensors{
@@ -233,7 +315,8 @@ TORCH_MODULE(ModBaseConvLSTMModel);
 }  // namespace nn
 
 ModuleHolder<AnyModule> load_modbase_model(const std::filesystem::path& model_path,
-                                           at::TensorOptions options) {
+                                           at::TensorOptions options,
+                                           bool quantize) {
     auto config = toml::parse(model_path / "config.toml");
 
     const auto& general_params = toml::find(config, "general");
@@ -246,12 +329,12 @@ ModuleHolder<AnyModule> load_modbase_model(const std::filesystem::path& model_pa
 
     if (model_type == "conv_lstm") {
         auto model = nn::ModBaseConvLSTMModel(size, kmer_len, num_out);
-        return populate_model(model, model_path, options);
+        return populate_model(model, model_path, options, quantize);
     }
 
     if (model_type == "conv_only") {
         auto model = nn::ModBaseConvModel(size, kmer_len, num_out);
-        return populate_model(model, model_path, options);
+        return populate_model(model, model_path, options, quantize);
     }
 
     throw std::runtime_error("Unknown model type in config file.");
@@ -1,13 +1,52 @@
 #pragma once
 
+#include <ATen/core/ivalue.h>
 #include <torch/nn.h>
 
 #include <filesystem>
+#include <optional>
 
 namespace dorado::modbase {
 
+namespace nn {
+
+// A linear layer with int8 weights, quantised per output channel, which quantises its fp32
+// activations on the fly. CPU only.
+class DynamicQuantizedLinear {
+public:
+    DynamicQuantizedLinear() = default;
+    // bias may be undefined.
+    DynamicQuantizedLinear(const at::Tensor& weight, const at::Tensor& bias);
+
+    at::Tensor forward(const at::Tensor& x) const;
+
+private:
+    c10::IValue m_packed_params;
+};
+
+// Convolution without padding, followed by SiLU. Once quantized, convolutions with enough inputs
+// per output run as an int8 matmul over the unfolded input windows. CPU only once quantized.
+struct UnpaddedConvolutionImpl : torch::nn::Module {
+    UnpaddedConvolutionImpl(int size, int outsize, int k, int stride);
+    at::Tensor forward(const at::Tensor& x);
+    void quantize();
+
+    const int kernel_size;
+    const int conv_stride;
+    torch::nn::Conv1d conv{nullptr};
+    torch::nn::SiLU activation{nullptr};
+    std::optional<DynamicQuantizedLinear> int8_conv;
+};
+
+TORCH_MODULE(UnpaddedConvolution);
+
+}  // namespace nn
+
+// If quantize is set, the larger layers of a CPU model run with int8 weights, trading a little
+// accuracy for throughput.
 torch::nn::ModuleHolder<torch::nn::AnyModule> load_modbase_model(
         const std::filesystem::path& model_path,
-        at::TensorOptions options);
+        at::TensorOptions options,
+        bool quantize = false);
 
 }  // namespace dorado::modbase
@@ -4,18 +4,24 @@
 #include "utils/sequence_utils.h"
 
 #include <cxxpool.h>
-#include <edlib.h>
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <deque>
+#include <future>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 using namespace std::chrono_literals;
 namespace {
+
+// Pairs queued for calling per worker thread before reading waits for them.
+constexpr size_t MAX_PAIRS_IN_FLIGHT_PER_THREAD = 16;
+
 // Given two sequences, their quality scores, and alignments, computes a consensus sequence
 std::pair<std::vector<char>, std::vector<char>> compute_basespace_consensus(
         int alignment_start_position,
@@ -26,7 +32,7 @@ std::pair<std::vector<char>, std::vector<char>> compute_basespace_consensus(
         int query_cursor,
         const std::string_view target_sequence,
         const std::string_view query_sequence,
-        unsigned char* alignment) {
+        const unsigned char* alignment) {
     std::vector<char> consensus;
     std::vector<char> quality_scores_phred;
 
@@ -68,57 +74,81 @@ std::pair<std::vector<char>, std::vector<char>> compute_basespace_consensus(
 namespace dorado {
 
 void BaseSpaceDuplexCallerNode::worker_thread() {
+    // Reads which are waiting for their partner.
+    struct PendingRead {
+        std::shared_ptr<const SimplexRead> read;
+        std::string partner_id;
+    };
+    std::unordered_map<std::string, PendingRead> pending_reads;
+
     cxxpool::thread_pool pool{m_num_worker_threads};
-    std::vector<std::future<void>> futures;
+    // Bound the number of queued pairs, so that reading doesn't run far ahead of calling.
+    const size_t max_pairs_in_flight = m_num_worker_threads * MAX_PAIRS_IN_FLIGHT_PER_THREAD;
+    std::deque<std::future<void>> futures;
+
+    auto in_pairs = [this](const std::string& read_id) {
+        return m_pair_list.find_partner(read_id).has_value();
+    };
+    read_bam(*m_reader, in_pairs, [&](SimplexReadPtr simplex_read) {
+        std::string read_id = simplex_read->read_common.read_id;
+        auto partner = m_pair_list.find_partner(read_id);
+        std::shared_ptr<const SimplexRead> read = std::move(simplex_read);
+
+        std::shared_ptr<const SimplexRead> other_read;
+        if (partner->read_id == read_id) {
+            other_read = read;
+        } else {
+            auto pending_it = pending_reads.find(partner->read_id);
+            if (pending_it == pending_reads.end() ||
+                pending_it->second.partner_id != read_id) {
+                // The partner hasn't been read yet, or is itself paired with another read. Reads
+                // which appear more than once wait with their first copy.
+                pending_reads.try_emplace(std::move(read_id),
+                                          PendingRead{std::move(read), partner->read_id});
+                return;
+            }
+            other_read = std::move(pending_it->second.read);
+            pending_reads.erase(pending_it);
+        }
+
+        if (futures.size() >= max_pairs_in_flight) {
+            futures.front().get();
+            futures.pop_front();
+        }
+        auto template_read = partner->read_is_template ? read : other_read;
+        auto complement_read = partner->read_is_template ? other_read : read;
+        futures.push_back(pool.push([template_read, complement_read, this] {
+            return basespace(*template_read, *complement_read);
+        }));
+    });
 
-    futures.reserve(m_template_complement_map.size());
-    for (const auto& key : m_template_complement_map) {
-        futures.push_back(pool.push([key, this] { return basespace(key.first, key.second); }));
-    }
     for (auto& v : futures) {
         v.get();
     }
-}
 
-void BaseSpaceDuplexCallerNode::basespace(const std::string& template_read_id,
-                                          const std::string& complement_read_id) {
-    EdlibAlignConfig align_config = edlibDefaultAlignConfig();
-    align_config.task = EDLIB_TASK_PATH;
-
-    std::string_view template_sequence;
-    const SimplexRead* template_read;
-    std::vector<uint8_t> template_quality_scores;
-    auto template_read_it = m_reads.find(template_read_id);
-    if (template_read_it == m_reads.end()) {
-        spdlog::debug("Template Read ID={} is present in pairs file but read was not found",
-                      template_read_id);
-        return;
-    } else {
-        template_read = template_read_it->second.get();
-        template_sequence = template_read->read_common.seq;
-        template_quality_scores = std::vector<uint8_t>(template_read->read_common.qstring.begin(),
-                                                       template_read->read_common.qstring.end());
+    if (!pending_reads.empty()) {
+        spdlog::debug("{} reads were left unpaired, as their partners were not found",
+                      pending_reads.size());
     }
+}
+
+void BaseSpaceDuplexCallerNode::basespace(const SimplexRead& template_read,
+                                          const SimplexRead& complement_read) {
+    const std::string_view template_sequence = template_read.read_common.seq;
+    auto template_quality_scores = std::vector<uint8_t>(template_read.read_common.qstring.begin(),
+                                                        template_read.read_common.qstring.end());
 
     // For basespace, a q score filter is run over the quality scores.
     utils::preprocess_quality_scores(template_quality_scores);
 
-    auto complement_read_it = m_reads.find(complement_read_id);
-    if (complement_read_it == m_reads.end()) {
-        spdlog::debug("Complement ID={} paired with Template ID={} was not found",
-                      complement_read_id, template_read_id);
-        return;
-    }
-
     if (template_sequence.empty()) {
         return;
     }
 
     // We have both sequences and can perform the consensus
-    const SimplexRead* complement_read = complement_read_it->second.get();
     auto complement_quality_scores_reverse =
-            std::vector<uint8_t>(complement_read->read_common.qstring.begin(),
-                                 complement_read->read_common.qstring.end());
+            std::vector<uint8_t>(complement_read.read_common.qstring.begin(),
+                                 complement_read.read_common.qstring.end());
     std::reverse(complement_quality_scores_reverse.begin(),
                  complement_quality_scores_reverse.end());
 
@@ -127,31 +157,22 @@ void BaseSpaceDuplexCallerNode::basespace(const std::string& template_read_id,
 
     // Compute the RC
     auto complement_sequence_reverse_complement =
-            dorado::utils::reverse_complement(complement_read->read_common.seq);
-
-    EdlibAlignResult result =
-            edlibAlign(template_sequence.data(), int(template_sequence.size()),
-                       complement_sequence_reverse_complement.data(),
-                       int(complement_sequence_reverse_complement.size()), align_config);
-
-    // Now - we have to do the actual basespace alignment itself
-    int query_cursor = 0;
-    int target_cursor =
-            result.startLocations[0];  // 0-based position in the *target* where alignment starts.
+            dorado::utils::reverse_complement(complement_read.read_common.seq);
 
     // Adjust min consecutive wanted based on sequence lengths. If reads are short (< 500bp), use an overlap of 5, otherwise use 11.
     const int kMinNumConsecutiveWanted =
             (std::min(template_sequence.size(), complement_sequence_reverse_complement.size()) < 500
                      ? 5
                      : 11);
-    auto [alignment_start_end, cursors] = utils::get_trimmed_alignment(
-            kMinNumConsecutiveWanted, result.alignment, result.alignmentLength, target_cursor,
-            query_cursor, 0, result.endLocations[0]);
-
-    query_cursor = cursors.first;
-    target_cursor = cursors.second;
-    int start_alignment_position = alignment_start_end.first;
-    int end_alignment_position = alignment_start_end.second;
+    // Now - we have to do the actual basespace alignment itself
+    const auto trimmed = utils::get_trimmed_alignment(kMinNumConsecutiveWanted, template_sequence,
+                                                      complement_sequence_reverse_complement);
+    const auto& result = trimmed.alignment;
+    const int query_cursor = trimmed.query_cursor;
+    // 0-based position in the *target* where alignment starts.
+    const int target_cursor = trimmed.target_cursor;
+    const int start_alignment_position = trimmed.start_alignment_position;
+    const int end_alignment_position = trimmed.end_alignment_position;
 
     const int kMinTrimmedAlignmentLength =
             (std::min(template_sequence.size(), complement_sequence_reverse_complement.size()) < 500
@@ -165,7 +186,7 @@ void BaseSpaceDuplexCallerNode::basespace(const std::string& template_read_id,
         auto [consensus, quality_scores_phred] = compute_basespace_consensus(
                 start_alignment_position, end_alignment_position, template_quality_scores,
                 target_cursor, complement_quality_scores_reverse, query_cursor, template_sequence,
-                complement_sequence_reverse_complement, result.alignment);
+                complement_sequence_reverse_complement, result.alignment.data());
 
         auto duplex_read = std::make_unique<DuplexRead>();
         duplex_read->read_common.is_duplex = true;
@@ -174,26 +195,29 @@ void BaseSpaceDuplexCallerNode::basespace(const std::string& template_read_id,
                 std::string(quality_scores_phred.begin(), quality_scores_phred.end());
 
         duplex_read->read_common.read_id =
-                template_read->read_common.read_id + ";" + complement_read->read_common.read_id;
-        duplex_read->read_common.read_tag = template_read->read_common.read_tag;
+                template_read.read_common.read_id + ";" + complement_read.read_common.read_id;
+        duplex_read->read_common.read_tag = template_read.read_common.read_tag;
 
         send_message_to_sink(std::move(duplex_read));
     }
-    edlibFreeAlignResult(result);
 }
 
 BaseSpaceDuplexCallerNode::BaseSpaceDuplexCallerNode(
-        std::map<std::string, std::string> template_complement_map,
-        ReadMap reads,
+        utils::DuplexPairList pair_list,
+        const std::string& reads_file,
         size_t threads)
         : MessageSink(1000, 0),
           m_num_worker_threads(threads),
-          m_template_complement_map(std::move(template_complement_map)),
-          m_reads(std::move(reads)) {
+          m_pair_list(std::move(pair_list)),
+          m_reads_file(reads_file),
+          m_reader(std::make_unique<HtsReader>(m_reads_file, std::nullopt)) {
     start_threads();
 }
 
 void BaseSpaceDuplexCallerNode::start_threads() {
+    if (!m_reader) {
+        m_reader = std::make_unique<HtsReader>(m_reads_file, std::nullopt);
+    }
     m_worker_thread =
             std::make_unique<std::thread>(&BaseSpaceDuplexCallerNode::worker_thread, this);
 }
@@ -204,6 +228,7 @@ void BaseSpaceDuplexCallerNode::terminate_impl() {
         m_worker_thread->join();
     }
     m_worker_thread.reset();
+    m_reader.reset();
 }
 
 void BaseSpaceDuplexCallerNode::restart() {
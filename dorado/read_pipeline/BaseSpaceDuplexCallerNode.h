@@ -3,19 +3,22 @@
 #include "read_pipeline/HtsReader.h"
 #include "read_pipeline/MessageSink.h"
 #include "utils/bam_utils.h"
+#include "utils/duplex_pair_list.h"
 
-#include <map>
 #include <memory>
 #include <string>
 
 namespace dorado {
-// Duplex caller node receives a map of template_id to complement_id (typically generated from a pairs file),
-// and a map of `read_id` to `dorado::Read` object. It then performs duplex calling and pushes `dorado::Read`
-// objects to its output queue.
+// Duplex caller node receives the template/complement pairs (typically loaded from a pairs file),
+// and the SAM/BAM/CRAM file holding the reads. It streams the reads from the file, performs duplex
+// calling on each pair as soon as both of its reads have been read, and pushes `dorado::Read`
+// objects to its output queue. Each read is paired with the partner the pair list gives it, and is
+// only held until that pair has been called, so when the reads of each pair are close together in
+// the file, as they are in acquisition order, only a small part of it is in memory at once.
 class BaseSpaceDuplexCallerNode : public MessageSink {
 public:
-    BaseSpaceDuplexCallerNode(std::map<std::string, std::string> template_complement_map,
-                              ReadMap reads,
+    BaseSpaceDuplexCallerNode(utils::DuplexPairList pair_list,
+                              const std::string& reads_file,
                               size_t threads);
     ~BaseSpaceDuplexCallerNode() { terminate_impl(); }
     std::string get_name() const override { return "BaseSpaceDuplexCallerNode"; }
@@ -26,11 +29,13 @@ private:
     void start_threads();
     void terminate_impl();
     void worker_thread();
-    void basespace(const std::string& template_read_id, const std::string& complement_read_id);
+    void basespace(const SimplexRead& template_read, const SimplexRead& complement_read);
 
     size_t m_num_worker_threads{1};
     std::unique_ptr<std::thread> m_worker_thread;
-    std::map<std::string, std::string> m_template_complement_map;
-    const ReadMap m_reads;
+    const utils::DuplexPairList m_pair_list;
+    const std::string m_reads_file;
+    // Opened up front so that a bad file is reported by the constructor rather than the worker.
+    std::unique_ptr<HtsReader> m_reader;
 };
 }  // namespace dorado
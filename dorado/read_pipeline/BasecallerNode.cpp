@@ -3,8 +3,10 @@
 #include "basecall/CRFModelConfig.h"
 #include "basecall/ModelRunnerBase.h"
 #include "models/kits.h"
+#include "read_chunking.h"
 #include "read_utils.h"
 #include "stitch.h"
+#include "utils/math_utils.h"
 #include "utils/stats.h"
 
 #include <ATen/Functions.h>
@@ -14,6 +16,9 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <future>
+#include <numeric>
+#include <sstream>
 
 #if DORADO_METAL_BUILD
 #include "utils/metal_utils.h"
@@ -38,24 +43,71 @@ struct BasecallerNode::BasecallingChunk : utils::Chunk {
 };
 
 struct BasecallerNode::BasecallingRead {
-    Message read;                                              // The read itself.
-    std::vector<std::unique_ptr<utils::Chunk>> called_chunks;  // Vector of basecalled chunks.
-    std::atomic_size_t num_chunks_called;  // Number of chunks which have been basecalled.
+    Message read;       // The read itself.
+    size_t num_chunks;  // Number of chunks the read was split into.
+    std::unique_ptr<utils::ChunkStitcher> stitcher;  // Stitches called chunks as they arrive.
+    std::mutex stitcher_mutex;
+    std::chrono::steady_clock::time_point start_time;  // When the read entered the node.
 };
 
-size_t BasecallerNode::get_chunk_queue_idx(size_t read_raw_size) {
-    // A read goes either to the queue with the smallest chunk size which can fit the whole read,
-    // or, if the read is larger than all chunk sizes, the queue with the largest chunk size.
-    size_t best_idx = 0;
-    for (size_t i = 1; i < m_chunk_sizes.size(); ++i) {
-        size_t best_size = m_chunk_sizes[best_idx];
-        size_t this_size = m_chunk_sizes[i];
-        if ((best_size < read_raw_size && best_size < this_size) ||
-            (read_raw_size < this_size && this_size < best_size)) {
-            best_idx = i;
-        }
+struct BasecallerNode::InFlightBatch {
+    std::vector<std::unique_ptr<BasecallingChunk>> chunks;
+    std::future<std::vector<basecall::decode::DecodedChunk>> results;
+    dorado::stats::Timer timer;
+};
+
+uint64_t BasecallerNode::chunk_delay(const std::unique_ptr<BasecallingChunk> &chunk) {
+    // The chunks still to be called once this one is are the ones queued behind it, so the delay
+    // shrinks as the read nears completion. The stitcher holds any chunk called before those
+    // preceding it.
+    const auto &read = *chunk->owning_read;
+    return LOW_LATENCY_DELAY_PER_CHUNK * (read.num_chunks - 1 - chunk->idx_in_read);
+}
+
+void BasecallerNode::record_tail_size(size_t tail_size) {
+    // Only called from the input thread.
+    const size_t max_chunk_size = *std::max_element(m_chunk_sizes.begin(), m_chunk_sizes.end());
+    const size_t bin = std::min(tail_size * NUM_TAIL_SIZE_BINS / max_chunk_size,
+                                NUM_TAIL_SIZE_BINS - 1);
+    ++m_tail_size_hist[bin];
+}
+
+void BasecallerNode::report_suggested_chunk_sizes() const {
+    if (std::accumulate(m_tail_size_hist.begin(), m_tail_size_hist.end(), int64_t(0)) == 0) {
+        return;
+    }
+    const size_t max_chunk_size = *std::max_element(m_chunk_sizes.begin(), m_chunk_sizes.end());
+    const auto suggested = utils::suggest_chunk_sizes(
+            {m_tail_size_hist.begin(), m_tail_size_hist.end()}, max_chunk_size, m_model_stride,
+            std::max(m_chunk_sizes.size(), size_t{2}));
+    if (suggested.size() < 2) {
+        // A single chunk size already fits the reads best.
+        return;
+    }
+
+    // The largest chunk size is the one requested, and the rest are extra chunk sizes, which the
+    // CPU and CUDA runners use for simplex basecalling. The runners' chunk sizes are fixed before
+    // any reads are seen, so these are passed back in for subsequent runs on similar data.
+    std::ostringstream extra_chunk_sizes;
+    for (size_t i = 1; i < suggested.size(); ++i) {
+        extra_chunk_sizes << (i == 1 ? "" : ";") << suggested[i];
     }
-    return best_idx;
+    spdlog::info(
+            "{}: chunk sizes which best fit the read lengths seen are {} with "
+            "DORADO_EXTRA_CHUNK_SIZES=\"{}\" (simplex basecalling only)",
+            m_node_name, max_chunk_size, extra_chunk_sizes.str());
+}
+
+void BasecallerNode::record_read_latency(std::chrono::steady_clock::time_point start_time) {
+    const auto latency = std::chrono::steady_clock::now() - start_time;
+    const double latency_ms = std::chrono::duration<double, std::milli>(latency).count();
+    std::lock_guard lock(m_read_latency_mutex);
+    if (m_read_latencies_ms.size() < MAX_READ_LATENCY_SAMPLES) {
+        m_read_latencies_ms.push_back(latency_ms);
+    } else {
+        m_read_latencies_ms[m_next_read_latency_idx] = latency_ms;
+    }
+    m_next_read_latency_idx = (m_next_read_latency_idx + 1) % MAX_READ_LATENCY_SAMPLES;
 }
 
 void BasecallerNode::input_thread_fn() {
@@ -89,31 +141,30 @@ void BasecallerNode::input_thread_fn() {
         size_t raw_size =
                 read_common_data.raw_data
                         .sizes()[read_common_data.raw_data.sizes().size() - 1];  // Time dimension.
-        size_t chunk_queue_idx = get_chunk_queue_idx(raw_size);
-        size_t chunk_size = m_chunk_sizes[chunk_queue_idx];
+        size_t tail_size = 0;
+        const auto placements = utils::place_read_chunks(m_chunk_sizes, raw_size, m_overlap,
+                                                         m_model_stride, tail_size);
+        record_tail_size(tail_size);
+        if (placements.back().chunk_size_idx != placements.front().chunk_size_idx) {
+            ++m_num_tail_chunks_resized;
+        }
 
-        size_t offset = 0;
-        size_t chunk_in_read_idx = 0;
-        size_t signal_chunk_step = chunk_size - m_overlap;
+        const size_t num_chunks = placements.size();
         auto working_read = std::make_shared<BasecallingRead>();
         std::vector<std::unique_ptr<BasecallingChunk>> read_chunks;
-        read_chunks.emplace_back(std::make_unique<BasecallingChunk>(
-                working_read, offset, chunk_in_read_idx++, chunk_size));
-        size_t num_chunks = 1;
-        auto last_chunk_offset = raw_size - chunk_size;
-        auto misalignment = last_chunk_offset % m_model_stride;
-        if (misalignment != 0) {
-            // move last chunk start to the next stride boundary. we'll zero pad any excess samples required.
-            last_chunk_offset += m_model_stride - misalignment;
-        }
-        while (offset + chunk_size < raw_size) {
-            offset = std::min(offset + signal_chunk_step, last_chunk_offset);
+        std::vector<size_t> chunk_offsets;
+        read_chunks.reserve(num_chunks);
+        chunk_offsets.reserve(num_chunks);
+        for (size_t i = 0; i < num_chunks; ++i) {
             read_chunks.push_back(std::make_unique<BasecallingChunk>(
-                    working_read, offset, chunk_in_read_idx++, chunk_size));
-            ++num_chunks;
+                    working_read, placements[i].offset, i,
+                    m_chunk_sizes[placements[i].chunk_size_idx]));
+            chunk_offsets.push_back(placements[i].offset);
         }
-        working_read->called_chunks.resize(num_chunks);
-        working_read->num_chunks_called.store(0);
+        working_read->num_chunks = num_chunks;
+        working_read->stitcher = std::make_unique<utils::ChunkStitcher>(
+                std::move(chunk_offsets), raw_size, int(m_model_stride));
+        working_read->start_time = std::chrono::steady_clock::now();
         working_read->read = std::move(message);
 
         // Put the read in the working list
@@ -128,8 +179,8 @@ void BasecallerNode::input_thread_fn() {
         // push the chunks to the chunk queue
         // needs to be done after working_read->read is set as chunks could be processed
         // before we set that value otherwise
-        for (auto &chunk : read_chunks) {
-            m_chunk_in_queues[chunk_queue_idx]->try_push(std::move(chunk));
+        for (size_t i = 0; i < read_chunks.size(); ++i) {
+            m_chunk_in_queues[placements[i].chunk_size_idx]->try_push(std::move(read_chunks[i]));
         }
     }
 
@@ -142,25 +193,43 @@ void BasecallerNode::input_thread_fn() {
 void BasecallerNode::basecall_current_batch(int worker_id) {
     NVTX3_FUNC_RANGE();
     auto &model_runner = m_model_runners[worker_id];
-    dorado::stats::Timer timer;
     spdlog::trace("Basecalling batch T={}, N={}, chunks={}, worker={}", model_runner->chunk_size(),
                   model_runner->batch_size(), m_batched_chunks[worker_id].size(), worker_id);
-    auto decode_results = model_runner->call_chunks(int(m_batched_chunks[worker_id].size()));
+    auto batch = std::make_unique<InFlightBatch>();
+    batch->results = model_runner->call_chunks_async(int(m_batched_chunks[worker_id].size()));
+    batch->chunks = std::move(m_batched_chunks[worker_id]);
+    m_in_flight_batches[worker_id].push_back(std::move(batch));
     m_num_samples_incl_padding += model_runner->chunk_size() * model_runner->batch_size();
-    m_call_chunks_ms += timer.GetElapsedMS();
-
-    for (size_t i = 0; i < m_batched_chunks[worker_id].size(); i++) {
-        m_batched_chunks[worker_id][i]->seq = decode_results[i].sequence;
-        m_batched_chunks[worker_id][i]->qstring = decode_results[i].qstring;
-        m_batched_chunks[worker_id][i]->moves = decode_results[i].moves;
-    }
-
-    for (auto &complete_chunk : m_batched_chunks[worker_id]) {
-        m_processed_chunks.try_push(std::move(complete_chunk));
-    }
 
     m_batched_chunks[worker_id].clear();
     ++m_num_batches_called;
+
+    // Leave the runner a free input slab to accept the next batch into.
+    collect_called_batches(worker_id, model_runner->num_input_slabs() - 1);
+}
+
+void BasecallerNode::collect_called_batches(int worker_id, size_t max_in_flight) {
+    auto &in_flight_batches = m_in_flight_batches[worker_id];
+    while (!in_flight_batches.empty()) {
+        auto &batch = *in_flight_batches.front();
+        if (in_flight_batches.size() <= max_in_flight &&
+            batch.results.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            break;
+        }
+
+        auto decode_results = batch.results.get();
+        m_call_chunks_ms += batch.timer.GetElapsedMS();
+        for (size_t i = 0; i < batch.chunks.size(); i++) {
+            batch.chunks[i]->seq = std::move(decode_results[i].sequence);
+            batch.chunks[i]->qstring = std::move(decode_results[i].qstring);
+            batch.chunks[i]->moves = std::move(decode_results[i].moves);
+        }
+
+        for (auto &complete_chunk : batch.chunks) {
+            m_processed_chunks.try_push(std::move(complete_chunk));
+        }
+        in_flight_batches.pop_front();
+    }
 }
 
 void BasecallerNode::working_reads_manager() {
@@ -172,22 +241,27 @@ void BasecallerNode::working_reads_manager() {
 
         auto working_read = chunk->owning_read;
         auto idx_in_read = chunk->idx_in_read;
-        working_read->called_chunks[idx_in_read] = std::move(chunk);
-        auto num_chunks_called = ++working_read->num_chunks_called;
-        if (num_chunks_called == working_read->called_chunks.size()) {
+        bool all_chunks_stitched = false;
+        {
+            // Chunks of a read can be processed by several managers at once.
+            std::lock_guard stitcher_lock(working_read->stitcher_mutex);
+            all_chunks_stitched = working_read->stitcher->add_chunk(idx_in_read, std::move(chunk));
+        }
+        if (all_chunks_stitched) {
             // Finalise the read.
             auto source_read = std::move(working_read->read);
 
             ReadCommon &read_common_data = get_read_common_data(source_read);
 
-            // model_stride is needed by the basecall server and stitch_chunks.
+            // model_stride is needed by the basecall server.
             read_common_data.model_stride = m_model_runners[0]->config().stride;
 
             // qbias/qscale are expected by the basecall server.
             read_common_data.model_q_bias = m_model_runners[0]->config().qbias;
             read_common_data.model_q_scale = m_model_runners[0]->config().qscale;
 
-            utils::stitch_chunks(read_common_data, working_read->called_chunks);
+            working_read->stitcher->finalise(read_common_data);
+            working_read->stitcher.reset();
             read_common_data.model_name = m_model_name;
             read_common_data.mean_qscore_start_pos = m_mean_qscore_start_pos;
             read_common_data.pre_trim_seq_length = read_common_data.seq.length();
@@ -199,13 +273,11 @@ void BasecallerNode::working_reads_manager() {
             }
 
             // Update stats.
+            record_read_latency(working_read->start_time);
             ++m_called_reads_pushed;
             m_num_bases_processed += read_common_data.seq.length();
             m_num_samples_processed += read_common_data.get_raw_data_samples();
 
-            // Chunks have ownership of the working read, so destroy them to avoid a leak.
-            working_read->called_chunks.clear();
-
             // Do not trim R9.4.1 data to avoid changes to legacy products
             // Check here to avoid adding models lib as a dependency of utils
             if (read_common_data.chemistry != models::Chemistry::DNA_R9_4_1_E8) {
@@ -241,15 +313,29 @@ void BasecallerNode::basecall_worker_thread(int worker_id) {
 #endif
     at::InferenceMode inference_mode_guard;
 
-    auto last_chunk_reserve_time = std::chrono::system_clock::now();
+    auto last_chunk_reserve_time = std::chrono::steady_clock::now();
+    // Arrival time of the oldest read with a chunk in the current batch.
+    auto oldest_read_time = std::chrono::steady_clock::time_point::max();
     const size_t batch_size = m_model_runners[worker_id]->batch_size();
     const size_t chunk_size = m_model_runners[worker_id]->chunk_size();
-    const int batch_timeout_ms = m_model_runners[worker_id]->batch_timeout_ms();
+    const auto batch_timeout =
+            std::chrono::milliseconds(m_model_runners[worker_id]->batch_timeout_ms());
     const int chunk_queue_idx = worker_id % int(m_chunk_in_queues.size());
+    auto &chunk_queue = *m_chunk_in_queues[chunk_queue_idx];
     while (true) {
         std::unique_ptr<BasecallingChunk> chunk;
-        const auto pop_status = m_chunk_in_queues[chunk_queue_idx]->try_pop_until(
-                chunk, last_chunk_reserve_time + std::chrono::milliseconds(batch_timeout_ms));
+        utils::AsyncQueueStatus pop_status;
+        if (m_low_latency) {
+            // Flush a partial batch once its oldest read has waited for the batch timeout, rather
+            // than once no chunk has arrived for that long, so that a steady trickle of chunks
+            // can't hold a batch back. The queue puts chunks of short reads first.
+            const auto timeout_time = m_batched_chunks[worker_id].empty()
+                                              ? last_chunk_reserve_time + batch_timeout
+                                              : oldest_read_time + batch_timeout;
+            pop_status = chunk_queue.try_pop_until(chunk, timeout_time);
+        } else {
+            pop_status = chunk_queue.try_pop_until(chunk, last_chunk_reserve_time + batch_timeout);
+        }
 
         if (pop_status == utils::AsyncQueueStatus::Terminate) {
             break;
@@ -259,13 +345,19 @@ void BasecallerNode::basecall_worker_thread(int worker_id) {
             // try_pop_until timed out without getting a new chunk.
             if (!m_batched_chunks[worker_id].empty()) {
                 // get scores for whatever chunks are available.
+                ++m_num_partial_batches_called;
                 basecall_current_batch(worker_id);
+                oldest_read_time = std::chrono::steady_clock::time_point::max();
             }
+            // Nothing else is arriving, so don't hold back the results of earlier batches.
+            collect_called_batches(worker_id, 0);
 
-            last_chunk_reserve_time = std::chrono::system_clock::now();
+            last_chunk_reserve_time = std::chrono::steady_clock::now();
             continue;
         }
 
+        collect_called_batches(worker_id, m_model_runners[worker_id]->num_input_slabs() - 1);
+
         // There's chunks to get_scores, so let's add them to our input tensor
         // FIXME -- it should not be possible to for this condition to be untrue.
         if (m_batched_chunks[worker_id].size() != batch_size) {
@@ -294,20 +386,23 @@ void BasecallerNode::basecall_worker_thread(int worker_id) {
             m_model_runners[worker_id]->accept_chunk(
                     static_cast<int>(m_batched_chunks[worker_id].size()), input_slice);
 
+            oldest_read_time = std::min(oldest_read_time, chunk->owning_read->start_time);
             m_batched_chunks[worker_id].push_back(std::move(chunk));
 
-            last_chunk_reserve_time = std::chrono::system_clock::now();
+            last_chunk_reserve_time = std::chrono::steady_clock::now();
         }
 
         if (m_batched_chunks[worker_id].size() == batch_size) {
             // Input tensor is full, let's get_scores.
             basecall_current_batch(worker_id);
+            oldest_read_time = std::chrono::steady_clock::time_point::max();
         }
     }
 
     if (!m_batched_chunks[worker_id].empty()) {
         basecall_current_batch(worker_id);
     }
+    collect_called_batches(worker_id, 0);
 
     // Reduce the count of active runner threads.  If this was the last active
     // thread also send termination signal to sink
@@ -348,6 +443,7 @@ BasecallerNode::BasecallerNode(std::vector<basecall::RunnerPtr> model_runners,
           m_overlap(overlap),
           m_model_stride(m_model_runners.front()->config().stride),
           m_is_rna_model(is_rna_model(m_model_runners.front()->config())),
+          m_low_latency(m_model_runners.front()->is_low_latency()),
           m_model_name(std::move(model_name)),
           m_mean_qscore_start_pos(read_mean_qscore_start_pos),
           m_processed_chunks(CalcMaxChunksIn(m_model_runners)),
@@ -355,6 +451,7 @@ BasecallerNode::BasecallerNode(std::vector<basecall::RunnerPtr> model_runners,
     // Setup worker state
     const size_t num_workers = m_model_runners.size();
     m_batched_chunks.resize(num_workers);
+    m_in_flight_batches.resize(num_workers);
 
     for (auto &runner_ptr : m_model_runners) {
         // m_model_runners is effectively a 3D array with dimensions
@@ -369,9 +466,8 @@ BasecallerNode::BasecallerNode(std::vector<basecall::RunnerPtr> model_runners,
 
     auto chunk_queue_size = CalcMaxChunksIn(m_model_runners) / m_chunk_sizes.size();
     for (auto s : m_chunk_sizes) {
-        m_chunk_in_queues.push_back(
-                std::make_unique<utils::AsyncQueue<std::unique_ptr<BasecallingChunk>>>(
-                        chunk_queue_size));
+        m_chunk_in_queues.push_back(std::make_unique<ChunkQueue>(
+                chunk_queue_size, ChunkQueueItems(m_low_latency ? &chunk_delay : nullptr)));
         spdlog::debug("BasecallerNode chunk size {}", s);
     }
 
@@ -413,6 +509,7 @@ void BasecallerNode::terminate_impl() {
     }
     m_working_reads_managers.clear();
     termination_time = std::chrono::system_clock::now();
+    report_suggested_chunk_sizes();
 }
 
 void BasecallerNode::restart() {
@@ -438,9 +535,28 @@ stats::NamedStats BasecallerNode::sample_stats() const {
     stats["called_reads_pushed"] = double(m_called_reads_pushed);
     stats["working_reads_items"] = double(m_working_reads_size);
     stats["working_reads_signal_mb"] = double(m_working_reads_signal_bytes) / double((1024 * 1024));
+    size_t num_queued_chunks = 0;
+    for (const auto &chunk_queue : m_chunk_in_queues) {
+        num_queued_chunks += chunk_queue->size();
+    }
+    stats["queued_chunks"] = double(num_queued_chunks);
     stats["bases_processed"] = double(m_num_bases_processed);
     stats["samples_processed"] = double(m_num_samples_processed);
     stats["samples_incl_padding"] = double(m_num_samples_incl_padding);
+    stats["tail_chunks_resized"] = double(m_num_tail_chunks_resized);
+
+    // Time from a read entering the node to it being stitched, over the most recent reads.
+    std::vector<double> read_latencies_ms;
+    {
+        std::lock_guard lock(m_read_latency_mutex);
+        read_latencies_ms = m_read_latencies_ms;
+    }
+    const auto latency_quantiles = utils::quantiles(read_latencies_ms, {0.5, 0.9, 0.99});
+    if (latency_quantiles.size() == 3) {
+        stats["read_latency_ms_p50"] = latency_quantiles[0];
+        stats["read_latency_ms_p90"] = latency_quantiles[1];
+        stats["read_latency_ms_p99"] = latency_quantiles[2];
+    }
     return stats;
 }
 
@@ -4,14 +4,17 @@
 #include "utils/AsyncQueue.h"
 #include "utils/stats.h"
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace dorado {
@@ -24,6 +27,7 @@ using RunnerPtr = std::unique_ptr<ModelRunnerBase>;
 class BasecallerNode : public MessageSink {
     struct BasecallingRead;
     struct BasecallingChunk;
+    struct InFlightBatch;
 
 public:
     // Chunk size and overlap are in raw samples
@@ -48,10 +52,26 @@ private:
     void basecall_worker_thread(int worker_id);
     // Basecall batch of chunks
     void basecall_current_batch(int worker_id);
+    // Pass on the results of a worker's in flight batches which are ready, and wait for the oldest
+    // ones until no more than max_in_flight are left.
+    void collect_called_batches(int worker_id, size_t max_in_flight);
     // Construct complete reads
     void working_reads_manager();
 
-    size_t get_chunk_queue_idx(size_t read_raw_size);
+    // Record the number of samples needed by the last chunk of a read.
+    void record_tail_size(size_t tail_size);
+    // Log the chunk sizes which minimise padding for the tail sizes recorded so far.
+    void report_suggested_chunk_sizes() const;
+    // Ordering of chunks in the chunk queues for low latency basecalling: each chunk may be
+    // overtaken by chunks pushed up to chunk_delay(chunk) pushes after it, which is proportional to
+    // the number of chunks of its read after it. The last chunk of every read has no delay, so the
+    // final chunks of a read, and reads with few chunks, jump ahead of the earlier chunks of long
+    // reads which arrived shortly before them. Every chunk is still taken within a bounded number
+    // of pushes.
+    static constexpr uint64_t LOW_LATENCY_DELAY_PER_CHUNK = 8;
+    static uint64_t chunk_delay(const std::unique_ptr<BasecallingChunk> &chunk);
+    // Record the time taken to basecall a read.
+    void record_read_latency(std::chrono::steady_clock::time_point start_time);
 
     // Vector of model runners (each with their own GPU access etc)
     std::vector<basecall::RunnerPtr> m_model_runners;
@@ -61,6 +81,9 @@ private:
     size_t m_model_stride;
     // Whether the model is for rna
     bool m_is_rna_model;
+    // Whether the runners are set up for low latency basecalling, in which case chunks are
+    // prioritised to complete reads quickly and partial batches are flushed based on read age.
+    bool m_low_latency;
     // model_name
     std::string m_model_name;
     // Mean Q-score start position from model properties.
@@ -76,8 +99,15 @@ private:
     // Async queues to keep track of basecalling chunks. Each queue is for a different chunk size.
     // Basecall worker threads map to queue: `m_chunk_in_queues[worker_id % m_chunk_sizes.size()]`
     std::vector<size_t> m_chunk_sizes;
-    std::vector<std::unique_ptr<utils::AsyncQueue<std::unique_ptr<BasecallingChunk>>>>
-            m_chunk_in_queues;
+    // The queues are in push order unless m_low_latency is set, see chunk_delay.
+    using ChunkQueueItems = utils::DeadlineOrderedItems<std::unique_ptr<BasecallingChunk>>;
+    using ChunkQueue = utils::AsyncQueue<std::unique_ptr<BasecallingChunk>, ChunkQueueItems>;
+    std::vector<std::unique_ptr<ChunkQueue>> m_chunk_in_queues;
+
+    // Histogram of the number of samples needed by the last chunk of each read, binned over
+    // [0, largest chunk size). Used to suggest chunk sizes which minimise padding.
+    static constexpr size_t NUM_TAIL_SIZE_BINS = 64;
+    std::array<int64_t, NUM_TAIL_SIZE_BINS> m_tail_size_hist{};
 
     std::mutex m_working_reads_mutex;
     // Reads removed from input queue and being basecalled.
@@ -85,6 +115,8 @@ private:
 
     // If we go multi-threaded, there will be one of these batches per thread
     std::vector<std::vector<std::unique_ptr<BasecallingChunk>>> m_batched_chunks;
+    // Batches submitted to each worker's runner whose results haven't been collected, oldest first.
+    std::vector<std::deque<std::unique_ptr<InFlightBatch>>> m_in_flight_batches;
 
     utils::AsyncQueue<std::unique_ptr<BasecallingChunk>> m_processed_chunks;
 
@@ -107,6 +139,13 @@ private:
     std::atomic<int64_t> m_num_bases_processed = 0;
     std::atomic<int64_t> m_num_samples_processed = 0;
     std::atomic<int64_t> m_num_samples_incl_padding = 0;
+    std::atomic<int64_t> m_num_tail_chunks_resized = 0;
+
+    // Basecall latencies of the most recent reads, used as a ring buffer once full.
+    static constexpr size_t MAX_READ_LATENCY_SAMPLES = 10000;
+    mutable std::mutex m_read_latency_mutex;
+    std::vector<double> m_read_latencies_ms;
+    size_t m_next_read_latency_idx = 0;
     std::atomic<int64_t> m_working_reads_signal_bytes = 0;
 };
 
@@ -87,11 +87,24 @@ ReadMap read_bam(const std::string& filename, const std::unordered_set<std::stri
     HtsReader reader(filename, std::nullopt);
 
     ReadMap reads;
+    auto keep_read = [&read_ids](const std::string& read_id) {
+        return read_ids.find(read_id) != read_ids.end();
+    };
+    read_bam(reader, keep_read, [&reads](SimplexReadPtr read) {
+        auto read_id = read->read_common.read_id;
+        reads[std::move(read_id)] = std::move(read);
+    });
 
+    return reads;
+}
+
+void read_bam(HtsReader& reader,
+              const std::function<bool(const std::string&)>& keep_read,
+              const std::function<void(SimplexReadPtr)>& on_read) {
     while (reader.read()) {
         std::string read_id = bam_get_qname(reader.record);
 
-        if (read_ids.find(read_id) == read_ids.end()) {
+        if (!keep_read(read_id)) {
             continue;
         }
 
@@ -112,10 +125,8 @@ ReadMap read_bam(const std::string& filename, const std::unordered_set<std::stri
         tmp_read->read_common.read_id = read_id;
         tmp_read->read_common.seq = std::string(nucleotides.begin(), nucleotides.end());
         tmp_read->read_common.qstring = std::string(qualities.begin(), qualities.end());
-        reads[read_id] = std::move(tmp_read);
+        on_read(std::move(tmp_read));
     }
-
-    return reads;
 }
 
 std::unordered_set<std::string> fetch_read_ids(const std::string& filename) {
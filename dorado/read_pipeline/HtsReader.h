@@ -8,6 +8,7 @@
 #include <htslib/sam.h>
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -84,6 +85,22 @@ T HtsReader::get_tag(const char* tagname) {
  */
 ReadMap read_bam(const std::string& filename, const std::unordered_set<std::string>& read_ids);
 
+/**
+ * @brief Reads the remaining records of an open SAM/BAM/CRAM file, passing each one to on_read as
+ * a Read object as soon as it's read.
+ *
+ * Unlike the overload which returns a ReadMap, this never holds more than one read, so the
+ * caller decides how long each read is kept.
+ *
+ * @param reader The reader for the input file.
+ * @param keep_read Returns whether the read with the given read_id is wanted. Other records are
+ * skipped without being decoded.
+ * @param on_read Called with each read in file order.
+ */
+void read_bam(HtsReader& reader,
+              const std::function<bool(const std::string&)>& keep_read,
+              const std::function<void(SimplexReadPtr)>& on_read);
+
 /**
  * @brief Reads an HTS file format (SAM/BAM/FASTX/etc) and returns a set of read ids.
  *
@@ -4,6 +4,7 @@
 #include "modbase/ModBaseModelConfig.h"
 #include "modbase/ModBaseRunner.h"
 #include "modbase/ModbaseEncoder.h"
+#include "utils/dev_utils.h"
 #include "utils/math_utils.h"
 #include "utils/sequence_utils.h"
 #include "utils/stats.h"
@@ -14,15 +15,19 @@
 #include <nvtx3/nvtx3.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <iostream>
+#include <optional>
 
 using namespace std::chrono_literals;
 
 namespace dorado {
 
-constexpr auto FORCE_TIMEOUT = 100ms;
+constexpr auto DEFAULT_MAX_BATCH_AGE = 500ms;
+// Input threads wait once a caller has this many batches of chunks pending.
+constexpr size_t MAX_PENDING_BATCHES = 5;
 
 struct ModBaseCallerNode::RemoraChunk {
     RemoraChunk(std::shared_ptr<WorkingRead> read,
@@ -42,6 +47,7 @@ struct ModBaseCallerNode::RemoraChunk {
     size_t context_hit;
     std::vector<float> scores;
     bool is_template_direction;
+    std::chrono::steady_clock::time_point enqueue_time;
 };
 
 struct ModBaseCallerNode::WorkingRead {
@@ -58,14 +64,16 @@ ModBaseCallerNode::ModBaseCallerNode(std::vector<modbase::RunnerPtr> model_runne
         : MessageSink(max_reads, static_cast<int>(remora_threads)),
           m_runners(std::move(model_runners)),
           m_block_stride(block_stride),
-          m_batch_size(m_runners[0]->batch_size()),
           // TODO -- more principled calculation of output queue size
-          m_processed_chunks(10 * max_reads) {
+          m_processed_chunks(10 * max_reads),
+          m_pending_chunks(m_runners[0]->num_callers()),
+          m_caller_busy(m_runners.size(), std::vector<bool>(m_runners[0]->num_callers(), false)),
+          m_max_batch_age(utils::get_dev_opt<int>("modbase_max_batch_age_ms",
+                                                  int(DEFAULT_MAX_BATCH_AGE.count()))) {
     init_modbase_info();
-    for (size_t i = 0; i < m_runners[0]->num_callers(); i++) {
-        m_chunk_queues.emplace_back(
-                std::make_unique<utils::AsyncQueue<std::unique_ptr<RemoraChunk>>>(m_batch_size *
-                                                                                  5));
+    init_scaling_groups();
+    for (size_t caller_id = 0; caller_id < m_runners[0]->num_callers(); ++caller_id) {
+        m_batch_sizes.push_back(m_runners[0]->batch_size(caller_id));
     }
 
     // Spin up the processing threads:
@@ -78,9 +86,10 @@ void ModBaseCallerNode::start_threads() {
     m_output_worker = std::make_unique<std::thread>(&ModBaseCallerNode::output_worker_thread, this);
 
     for (size_t worker_id = 0; worker_id < m_runners.size(); ++worker_id) {
+        // One worker per caller, so that each runner can still have every model in flight at once.
         for (size_t model_id = 0; model_id < m_runners[worker_id]->num_callers(); ++model_id) {
             auto t = std::make_unique<std::thread>(&ModBaseCallerNode::modbasecall_worker_thread,
-                                                   this, worker_id, model_id);
+                                                   this, worker_id);
             m_runner_workers.push_back(std::move(t));
             ++m_num_active_runner_workers;
         }
@@ -91,11 +100,13 @@ void ModBaseCallerNode::start_threads() {
 void ModBaseCallerNode::terminate_impl() {
     // Signal termination in the input queue, and wait for input threads to join.
     stop_input_processing();
-    // Signal termination in the chunk queues.
-    for (auto& chunk_queue : m_chunk_queues) {
-        chunk_queue->terminate();
+    // Signal termination to the batch packer.
+    {
+        std::lock_guard lock(m_pending_chunks_mutex);
+        m_terminate_pending_chunks = true;
     }
-    // Wait for runner workers to join, now that they have been asked to via chunk queue
+    m_pending_chunks_cv.notify_all();
+    // Wait for runner workers to join, now that they have been asked to via the batch packer
     // termination.
     for (auto& t : m_runner_workers) {
         if (t->joinable()) {
@@ -113,8 +124,9 @@ void ModBaseCallerNode::restart() {
     for (auto& runner : m_runners) {
         runner->restart();
     }
-    for (auto& chunk_queue : m_chunk_queues) {
-        chunk_queue->restart();
+    {
+        std::lock_guard lock(m_pending_chunks_mutex);
+        m_terminate_pending_chunks = false;
     }
     m_processed_chunks.restart();
     start_threads();
@@ -143,26 +155,64 @@ void ModBaseCallerNode::init_modbase_info() {
     m_base_prob_offsets[3] = m_base_prob_offsets[2] + result.base_counts[2];
 }
 
+void ModBaseCallerNode::init_scaling_groups() {
+    auto& runner = m_runners[0];
+    const auto same_scaling = [&runner](size_t caller_a, size_t caller_b) {
+        const auto& a = runner->caller_params(caller_a);
+        const auto& b = runner->caller_params(caller_b);
+        if (a.reverse_signal != b.reverse_signal ||
+            a.refine_do_rough_rescale != b.refine_do_rough_rescale) {
+            return false;
+        }
+        return !a.refine_do_rough_rescale ||
+               (a.refine_kmer_len == b.refine_kmer_len &&
+                a.refine_kmer_center_idx == b.refine_kmer_center_idx &&
+                a.refine_kmer_levels == b.refine_kmer_levels);
+    };
+
+    m_caller_scaling_groups.resize(runner->num_callers());
+    m_num_scaling_groups = 0;
+    for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
+        auto& group = m_caller_scaling_groups[caller_id];
+        group = m_num_scaling_groups;
+        for (size_t prev_id = 0; prev_id < caller_id; ++prev_id) {
+            if (same_scaling(caller_id, prev_id)) {
+                group = m_caller_scaling_groups[prev_id];
+                break;
+            }
+        }
+        if (group == m_num_scaling_groups) {
+            ++m_num_scaling_groups;
+        }
+    }
+}
+
+void ModBaseCallerNode::init_base_mod_probs(ReadCommon& read_common,
+                                            std::vector<uint32_t> context_hits) const {
+    nvtx3::scoped_range range{"base_mod_probs_init"};
+    // Different callers, or the two strands of a duplex read, can hit the same base.
+    std::sort(context_hits.begin(), context_hits.end());
+    context_hits.erase(std::unique(context_hits.begin(), context_hits.end()), context_hits.end());
+
+    utils::SparseModBaseProbs probs(m_num_states, std::move(context_hits));
+    for (size_t row_idx = 0; row_idx < probs.size(); ++row_idx) {
+        // Initialize for what corresponds to 100% canonical base for each position.
+        int base_id = utils::BaseInfo::BASE_IDS[read_common.seq[probs.positions()[row_idx]]];
+        if (base_id < 0) {
+            throw std::runtime_error("Invalid character in sequence.");
+        }
+        probs.row(row_idx)[m_base_prob_offsets[base_id]] = 1;
+    }
+    read_common.base_mod_probs.clear();
+    read_common.sparse_base_mod_probs = std::move(probs);
+}
+
 void ModBaseCallerNode::duplex_mod_call(Message&& message) {
     // Let's do this only for the template strand for now.
 
     auto read = std::get<DuplexReadPtr>(std::move(message));
     stats::Timer timer;
 
-    {
-        nvtx3::scoped_range range{"base_mod_probs_init"};
-        // initialize base_mod_probs _before_ we start handing out chunks
-        read->read_common.base_mod_probs.resize(read->read_common.seq.size() * m_num_states, 0);
-        for (size_t i = 0; i < read->read_common.seq.size(); ++i) {
-            // Initialize for what corresponds to 100% canonical base for each position.
-            int base_id = utils::BaseInfo::BASE_IDS[read->read_common.seq[i]];
-            if (base_id < 0) {
-                throw std::runtime_error("Invalid character in sequence.");
-            }
-            read->read_common.base_mod_probs[i * m_num_states + m_base_prob_offsets[base_id]] = 1;
-        }
-    }
-
     read->read_common.mod_base_info = m_mod_base_info;
 
     try {
@@ -175,7 +225,7 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
         std::vector<std::vector<std::unique_ptr<RemoraChunk>>> chunks_to_enqueue_by_caller(
                 runner->num_callers());
 
-        std::vector<unsigned long> all_context_hits;
+        std::vector<uint32_t> all_context_hits;
 
         for (const bool is_template_direction : {true, false}) {
             auto simplex_signal =
@@ -215,17 +265,29 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
             // no reverse_signal in duplex, so we can do this once for all callers
             std::vector<uint64_t> seq_to_sig_map =
                     utils::moves_to_map(new_move_table, m_block_stride, signal_len, num_moves + 1);
+            const auto caller_context_hits = runner->get_all_motif_hits(new_seq);
+            auto signal = simplex_signal.slice(0, moves_offset * m_block_stride,
+                                               moves_offset * m_block_stride + signal_len);
+            // The scaled signal for each scaling group, shared by the callers in the group.
+            std::vector<at::Tensor> scaled_signals(m_num_scaling_groups);
 
             for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
                 nvtx3::scoped_range range{"generate_chunks"};
+                const auto& context_hits = caller_context_hits[caller_id];
+                m_num_context_hits += static_cast<int64_t>(context_hits.size());
+                if (context_hits.empty()) {
+                    continue;
+                }
+
                 auto& chunks_to_enqueue = chunks_to_enqueue_by_caller.at(caller_id);
                 auto& params = runner->caller_params(caller_id);
-                auto signal = simplex_signal.slice(0, moves_offset * m_block_stride,
-                                                   moves_offset * m_block_stride + signal_len);
 
                 // scale signal based on model parameters
-                auto scaled_signal =
-                        runner->scale_signal(caller_id, signal, sequence_ints, seq_to_sig_map);
+                auto& scaled_signal = scaled_signals[m_caller_scaling_groups[caller_id]];
+                if (!scaled_signal.defined()) {
+                    scaled_signal =
+                            runner->scale_signal(caller_id, signal, sequence_ints, seq_to_sig_map);
+                }
 
                 auto context_samples = (params.context_before + params.context_after);
 
@@ -234,8 +296,6 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
                                                 params.bases_before, params.bases_after);
                 encoder.init(sequence_ints, seq_to_sig_map);
 
-                auto context_hits = runner->get_motif_hits(caller_id, new_seq);
-                m_num_context_hits += static_cast<int64_t>(context_hits.size());
                 chunks_to_enqueue.reserve(context_hits.size());
 
                 for (auto context_hit : context_hits) {
@@ -264,12 +324,14 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
                             working_read, input_signal, std::move(slice.data),
                             context_hit_in_duplex_space, is_template_direction));
 
-                    all_context_hits.push_back(context_hit_in_duplex_space);
+                    all_context_hits.push_back(uint32_t(context_hit_in_duplex_space));
                     ++working_read->num_modbase_chunks;
                 }
             }
         }
 
+        // Initialise the results _before_ we start handing out chunks.
+        init_base_mod_probs(read->read_common, std::move(all_context_hits));
         m_chunk_generation_ms += timer.GetElapsedMS();
 
         if (working_read->num_modbase_chunks != 0) {
@@ -283,16 +345,10 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
                 ++m_working_reads_size;
             }
 
-            // push the chunks to the chunk queues
+            // push the chunks to the batch packer
             // needs to be done after working_read->read is set as chunks could be processed
             // before we set that value otherwise
-            for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
-                auto& chunk_queue = m_chunk_queues.at(caller_id);
-                auto& chunks_to_enqueue = chunks_to_enqueue_by_caller.at(caller_id);
-                for (auto& chunk : chunks_to_enqueue) {
-                    chunk_queue->try_push(std::move(chunk));
-                }
-            }
+            push_chunks(chunks_to_enqueue_by_caller);
         } else {
             // No modbases to call, pass directly to next node
             send_message_to_sink(std::move(read));
@@ -306,19 +362,6 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
 void ModBaseCallerNode::simplex_mod_call(Message&& message) {
     auto read = std::get<SimplexReadPtr>(std::move(message));
     stats::Timer timer;
-    {
-        nvtx3::scoped_range range{"base_mod_probs_init"};
-        // initialize base_mod_probs _before_ we start handing out chunks
-        read->read_common.base_mod_probs.resize(read->read_common.seq.size() * m_num_states, 0);
-        for (size_t i = 0; i < read->read_common.seq.size(); ++i) {
-            // Initialize for what corresponds to 100% canonical base for each position.
-            int base_id = utils::BaseInfo::BASE_IDS[read->read_common.seq[i]];
-            if (base_id < 0) {
-                throw std::runtime_error("Invalid character in sequence.");
-            }
-            read->read_common.base_mod_probs[i * m_num_states + m_base_prob_offsets[base_id]] = 1;
-        }
-    }
     read->read_common.mod_base_info = m_mod_base_info;
 
     auto working_read = std::make_shared<WorkingRead>();
@@ -331,37 +374,64 @@ void ModBaseCallerNode::simplex_mod_call(Message&& message) {
     auto& runner = m_runners[0];
     std::vector<std::vector<std::unique_ptr<RemoraChunk>>> chunks_to_enqueue_by_caller(
             runner->num_callers());
+    const auto caller_context_hits = runner->get_all_motif_hits(read->read_common.seq);
+    std::vector<uint32_t> all_context_hits;
+    for (const auto& context_hits : caller_context_hits) {
+        all_context_hits.insert(all_context_hits.end(), context_hits.begin(), context_hits.end());
+    }
+    // Initialise the results _before_ we start handing out chunks.
+    init_base_mod_probs(read->read_common, std::move(all_context_hits));
+
+    // The signal inputs are the same for every caller, other than the scaling, so are derived
+    // once here for all of them. Each scaled signal is shared by the callers of a scaling group,
+    // and the chunks keep slices of it alive until they're called.
+    auto signal_len = read->read_common.get_raw_data_samples();
+    const auto forward_seq_to_sig_map = utils::moves_to_map(
+            read->read_common.moves, m_block_stride, signal_len, read->read_common.seq.size() + 1);
+    std::vector<at::Tensor> scaled_signals(m_num_scaling_groups);
+    std::vector<uint64_t> reversed_seq_to_sig_map;
+
     for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
         nvtx3::scoped_range range{"generate_chunks"};
-
-        auto signal_len = read->read_common.get_raw_data_samples();
-        std::vector<uint64_t> seq_to_sig_map =
-                utils::moves_to_map(read->read_common.moves, m_block_stride, signal_len,
-                                    read->read_common.seq.size() + 1);
+        const auto& context_hits = caller_context_hits[caller_id];
+        m_num_context_hits += static_cast<int64_t>(context_hits.size());
+        if (context_hits.empty()) {
+            continue;
+        }
 
         auto& chunks_to_enqueue = chunks_to_enqueue_by_caller.at(caller_id);
         auto& params = runner->caller_params(caller_id);
-        auto signal = read->read_common.raw_data;
+        const auto* seq_to_sig_map = &forward_seq_to_sig_map;
         if (params.reverse_signal) {
-            signal = at::flip(signal, 0);
-            std::reverse(std::begin(seq_to_sig_map), std::end(seq_to_sig_map));
-            std::transform(std::begin(seq_to_sig_map), std::end(seq_to_sig_map),
-                           std::begin(seq_to_sig_map),
-                           [signal_len](auto signal_pos) { return signal_len - signal_pos; });
+            if (reversed_seq_to_sig_map.empty()) {
+                reversed_seq_to_sig_map = *seq_to_sig_map;
+                std::reverse(std::begin(reversed_seq_to_sig_map),
+                             std::end(reversed_seq_to_sig_map));
+                std::transform(std::begin(reversed_seq_to_sig_map),
+                               std::end(reversed_seq_to_sig_map),
+                               std::begin(reversed_seq_to_sig_map),
+                               [signal_len](auto signal_pos) { return signal_len - signal_pos; });
+            }
+            seq_to_sig_map = &reversed_seq_to_sig_map;
         }
 
         // scale signal based on model parameters
-        auto scaled_signal = runner->scale_signal(caller_id, signal, sequence_ints, seq_to_sig_map);
+        auto& scaled_signal = scaled_signals[m_caller_scaling_groups[caller_id]];
+        if (!scaled_signal.defined()) {
+            auto signal = read->read_common.raw_data;
+            if (params.reverse_signal) {
+                signal = at::flip(signal, 0);
+            }
+            scaled_signal = runner->scale_signal(caller_id, signal, sequence_ints, *seq_to_sig_map);
+        }
 
         auto context_samples = (params.context_before + params.context_after);
 
         // One-hot encodes the kmer at each signal step for input into the network
         modbase::ModBaseEncoder encoder(m_block_stride, context_samples, params.bases_before,
                                         params.bases_after);
-        encoder.init(sequence_ints, seq_to_sig_map);
+        encoder.init(sequence_ints, *seq_to_sig_map);
 
-        auto context_hits = runner->get_motif_hits(caller_id, read->read_common.seq);
-        m_num_context_hits += static_cast<int64_t>(context_hits.size());
         chunks_to_enqueue.reserve(context_hits.size());
         for (auto context_hit : context_hits) {
             nvtx3::scoped_range nvtxrange{"create_chunk"};
@@ -393,16 +463,10 @@ void ModBaseCallerNode::simplex_mod_call(Message&& message) {
             ++m_working_reads_size;
         }
 
-        // push the chunks to the chunk queues
+        // push the chunks to the batch packer
         // needs to be done after working_read->read is set as chunks could be processed
         // before we set that value otherwise
-        for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
-            auto& chunk_queue = m_chunk_queues.at(caller_id);
-            auto& chunks_to_enqueue = chunks_to_enqueue_by_caller.at(caller_id);
-            for (auto& chunk : chunks_to_enqueue) {
-                chunk_queue->try_push(std::move(chunk));
-            }
-        }
+        push_chunks(chunks_to_enqueue_by_caller);
     } else {
         // No modbases to call, pass directly to next node
         send_message_to_sink(std::move(read));
@@ -426,58 +490,129 @@ void ModBaseCallerNode::input_thread_fn() {
     }
 }
 
-void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t caller_id) {
-    at::InferenceMode inference_mode_guard;
-
-    auto& runner = m_runners[worker_id];
-    auto& chunk_queue = m_chunk_queues[caller_id];
+void ModBaseCallerNode::push_chunks(
+        std::vector<std::vector<std::unique_ptr<RemoraChunk>>>& chunks_by_caller) {
+    for (size_t caller_id = 0; caller_id < chunks_by_caller.size(); ++caller_id) {
+        auto& chunks_to_enqueue = chunks_by_caller[caller_id];
+        auto& pending_chunks = m_pending_chunks[caller_id];
+        const auto max_pending_chunks = m_batch_sizes[caller_id] * MAX_PENDING_BATCHES;
+        auto chunk_it = chunks_to_enqueue.begin();
+        while (chunk_it != chunks_to_enqueue.end()) {
+            std::unique_lock lock(m_pending_chunks_mutex);
+            if (pending_chunks.size() >= max_pending_chunks && !m_terminate_pending_chunks) {
+                ++m_num_input_chunks_sleeps;
+                m_pending_chunks_cv.wait(lock, [&] {
+                    return pending_chunks.size() < max_pending_chunks ||
+                           m_terminate_pending_chunks;
+                });
+            }
+            // Move as many chunks as there is room for with one acquisition of the mutex. Once
+            // terminating the workers drain whatever is pending, so there is no limit.
+            const auto now = std::chrono::steady_clock::now();
+            while (chunk_it != chunks_to_enqueue.end() &&
+                   (pending_chunks.size() < max_pending_chunks || m_terminate_pending_chunks)) {
+                (*chunk_it)->enqueue_time = now;
+                pending_chunks.push_back(std::move(*chunk_it));
+                ++chunk_it;
+            }
+            lock.unlock();
+            m_pending_chunks_cv.notify_all();
+        }
+    }
+}
 
-    std::vector<std::unique_ptr<RemoraChunk>> batched_chunks;
-    auto last_chunk_reserve_time = std::chrono::system_clock::now();
+bool ModBaseCallerNode::pack_next_batch(size_t worker_id,
+                                        size_t& caller_id,
+                                        std::vector<std::unique_ptr<RemoraChunk>>& batched_chunks) {
+    nvtx3::scoped_range range{"pack_next_batch"};
+    auto& caller_busy = m_caller_busy[worker_id];
 
-    size_t previous_chunk_count = 0;
+    std::unique_lock lock(m_pending_chunks_mutex);
     while (true) {
-        nvtx3::scoped_range range{"modbasecall_worker_thread"};
-        // Repeatedly attempt to complete the current batch with one acquisition of the
-        // chunk queue mutex.
-        auto grab_chunk = [&batched_chunks](std::unique_ptr<RemoraChunk> chunk) {
-            batched_chunks.push_back(std::move(chunk));
-        };
-        const auto status = chunk_queue->process_and_pop_n_with_timeout(
-                grab_chunk, m_batch_size - batched_chunks.size(),
-                last_chunk_reserve_time + FORCE_TIMEOUT);
-        if (status == utils::AsyncQueueStatus::Terminate) {
-            break;
+        const auto now = std::chrono::steady_clock::now();
+        auto next_deadline = std::chrono::steady_clock::time_point::max();
+        std::optional<size_t> best_caller;
+        bool best_is_full = false;
+        std::chrono::steady_clock::time_point best_enqueue_time;
+        bool any_pending = false;
+        for (size_t id = 0; id < m_pending_chunks.size(); ++id) {
+            const auto& pending_chunks = m_pending_chunks[id];
+            if (pending_chunks.empty()) {
+                continue;
+            }
+            any_pending = true;
+            if (caller_busy[id]) {
+                continue;
+            }
+            // Full batches are always preferred. Partial batches are called once they are too old
+            // to wait any longer for more chunks, or when there will be no more chunks.
+            const bool is_full = pending_chunks.size() >= m_batch_sizes[id];
+            const auto deadline = pending_chunks.front()->enqueue_time + m_max_batch_age;
+            if (!is_full && deadline > now && !m_terminate_pending_chunks) {
+                next_deadline = std::min(next_deadline, deadline);
+                continue;
+            }
+            const auto enqueue_time = pending_chunks.front()->enqueue_time;
+            if (!best_caller || (is_full && !best_is_full) ||
+                (is_full == best_is_full && enqueue_time < best_enqueue_time)) {
+                best_caller = id;
+                best_is_full = is_full;
+                best_enqueue_time = enqueue_time;
+            }
         }
 
-        // Reset timeout.
-        last_chunk_reserve_time = std::chrono::system_clock::now();
-
-        // We have just grabbed a number of chunks (0 in the case of timeout) from
-        // the chunk queue and added them to batched_chunks.  Insert those chunks
-        // into the model input tensors.
-        for (size_t chunk_idx = previous_chunk_count; chunk_idx < batched_chunks.size();
-             ++chunk_idx) {
-            assert(chunk_idx < m_batch_size);
-            const auto& chunk = batched_chunks[chunk_idx];
-            runner->accept_chunk(int(caller_id), int(chunk_idx), chunk->signal,
-                                 chunk->encoded_kmers);
+        if (best_caller) {
+            caller_id = *best_caller;
+            auto& pending_chunks = m_pending_chunks[caller_id];
+            const auto num_chunks = std::min(pending_chunks.size(), m_batch_sizes[caller_id]);
+            for (size_t i = 0; i < num_chunks; ++i) {
+                batched_chunks.push_back(std::move(pending_chunks.front()));
+                pending_chunks.pop_front();
+            }
+            caller_busy[caller_id] = true;
+            lock.unlock();
+            // Wake any input threads waiting for room.
+            m_pending_chunks_cv.notify_all();
+            return true;
         }
 
-        // If we have a complete batch, or we have a partial batch and timed out,
-        // then call what we have.
-        if (batched_chunks.size() == m_batch_size ||
-            (status == utils::AsyncQueueStatus::Timeout && !batched_chunks.empty())) {
-            // Input tensor is full, let's get scores.
-            call_current_batch(worker_id, caller_id, batched_chunks);
+        if (m_terminate_pending_chunks && !any_pending) {
+            return false;
         }
 
-        previous_chunk_count = batched_chunks.size();
+        if (next_deadline == std::chrono::steady_clock::time_point::max()) {
+            m_pending_chunks_cv.wait(lock);
+        } else {
+            m_pending_chunks_cv.wait_until(lock, next_deadline);
+        }
     }
+}
+
+void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id) {
+    at::InferenceMode inference_mode_guard;
+
+    auto& runner = m_runners[worker_id];
+
+    std::vector<std::unique_ptr<RemoraChunk>> batched_chunks;
+    size_t caller_id = 0;
+    while (pack_next_batch(worker_id, caller_id, batched_chunks)) {
+        nvtx3::scoped_range range{"modbasecall_worker_thread"};
+        // Insert the chunks into the model input tensors for the chosen caller.
+        for (size_t chunk_idx = 0; chunk_idx < batched_chunks.size(); ++chunk_idx) {
+            assert(chunk_idx < m_batch_sizes[caller_id]);
+            const auto& chunk = batched_chunks[chunk_idx];
+            runner->accept_chunk(int(caller_id), int(chunk_idx), chunk->signal,
+                                 chunk->encoded_kmers);
+        }
 
-    // Basecall any remaining chunks.
-    if (!batched_chunks.empty()) {
         call_current_batch(worker_id, caller_id, batched_chunks);
+
+        // The caller's input tensors are free for another batch.
+        {
+            std::lock_guard lock(m_pending_chunks_mutex);
+            m_caller_busy[worker_id][caller_id] = false;
+        }
+        m_pending_chunks_cv.notify_all();
     }
 
     // Reduce the count of active model callers.  If this was the last active
@@ -505,6 +640,7 @@ void ModBaseCallerNode::call_current_batch(
     const auto* const results_f32_ptr = results_f32.data_ptr<float>();
 
     auto row_size = results.size(1);
+    const auto num_chunks = batched_chunks.size();
 
     // Put results into chunk
     for (size_t i = 0; i < batched_chunks.size(); ++i) {
@@ -516,6 +652,11 @@ void ModBaseCallerNode::call_current_batch(
 
     batched_chunks.clear();
     ++m_num_batches_called;
+    m_num_chunks_called += int64_t(num_chunks);
+    m_num_batch_slots_called += int64_t(m_batch_sizes[caller_id]);
+    if (num_chunks < m_batch_sizes[caller_id]) {
+        ++m_num_partial_batches_called;
+    }
 }
 
 void ModBaseCallerNode::output_worker_thread() {
@@ -548,9 +689,11 @@ void ModBaseCallerNode::output_worker_thread() {
                              ? m_base_prob_offsets[baseIds[seq]]
                              : m_base_prob_offsets[baseIds[dorado::utils::complement_table[seq]]];
 
+            auto& probs = source_read_common.sparse_base_mod_probs;
+            auto* const probs_row = probs.row(probs.find(size_t(result_pos)));
             auto num_chunk_scores = chunk->scores.size();
             for (size_t i = 0; i < num_chunk_scores; ++i) {
-                source_read_common.base_mod_probs[m_num_states * result_pos + offset + i] =
+                probs_row[offset + i] =
                         static_cast<uint8_t>(std::min(std::floor(chunk->scores[i] * 256), 255.0f));
             }
             // If all chunks for the read associated with this chunk have now been called,
@@ -595,6 +738,10 @@ std::unordered_map<std::string, double> ModBaseCallerNode::sample_stats() const
     stats["batches_called"] = double(m_num_batches_called);
     stats["partial_batches_called"] = double(m_num_partial_batches_called);
     stats["input_chunks_sleeps"] = double(m_num_input_chunks_sleeps);
+    stats["chunks_called"] = double(m_num_chunks_called);
+    if (m_num_batch_slots_called > 0) {
+        stats["batch_fill_ratio"] = double(m_num_chunks_called) / double(m_num_batch_slots_called);
+    }
     stats["call_chunks_ms"] = double(m_call_chunks_ms);
     stats["context_hits"] = double(m_num_context_hits);
     stats["mod_base_reads_pushed"] = double(m_num_mod_base_reads_pushed);
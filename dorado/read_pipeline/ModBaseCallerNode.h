@@ -6,7 +6,10 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -45,11 +48,31 @@ private:
     // Determine the modbase alphabet from all callers and calculate offset positions for the results
     void init_modbase_info();
 
+    // Groups together callers whose models scale the signal the same way, so that it is only
+    // scaled once for all of them.
+    void init_scaling_groups();
+
+    // Stores a row of modified base probabilities in the read for each of context_hits, initialised
+    // to what corresponds to 100% canonical base.
+    void init_base_mod_probs(ReadCommon& read_common, std::vector<uint32_t> context_hits) const;
+
     // Worker threads, scales and chunks reads for runners and enqueues them
     void input_thread_fn();
 
+    // Hands the chunks generated for a read over to the batch packer, blocking while a caller
+    // has too many chunks pending.
+    void push_chunks(std::vector<std::vector<std::unique_ptr<RemoraChunk>>>& chunks_by_caller);
+
+    // Takes the next batch of chunks for the runner, choosing a caller with a full batch if there
+    // is one, and otherwise the caller whose oldest pending chunk has waited the longest beyond
+    // m_max_batch_age. Blocks until a batch is ready, and returns false once terminated with
+    // nothing left to call.
+    bool pack_next_batch(size_t worker_id,
+                         size_t& caller_id,
+                         std::vector<std::unique_ptr<RemoraChunk>>& batched_chunks);
+
     // Worker threads, performs the GPU calls to the modbase models
-    void modbasecall_worker_thread(size_t worker_id, size_t caller_id);
+    void modbasecall_worker_thread(size_t worker_id);
 
     // Called by modbasecall_worker_thread, calls the model and enqueues the results
     void call_current_batch(size_t worker_id,
@@ -61,13 +84,23 @@ private:
 
     std::vector<modbase::RunnerPtr> m_runners;
     size_t m_block_stride;
-    size_t m_batch_size;
+    std::vector<size_t> m_batch_sizes;  // Indexed by caller_id.
 
     std::unique_ptr<std::thread> m_output_worker;
     std::vector<std::unique_ptr<std::thread>> m_runner_workers;
 
     utils::AsyncQueue<std::unique_ptr<RemoraChunk>> m_processed_chunks;
-    std::vector<std::unique_ptr<utils::AsyncQueue<std::unique_ptr<RemoraChunk>>>> m_chunk_queues;
+
+    // Chunks waiting to be packed into batches, pooled across reads, for each caller in the order
+    // they were generated. Each runner's workers take batches for any caller whose input tensors
+    // aren't already being filled or called by another worker of the same runner.
+    std::mutex m_pending_chunks_mutex;
+    std::condition_variable m_pending_chunks_cv;
+    std::vector<std::deque<std::unique_ptr<RemoraChunk>>> m_pending_chunks;
+    std::vector<std::vector<bool>> m_caller_busy;  // Indexed by [worker_id][caller_id].
+    bool m_terminate_pending_chunks{false};
+    // Partial batches are only called once their oldest chunk has waited this long.
+    std::chrono::milliseconds m_max_batch_age;
 
     std::mutex m_working_reads_mutex;
     // Reads removed from input queue and being modbasecalled.
@@ -79,11 +112,16 @@ private:
     // The offsets to the canonical bases in the modbase alphabet
     std::array<size_t, 4> m_base_prob_offsets;
     size_t m_num_states{4};
+    // The scaling group of each caller, and the number of groups.
+    std::vector<size_t> m_caller_scaling_groups;
+    size_t m_num_scaling_groups{0};
 
     // Performance monitoring stats.
     std::atomic<int64_t> m_num_batches_called = 0;
     std::atomic<int64_t> m_num_partial_batches_called = 0;
     std::atomic<int64_t> m_num_input_chunks_sleeps = 0;
+    std::atomic<int64_t> m_num_chunks_called = 0;
+    std::atomic<int64_t> m_num_batch_slots_called = 0;
     std::atomic<int64_t> m_call_chunks_ms = 0;
     std::atomic<int64_t> m_num_context_hits = 0;
     std::atomic<int64_t> m_num_mod_base_reads_pushed = 0;
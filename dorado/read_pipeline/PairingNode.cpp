@@ -8,8 +8,12 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <filesystem>
 #include <limits>
+#include <optional>
 
 namespace {
 const int kMaxTimeDeltaMs = 10000;
@@ -17,10 +21,6 @@ const int kMinOverlapLength = 50;
 const int kMinSeqLength = 500;
 const float kMinSimplexQScore = 8.f;
 
-size_t read_signal_bytes(const dorado::SimplexRead& read) {
-    return read.read_common.raw_data.nbytes();
-}
-
 // There are 4 different cases to consider when checking for adjacent reads -
 // 1 Both reads are unsplit - in this case the next and prev ids determined
 //     from the pod5 are unchanged and consistent.
@@ -66,10 +66,13 @@ namespace dorado {
 //    of the template is mapped to the beginning
 //    of the complement read, then consider them a pair.
 PairingNode::PairingResult PairingNode::is_within_time_and_length_criteria(
-        const dorado::SimplexRead& temp,
+        CachedRead& cached_temp,
         const dorado::SimplexRead& comp,
         int tid) {
+    const auto& temp = *cached_temp.read;
+    ++m_candidate_pairs;
     if (!are_reads_adjacent(temp, comp)) {
+        ++m_non_adjacent_pairs;
         return {false, 0, 0, 0, 0};
     }
 
@@ -81,8 +84,12 @@ PairingNode::PairingResult PairingNode::is_within_time_and_length_criteria(
     float min_qscore = std::min(temp.read_common.calculate_mean_qscore(),
                                 comp.read_common.calculate_mean_qscore());
 
-    if ((delta < 0) || (delta >= kMaxTimeDeltaMs) || (min_seq_len < kMinSeqLength) ||
-        (min_qscore < kMinSimplexQScore)) {
+    if ((delta < 0) || (delta >= kMaxTimeDeltaMs)) {
+        ++m_time_rejected_pairs;
+        return {false, 0, 0, 0, 0};
+    }
+    if ((min_seq_len < kMinSeqLength) || (min_qscore < kMinSimplexQScore)) {
+        ++m_length_or_qscore_rejected_pairs;
         return {false, 0, 0, 0, 0};
     }
 
@@ -100,11 +107,40 @@ PairingNode::PairingResult PairingNode::is_within_time_and_length_criteria(
                 int(comp.read_common.seq.length() - 1)};
     }
 
-    return is_within_alignment_criteria(temp, comp, delta, true, tid);
+    // Only used if the cache has no room to keep the index.
+    std::unique_ptr<const utils::OverlapIndex> uncached_index;
+    {
+        std::lock_guard lock(cached_temp.overlap_index_mutex);
+        if (cached_temp.overlap_index) {
+            ++m_overlap_index_reuses;
+        } else {
+            const auto build_start = std::chrono::steady_clock::now();
+            auto index = std::make_unique<const utils::OverlapIndex>(temp.read_common.seq,
+                                                                     temp.read_common.read_id);
+            m_overlap_index_build_times.record(std::chrono::steady_clock::now() - build_start);
+            ++m_overlap_indexes_built;
+
+            const size_t index_bytes = index->memory_bytes();
+            if (m_cache_overlap_index_bytes.fetch_add(index_bytes) + index_bytes <=
+                m_max_overlap_index_bytes) {
+                cached_temp.overlap_index = std::move(index);
+            } else {
+                m_cache_overlap_index_bytes -= index_bytes;
+                ++m_uncached_overlap_indexes;
+                uncached_index = std::move(index);
+            }
+        }
+    }
+    // A cached index isn't changed again until the read leaves the cache, which can't happen
+    // while this thread is evaluating it.
+    const auto& temp_index = uncached_index ? *uncached_index : *cached_temp.overlap_index;
+
+    return is_within_alignment_criteria(temp, temp_index, comp, delta, true, tid);
 }
 
 PairingNode::PairingResult PairingNode::is_within_alignment_criteria(
         const dorado::SimplexRead& temp,
+        const utils::OverlapIndex& temp_index,
         const dorado::SimplexRead& comp,
         int delta,
         bool allow_rejection,
@@ -114,9 +150,10 @@ PairingNode::PairingResult PairingNode::is_within_alignment_criteria(
     nvtx3::scoped_range loop{nvtx_id};
 
     MmTbufPtr& working_buffer = m_tbufs[tid];
+    const auto map_start = std::chrono::steady_clock::now();
     const auto overlap_result =
-            utils::compute_overlap(temp.read_common.seq, temp.read_common.read_id,
-                                   comp.read_common.seq, comp.read_common.read_id, working_buffer);
+            temp_index.map(comp.read_common.seq, comp.read_common.read_id, working_buffer);
+    m_overlap_times.record(std::chrono::steady_clock::now() - map_start);
 
     if (overlap_result) {
         const uint8_t mapq = overlap_result->mapq;
@@ -157,6 +194,9 @@ PairingNode::PairingResult PairingNode::is_within_alignment_criteria(
             pair_result = {true, temp_start, temp_end, comp_start, comp_end};
         }
     }
+    if (!std::get<0>(pair_result)) {
+        ++m_overlap_rejected_pairs;
+    }
 
     return pair_result;
 }
@@ -173,32 +213,11 @@ void PairingNode::pair_list_worker_thread(int tid) {
         // If this message isn't a read, we'll get a bad_variant_access exception.
         auto read = std::get<SimplexReadPtr>(std::move(message));
 
-        bool read_is_template = false;
-        bool partner_found = false;
-        std::string partner_id;
-
-        // Check if read is a template with corresponding complement
-        std::unique_lock<std::mutex> tc_lock(m_tc_map_mutex);
-
-        auto it = m_template_complement_map.find(read->read_common.read_id);
-        if (it != m_template_complement_map.end()) {
-            partner_id = it->second;
-            tc_lock.unlock();
-            read_is_template = true;
-            partner_found = true;
-        } else {
-            tc_lock.unlock();
-            std::lock_guard<std::mutex> ct_lock(m_ct_map_mutex);
-            it = m_complement_template_map.find(read->read_common.read_id);
-            if (it != m_complement_template_map.end()) {
-                partner_id = it->second;
-                partner_found = true;
-            }
-        }
-
-        if (partner_found) {
-            std::unique_lock<std::mutex> read_cache_lock(m_read_cache_mutex);
-            auto partner_read_itr = m_read_cache.find(partner_id);
+        const auto partner = m_pair_list.find_partner(read->read_common.read_id);
+        if (partner) {
+            const bool read_is_template = partner->read_is_template;
+            auto read_cache_lock = lock_and_record_wait(m_read_cache_mutex);
+            auto partner_read_itr = m_read_cache.find(partner->read_id);
             if (partner_read_itr == m_read_cache.end()) {
                 // Partner is not in the read cache
                 auto read_id = read->read_common.read_id;
@@ -220,10 +239,15 @@ void PairingNode::pair_list_worker_thread(int tid) {
                     template_read = std::move(partner_read);
                 }
 
+                ++m_candidate_pairs;
                 int delta = int(complement_read->read_common.start_time_ms -
                                 template_read->get_end_time_ms());
+                // Each read is only ever tested against its listed partner, so there's no point
+                // in caching its index.
+                const utils::OverlapIndex template_index(template_read->read_common.seq,
+                                                         template_read->read_common.read_id);
                 auto [is_pair, qs, qe, rs, re] = is_within_alignment_criteria(
-                        *template_read, *complement_read, delta, false, tid);
+                        *template_read, template_index, *complement_read, delta, false, tid);
                 if (is_pair) {
                     ReadPair read_pair;
                     read_pair.template_read = ReadPair::ReadData::from_read(*template_read, qs, qe);
@@ -246,28 +270,120 @@ void PairingNode::pair_list_worker_thread(int tid) {
     --m_num_active_worker_threads;
 }
 
+PairingNode::ReadCacheShard& PairingNode::get_shard(const UniquePoreIdentifierKey& key) {
+    // Channel numbers are dense, so they spread the pores evenly over the shards.
+    return m_read_cache_shards[size_t(std::get<0>(key)) % NUM_READ_CACHE_SHARDS];
+}
+
+void PairingNode::clear_finished_reads(ReadCacheShard& shard) {
+    auto& reads_to_clear = shard.reads_to_clear;
+    auto finished_reads = std::partition(
+            reads_to_clear.begin(), reads_to_clear.end(),
+            [](const CachedReadPtr& cached_read) { return cached_read->num_in_flight > 0; });
+    for (auto it = finished_reads; it != reads_to_clear.end(); ++it) {
+        // No other thread is evaluating the read any more, so whether it was paired is settled.
+        if (!(*it)->read->is_duplex_parent) {
+            if ((*it)->eviction == CacheEviction::PORE) {
+                ++m_pore_evicted_unpaired_reads;
+            } else if ((*it)->eviction == CacheEviction::DEPTH) {
+                ++m_depth_evicted_unpaired_reads;
+            }
+        }
+        m_cache_overlap_index_bytes -= (*it)->overlap_index_bytes();
+        send_message_to_sink(std::move((*it)->read));
+    }
+    reads_to_clear.erase(finished_reads, reads_to_clear.end());
+}
+
+void PairingNode::remove_cached_read(ReadCacheShard& shard, CachedRead& cached_read) {
+    m_cache_signal_bytes -= cached_read.signal_bytes();
+    if (cached_read.in_spill_order) {
+        shard.spill_order.erase(cached_read.spill_order_it);
+        cached_read.in_spill_order = false;
+    }
+}
+
+void PairingNode::spill_oldest_signals() {
+    for (size_t i = 0;
+         i < NUM_READ_CACHE_SHARDS && m_cache_signal_bytes >= m_signal_spill_threshold; ++i) {
+        auto& shard = m_read_cache_shards[m_next_spill_shard++ % NUM_READ_CACHE_SHARDS];
+        const auto lock = lock_and_record_wait(shard.mutex);
+        auto it = shard.spill_order.begin();
+        while (it != shard.spill_order.end() && m_cache_signal_bytes >= m_signal_spill_threshold) {
+            auto& cached_read = **it;
+            if (cached_read.num_in_flight > 0) {
+                // Another thread may be reading its signal, so leave it until next time.
+                ++it;
+                continue;
+            }
+            // The signal is paged back in if the read is paired and its signal is used.
+            auto& raw_data = cached_read.read->read_common.raw_data;
+            const size_t signal_bytes = cached_read.signal_bytes();
+            auto spilled_data = m_signal_spill_file->spill(raw_data);
+            cached_read.signal_spilled = !spilled_data.is_same(raw_data);
+            raw_data = std::move(spilled_data);
+            m_cache_signal_bytes -= signal_bytes - cached_read.signal_bytes();
+            // A read whose signal can't be spilled isn't tried again.
+            cached_read.in_spill_order = false;
+            it = shard.spill_order.erase(it);
+        }
+    }
+}
+
+void PairingNode::evict_pore(int32_t client_id, const UniquePoreIdentifierKey& key) {
+    auto& shard = get_shard(key);
+    const auto lock = lock_and_record_wait(shard.mutex);
+    auto read_map_it = shard.client_read_maps.find(client_id);
+    if (read_map_it == shard.client_read_maps.end()) {
+        return;
+    }
+    // The pore may already have gone if its client's cache was flushed.
+    auto pore_it = read_map_it->second.find(key);
+    if (pore_it == read_map_it->second.end()) {
+        return;
+    }
+    for (auto& cached_read : pore_it->second) {
+        remove_cached_read(shard, *cached_read);
+        cached_read->eviction = CacheEviction::PORE;
+        ++m_pore_evicted_reads;
+        shard.reads_to_clear.push_back(std::move(cached_read));
+    }
+    read_map_it->second.erase(pore_it);
+    clear_finished_reads(shard);
+}
+
 void PairingNode::pair_generating_worker_thread(int tid) {
     at::InferenceMode inference_mode_guard;
 
-    auto compare_reads_by_time = [](const SimplexReadPtr& read1, const SimplexReadPtr& read2) {
-        return read1->read_common.start_time_ms < read2->read_common.start_time_ms;
+    auto compare_reads_by_time = [](const CachedReadPtr& read1, const CachedReadPtr& read2) {
+        return read1->read->read_common.start_time_ms < read2->read->read_common.start_time_ms;
     };
+    const bool limit_num_pores = m_max_num_keys != std::numeric_limits<size_t>::max();
 
     Message message;
     while (get_input_message(message)) {
         if (std::holds_alternative<CacheFlushMessage>(message)) {
-            std::unique_lock<std::mutex> lock(m_pairing_mtx);
-            auto flush_message = std::get<CacheFlushMessage>(message);
-            auto& read_cache = m_read_caches[flush_message.client_id];
-            for (auto& [key, reads_list] : read_cache.channel_read_map) {
-                // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
-                for (auto& read_ptr : reads_list) {
-                    // Push each read message
-                    m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                    send_message_to_sink(std::move(read_ptr));
+            const auto client_id = std::get<CacheFlushMessage>(message).client_id;
+            {
+                std::lock_guard<std::mutex> lock(m_pore_order_mutex);
+                m_pore_order.erase(client_id);
+            }
+            for (auto& shard : m_read_cache_shards) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                auto read_map_it = shard.client_read_maps.find(client_id);
+                if (read_map_it == shard.client_read_maps.end()) {
+                    continue;
+                }
+                for (auto& [key, reads_list] : read_map_it->second) {
+                    for (auto& cached_read : reads_list) {
+                        remove_cached_read(shard, *cached_read);
+                        shard.reads_to_clear.push_back(std::move(cached_read));
+                    }
                 }
+                shard.client_read_maps.erase(read_map_it);
+                // Reads still being evaluated by other threads are pushed once they're done.
+                clear_finished_reads(shard);
             }
-            m_read_caches.erase(flush_message.client_id);
             continue;
         }
 
@@ -280,181 +396,152 @@ void PairingNode::pair_generating_worker_thread(int tid) {
         const std::string nvtx_id = "pairing_code_" + std::to_string(tid);
         nvtx3::scoped_range loop{nvtx_id};
         // If this message isn't a read, we'll get a bad_variant_access exception.
-        auto read = std::get<SimplexReadPtr>(std::move(message));
-
-        int channel = read->read_common.attributes.channel_number;
-        std::string run_id = read->read_common.run_id;
-        std::string flowcell_id = read->read_common.flowcell_id;
-        int32_t client_id = read->read_common.client_info->client_id();
+        auto read = std::make_unique<CachedRead>(std::get<SimplexReadPtr>(std::move(message)));
 
-        std::unique_lock<std::mutex> lock(m_pairing_mtx);
+        int channel = read->read->read_common.attributes.channel_number;
+        std::string run_id = read->read->read_common.run_id;
+        std::string flowcell_id = read->read->read_common.flowcell_id;
+        int32_t client_id = read->read->read_common.client_info->client_id();
 
-        auto& read_cache = m_read_caches[client_id];
         UniquePoreIdentifierKey key = std::make_tuple(channel, run_id, flowcell_id);
-        auto read_list_iter = read_cache.channel_read_map.find(key);
-        // Check if the key is already in the list
-        if (read_list_iter == read_cache.channel_read_map.end()) {
-            // Key is not in the dequeue
-            // Add the new key to the end of the list
-            {
-                read_cache.working_channel_keys.push_back(key);
-                std::list<SimplexReadPtr> reads;
-                m_cache_signal_bytes += read_signal_bytes(*read);
-                reads.push_back(std::move(read));
-                read_cache.channel_read_map.emplace(key, std::move(reads));
-            }
+        auto& shard = get_shard(key);
+        auto lock = lock_and_record_wait(shard.mutex);
+
+        auto [read_list_iter, is_new_pore] = shard.client_read_maps[client_id].try_emplace(key);
+        auto& cached_read_list = read_list_iter->second;
+        // It's safe to take raw pointers of these reads since their ownership isn't released from
+        // this node until their |num_in_flight| count drops to 0.
+        CachedRead* later_read = nullptr;
+        CachedRead* earlier_read = nullptr;
+
+        auto later_read_iter = std::lower_bound(cached_read_list.begin(), cached_read_list.end(),
+                                                read, compare_reads_by_time);
+        if (later_read_iter != cached_read_list.end()) {
+            later_read = later_read_iter->get();
+            ++later_read->num_in_flight;
+        }
+
+        if (later_read_iter != cached_read_list.begin()) {
+            earlier_read = std::prev(later_read_iter)->get();
+            ++earlier_read->num_in_flight;
+        }
 
-            if (read_cache.working_channel_keys.size() > m_max_num_keys) {
-                // Remove the oldest key (front of the list)
-                auto oldest_key = read_cache.working_channel_keys.front();
-                read_cache.working_channel_keys.pop_front();
+        CachedRead* const read_ptr = read.get();
+        m_cache_signal_bytes += read->signal_bytes();
+        if (m_signal_spill_file) {
+            read->spill_order_it = shard.spill_order.insert(shard.spill_order.end(), read_ptr);
+            read->in_spill_order = true;
+        }
+        ++read_ptr->num_in_flight;
+        cached_read_list.insert(later_read_iter, std::move(read));
+
+        while (cached_read_list.size() > m_max_num_reads) {
+            remove_cached_read(shard, *cached_read_list.front());
+            cached_read_list.front()->eviction = CacheEviction::DEPTH;
+            ++m_depth_evicted_reads;
+            shard.reads_to_clear.push_back(std::move(cached_read_list.front()));
+            cached_read_list.pop_front();
+        }
 
-                auto oldest_key_it = read_cache.channel_read_map.find(oldest_key);
+        // Release the shard lock to run pair evaluations.
+        lock.unlock();
 
-                // Remove the oldest key from the map
-                for (auto& read_ptr : oldest_key_it->second) {
-                    m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                    m_reads_to_clear.insert(std::move(read_ptr));
+        if (is_new_pore && limit_num_pores) {
+            // Evict the oldest pore if there are now too many. Its shard is locked separately, so
+            // no thread ever holds two shard locks.
+            std::optional<UniquePoreIdentifierKey> oldest_key;
+            {
+                const auto order_lock = lock_and_record_wait(m_pore_order_mutex);
+                auto& pore_order = m_pore_order[client_id];
+                pore_order.push_back(key);
+                if (pore_order.size() > m_max_num_keys) {
+                    oldest_key = std::move(pore_order.front());
+                    pore_order.pop_front();
                 }
-                read_cache.channel_read_map.erase(oldest_key);
-                assert(read_cache.channel_read_map.size() ==
-                       read_cache.working_channel_keys.size());
-            }
-        } else {
-            auto& cached_read_list = read_list_iter->second;
-            // It's safe to take raw pointers of these reads since their ownership isn't released from this
-            // node until their counter in |m_reads_in_flight_ctr| hits 0.
-            SimplexRead* later_read = nullptr;
-            SimplexRead* earlier_read = nullptr;
-
-            auto later_read_iter = std::lower_bound(
-                    cached_read_list.begin(), cached_read_list.end(), read, compare_reads_by_time);
-            if (later_read_iter != cached_read_list.end()) {
-                later_read = later_read_iter->get();
-                m_reads_in_flight_ctr[later_read]++;
             }
-
-            if (later_read_iter != cached_read_list.begin()) {
-                earlier_read = std::prev(later_read_iter)->get();
-                m_reads_in_flight_ctr[earlier_read]++;
-            }
-
-            SimplexRead* const read_ptr = read.get();
-            m_cache_signal_bytes += read_signal_bytes(*read);
-            cached_read_list.insert(later_read_iter, std::move(read));
-            m_reads_in_flight_ctr[read_ptr]++;
-
-            while (cached_read_list.size() > m_max_num_reads) {
-                m_cache_signal_bytes -= read_signal_bytes(*cached_read_list.front());
-                auto cached_read = std::move(cached_read_list.front());
-                cached_read_list.pop_front();
-                m_reads_to_clear.insert(std::move(cached_read));
+            if (oldest_key) {
+                evict_pore(client_id, *oldest_key);
             }
+        }
 
-            // Release mutex around read cache to run pair evaluations.
-            lock.unlock();
-
-            if (later_read) {
-                auto [is_pair, qs, qe, rs, re] =
-                        is_within_time_and_length_criteria(*read_ptr, *later_read, tid);
-                if (is_pair) {
-                    ReadPair pair;
-                    pair.template_read = ReadPair::ReadData::from_read(*read_ptr, qs, qe);
-                    pair.complement_read = ReadPair::ReadData::from_read(*later_read, rs, re);
-
-                    read_ptr->is_duplex_parent = true;
-                    later_read->is_duplex_parent = true;
-                    ++read_ptr->num_duplex_candidate_pairs;
-                    send_message_to_sink(std::move(pair));
-                }
+        if (later_read) {
+            auto [is_pair, qs, qe, rs, re] =
+                    is_within_time_and_length_criteria(*read_ptr, *later_read->read, tid);
+            if (is_pair) {
+                ReadPair pair;
+                pair.template_read = ReadPair::ReadData::from_read(*read_ptr->read, qs, qe);
+                pair.complement_read = ReadPair::ReadData::from_read(*later_read->read, rs, re);
+
+                read_ptr->read->is_duplex_parent = true;
+                later_read->read->is_duplex_parent = true;
+                ++read_ptr->read->num_duplex_candidate_pairs;
+                send_message_to_sink(std::move(pair));
             }
+        }
 
-            if (earlier_read) {
-                auto [is_pair, qs, qe, rs, re] =
-                        is_within_time_and_length_criteria(*earlier_read, *read_ptr, tid);
-                if (is_pair) {
-                    ReadPair pair;
-                    pair.template_read = ReadPair::ReadData::from_read(*earlier_read, qs, qe);
-                    pair.complement_read = ReadPair::ReadData::from_read(*read_ptr, rs, re);
-
-                    earlier_read->is_duplex_parent = true;
-                    read_ptr->is_duplex_parent = true;
-                    ++earlier_read->num_duplex_candidate_pairs;
-                    send_message_to_sink(std::move(pair));
-                }
+        if (earlier_read) {
+            auto [is_pair, qs, qe, rs, re] =
+                    is_within_time_and_length_criteria(*earlier_read, *read_ptr->read, tid);
+            if (is_pair) {
+                ReadPair pair;
+                pair.template_read = ReadPair::ReadData::from_read(*earlier_read->read, qs, qe);
+                pair.complement_read = ReadPair::ReadData::from_read(*read_ptr->read, rs, re);
+
+                earlier_read->read->is_duplex_parent = true;
+                read_ptr->read->is_duplex_parent = true;
+                ++earlier_read->read->num_duplex_candidate_pairs;
+                send_message_to_sink(std::move(pair));
             }
+        }
 
-            // Acquire read cache lock again to decrement in flight read counters.
-            lock.lock();
-
-            // Decrement in-flight counter for each read.
-            m_reads_in_flight_ctr[read_ptr]--;
-            if (earlier_read) {
-                m_reads_in_flight_ctr[earlier_read]--;
-            }
-            if (later_read) {
-                m_reads_in_flight_ctr[later_read]--;
-            }
+        // Acquire the shard lock again to decrement the in-flight counts, then push any of the
+        // reads which have been removed from the cache and are no longer in flight.
+        lock = lock_and_record_wait(shard.mutex);
+        --read_ptr->num_in_flight;
+        if (earlier_read) {
+            --earlier_read->num_in_flight;
         }
+        if (later_read) {
+            --later_read->num_in_flight;
+        }
+        clear_finished_reads(shard);
+        lock.unlock();
 
-        // Once pairs have been evaluated, check if any of the in-flight reads
-        // need to be purged from the cache.
-        for (auto to_clear_itr = m_reads_to_clear.begin();
-             to_clear_itr != m_reads_to_clear.end();) {
-            auto in_flight_itr = m_reads_in_flight_ctr.find(to_clear_itr->get());
-            bool ok_to_clear = false;
-            // If a read to clear is not in-flight (not in the in-flight list
-            // or in-flight counter is 0), then clear it
-            // from the cache.
-            if (in_flight_itr == m_reads_in_flight_ctr.end()) {
-                ok_to_clear = true;
-            } else if (in_flight_itr->second.load() == 0) {
-                m_reads_in_flight_ctr.erase(in_flight_itr);
-                ok_to_clear = true;
-            }
-            if (ok_to_clear) {
-                auto read_handle = m_reads_to_clear.extract(*to_clear_itr++);
-                send_message_to_sink(std::move(read_handle.value()));
-            } else {
-                ++to_clear_itr;
-            }
+        if (m_signal_spill_file && m_cache_signal_bytes >= m_signal_spill_threshold) {
+            spill_oldest_signals();
         }
     }
 
     if (--m_num_active_worker_threads == 0) {
         if (!m_preserve_cache_during_flush) {
-            std::unique_lock<std::mutex> lock(m_pairing_mtx);
-            // There are still reads in channel_read_map. Push them to the sink.
+            // There are still reads in the cache. Push them to the sink.
             // Last thread alive is responsible for cleaning up the cache.
-            for (auto& [client_id, read_cache] : m_read_caches) {
-                for (auto& kv : read_cache.channel_read_map) {
-                    // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
-                    auto& reads_list = kv.second;
-
-                    for (auto& read_ptr : reads_list) {
-                        m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                        // Push each read message
-                        send_message_to_sink(std::move(read_ptr));
+            for (auto& shard : m_read_cache_shards) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (auto& [client_id, read_map] : shard.client_read_maps) {
+                    for (auto& [key, reads_list] : read_map) {
+                        for (auto& cached_read : reads_list) {
+                            remove_cached_read(shard, *cached_read);
+                            m_cache_overlap_index_bytes -= cached_read->overlap_index_bytes();
+                            // Push each read message
+                            send_message_to_sink(std::move(cached_read->read));
+                        }
                     }
                 }
+                shard.client_read_maps.clear();
             }
-            m_read_caches.clear();
+            std::lock_guard<std::mutex> lock(m_pore_order_mutex);
+            m_pore_order.clear();
         }
-        m_reads_in_flight_ctr.clear();
     }
 }
 
-PairingNode::PairingNode(std::map<std::string, std::string> template_complement_map,
+PairingNode::PairingNode(utils::DuplexPairList pair_list,
                          int num_worker_threads,
                          size_t max_reads)
         : MessageSink(max_reads, 0),
           m_num_worker_threads(num_worker_threads),
-          m_template_complement_map(std::move(template_complement_map)) {
-    // Set up the complement-template_map
-    for (auto& key : m_template_complement_map) {
-        m_complement_template_map[key.second] = key.first;
-    }
-
+          m_pair_list(std::move(pair_list)) {
     m_pairing_func = &PairingNode::pair_list_worker_thread;
     start_threads();
 }
@@ -465,7 +552,8 @@ PairingNode::PairingNode(DuplexPairingParameters pairing_params,
         : MessageSink(max_reads, 0),
           m_num_worker_threads(num_worker_threads),
           m_max_num_keys(std::numeric_limits<size_t>::max()),
-          m_max_num_reads(std::numeric_limits<size_t>::max()) {
+          m_max_num_reads(std::numeric_limits<size_t>::max()),
+          m_max_overlap_index_bytes(pairing_params.max_overlap_index_bytes) {
     switch (pairing_params.read_order) {
     case ReadOrder::BY_CHANNEL:
         m_max_num_keys = pairing_params.cache_depth;
@@ -479,6 +567,14 @@ PairingNode::PairingNode(DuplexPairingParameters pairing_params,
         throw std::runtime_error("Unsupported read order detected: " +
                                  dorado::to_string(pairing_params.read_order));
     }
+    if (pairing_params.signal_spill_threshold > 0) {
+        m_signal_spill_threshold = pairing_params.signal_spill_threshold;
+        const auto spill_dir = pairing_params.signal_spill_dir.empty()
+                                       ? std::filesystem::temp_directory_path()
+                                       : std::filesystem::path(pairing_params.signal_spill_dir);
+        m_signal_spill_file = std::make_unique<utils::SignalSpillFile>(spill_dir);
+        spdlog::debug("Spilling pairing cache signal beyond {} MB", m_signal_spill_threshold >> 20);
+    }
     m_pairing_func = &PairingNode::pair_generating_worker_thread;
     start_threads();
 }
@@ -515,12 +611,105 @@ void PairingNode::restart() {
     start_threads();
 }
 
+size_t PairingNode::DurationStats::bucket_index(int64_t duration_ns) {
+    constexpr int64_t exact_limit = int64_t(1) << SUB_BUCKETS_LOG2;
+    if (duration_ns < exact_limit) {
+        return size_t(std::max<int64_t>(duration_ns, 0));
+    }
+    int msb = SUB_BUCKETS_LOG2;
+    while ((duration_ns >> (msb + 1)) != 0) {
+        ++msb;
+    }
+    const auto sub_bucket = size_t(duration_ns >> (msb - SUB_BUCKETS_LOG2)) & (exact_limit - 1);
+    return (size_t(msb - SUB_BUCKETS_LOG2 + 1) << SUB_BUCKETS_LOG2) | sub_bucket;
+}
+
+double PairingNode::DurationStats::bucket_middle_ms(size_t bucket_idx) {
+    constexpr size_t exact_limit = size_t(1) << SUB_BUCKETS_LOG2;
+    if (bucket_idx < exact_limit) {
+        return double(bucket_idx) * 1e-6;
+    }
+    // Each bucket is 2^shift ns wide, starting at the bucket's position within its power of two.
+    const int shift = int(bucket_idx >> SUB_BUCKETS_LOG2) - 1;
+    const size_t position = exact_limit + (bucket_idx & (exact_limit - 1));
+    return std::ldexp(double(position) + 0.5, shift) * 1e-6;
+}
+
+void PairingNode::DurationStats::record(std::chrono::steady_clock::duration duration) {
+    const int64_t duration_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+    m_bucket_counts[bucket_index(duration_ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PairingNode::DurationStats::add_to(stats::NamedStats& stats, const std::string& name) const {
+    // The counters are read one at a time while events are still being recorded, so the totals
+    // may be a few events apart, which doesn't matter for reporting.
+    std::array<int64_t, NUM_BUCKETS> bucket_counts;
+    int64_t count = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        bucket_counts[i] = m_bucket_counts[i].load(std::memory_order_relaxed);
+        count += bucket_counts[i];
+    }
+    stats[name + "_count"] = double(m_count.load(std::memory_order_relaxed));
+    stats[name + "_ms"] = double(m_total_ns.load(std::memory_order_relaxed)) * 1e-6;
+    if (count == 0) {
+        return;
+    }
+
+    const std::pair<const char*, double> quantiles[] = {{"_ms_p50", 0.5}, {"_ms_p90", 0.9},
+                                                         {"_ms_p99", 0.99}};
+    size_t bucket_idx = 0;
+    int64_t num_below = bucket_counts[0];
+    for (const auto& [suffix, quantile] : quantiles) {
+        // The bucket holding the duration ranked |quantile| of the way through them all.
+        const auto rank = int64_t(quantile * double(count - 1));
+        while (num_below <= rank) {
+            num_below += bucket_counts[++bucket_idx];
+        }
+        stats[name + suffix] = bucket_middle_ms(bucket_idx);
+    }
+}
+
+std::unique_lock<std::mutex> PairingNode::lock_and_record_wait(std::mutex& mutex) {
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        // Only contended locks are timed, so uncontended ones cost no more than before.
+        const auto wait_start = std::chrono::steady_clock::now();
+        lock.lock();
+        m_lock_wait_times.record(std::chrono::steady_clock::now() - wait_start);
+    }
+    return lock;
+}
+
 stats::NamedStats PairingNode::sample_stats() const {
     stats::NamedStats stats = m_work_queue.sample_stats();
     stats["early_accepted_pairs"] = m_early_accepted_pairs.load();
     stats["overlap_accepted_pairs"] = m_overlap_accepted_pairs.load();
+    stats["overlap_indexes_built"] = m_overlap_indexes_built.load();
+    stats["overlap_index_reuses"] = m_overlap_index_reuses.load();
+    stats["uncached_overlap_indexes"] = m_uncached_overlap_indexes.load();
+    stats["candidate_pairs"] = double(m_candidate_pairs.load());
+    stats["non_adjacent_pairs"] = double(m_non_adjacent_pairs.load());
+    stats["time_rejected_pairs"] = double(m_time_rejected_pairs.load());
+    stats["length_or_qscore_rejected_pairs"] = double(m_length_or_qscore_rejected_pairs.load());
+    stats["overlap_rejected_pairs"] = double(m_overlap_rejected_pairs.load());
+    stats["pore_evicted_reads"] = double(m_pore_evicted_reads.load());
+    stats["pore_evicted_unpaired_reads"] = double(m_pore_evicted_unpaired_reads.load());
+    stats["depth_evicted_reads"] = double(m_depth_evicted_reads.load());
+    stats["depth_evicted_unpaired_reads"] = double(m_depth_evicted_unpaired_reads.load());
+    m_overlap_index_build_times.add_to(stats, "overlap_index_build");
+    m_overlap_times.add_to(stats, "overlap");
+    m_lock_wait_times.add_to(stats, "lock_wait");
     stats["cached_signal_mb"] =
             static_cast<double>(m_cache_signal_bytes) / static_cast<double>(1024 * 1024);
+    stats["cached_overlap_index_mb"] =
+            static_cast<double>(m_cache_overlap_index_bytes) / static_cast<double>(1024 * 1024);
+    if (m_signal_spill_file) {
+        stats["spilled_signal_mb"] = static_cast<double>(m_signal_spill_file->spilled_bytes()) /
+                                     static_cast<double>(1024 * 1024);
+    }
     return stats;
 }
 
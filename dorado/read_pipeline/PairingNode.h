@@ -1,10 +1,15 @@
 #pragma once
 
 #include "ReadPipeline.h"
+#include "utils/duplex_pair_list.h"
+#include "utils/sequence_utils.h"
+#include "utils/signal_spill_file.h"
 #include "utils/stats.h"
 #include "utils/types.h"
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <deque>
 #include <list>
@@ -24,16 +29,66 @@ class PairingNode : public MessageSink {
     // The values are channel, run_id, flowcell_id
     using UniquePoreIdentifierKey = std::tuple<int, std::string, std::string>;
 
-    struct ReadCache {
-        std::map<UniquePoreIdentifierKey, std::list<SimplexReadPtr>> channel_read_map;
-        std::deque<UniquePoreIdentifierKey> working_channel_keys;
+    // Why a read was removed from the ReadCache before the end of its client's reads.
+    enum class CacheEviction {
+        NONE,
+        // Its pore was the oldest when there were more than |m_max_num_keys| pores.
+        PORE,
+        // It was the oldest of its pore's reads when there were more than |m_max_num_reads|.
+        DEPTH,
     };
 
+    // A read held in the ReadCache, along with the overlap index of its sequence. The index is
+    // built the first time the read is the template of a candidate pair that needs mapping, and
+    // is kept for any other candidate it's tested against if |m_max_overlap_index_bytes| allows.
+    struct CachedRead {
+        explicit CachedRead(SimplexReadPtr read_) : read(std::move(read_)) {}
+
+        SimplexReadPtr read;
+        // Guards building |overlap_index|, which isn't changed again once it's set.
+        std::mutex overlap_index_mutex;
+        std::unique_ptr<const utils::OverlapIndex> overlap_index;
+        // Number of threads evaluating pairs with this read. Guarded by the mutex of its shard.
+        int num_in_flight = 0;
+        // Whether the read's signal has been moved to the spill file.
+        bool signal_spilled = false;
+        // Where the read is in its shard's |spill_order|, if it's still a candidate for spilling.
+        bool in_spill_order = false;
+        std::list<CachedRead*>::iterator spill_order_it;
+        CacheEviction eviction = CacheEviction::NONE;
+
+        // Bytes of signal this read holds in memory.
+        size_t signal_bytes() const {
+            return signal_spilled ? 0 : size_t(read->read_common.raw_data.nbytes());
+        }
+
+        // Bytes held by the read's overlap index.
+        size_t overlap_index_bytes() const {
+            return overlap_index ? overlap_index->memory_bytes() : 0;
+        }
+    };
+    using CachedReadPtr = std::unique_ptr<CachedRead>;
+
+    using PoreReadMap = std::map<UniquePoreIdentifierKey, std::list<CachedReadPtr>>;
+
+    // One shard of the read cache. A read only ever pairs with reads from the same pore, so each
+    // pore lives entirely in one shard and pairing only needs that shard's lock.
+    struct ReadCacheShard {
+        std::mutex mutex;
+        // Reads per pore, for each client, keyed by client_id.
+        std::unordered_map<int32_t, PoreReadMap> client_read_maps;
+        // Reads which have been removed from the cache but are still being evaluated for pairs by
+        // other threads.
+        std::vector<CachedReadPtr> reads_to_clear;
+        // Cached reads whose signal hasn't been spilled yet, oldest first. Only tracked when
+        // spilling is enabled.
+        std::list<CachedRead*> spill_order;
+    };
+    static constexpr size_t NUM_READ_CACHE_SHARDS = 64;
+
 public:
-    // Template-complement map: uses the pair_list pairing method
-    PairingNode(std::map<std::string, std::string> template_complement_map,
-                int num_worker_threads,
-                size_t max_reads);
+    // Template-complement pair list: uses the pair_list pairing method
+    PairingNode(utils::DuplexPairList pair_list, int num_worker_threads, size_t max_reads);
 
     // No template-complement map: uses the pair_generation pairing method
     PairingNode(DuplexPairingParameters pairing_params, int num_worker_threads, size_t max_reads);
@@ -74,20 +129,38 @@ private:
 
     // Members for pair_list method
 
-    std::mutex m_tc_map_mutex;
-    std::mutex m_ct_map_mutex;
-    std::mutex m_read_cache_mutex;
+    // Never modified after construction, so it's read without locking.
+    const utils::DuplexPairList m_pair_list;
 
-    std::map<std::string, std::string> m_template_complement_map;
-    std::map<std::string, std::string> m_complement_template_map;
+    std::mutex m_read_cache_mutex;
     std::map<std::string, SimplexReadPtr> m_read_cache;
 
     // Members for pair_generating method
 
-    std::mutex m_pairing_mtx;
+    std::array<ReadCacheShard, NUM_READ_CACHE_SHARDS> m_read_cache_shards;
+
+    ReadCacheShard& get_shard(const UniquePoreIdentifierKey& key);
 
-    // individual read caches per client, keyed by client_id
-    std::unordered_map<int32_t, ReadCache> m_read_caches;
+    // Moves any reads in |shard| which have been removed from the cache and are no longer being
+    // evaluated to the sink, freeing their overlap indexes. The shard's mutex must be held.
+    void clear_finished_reads(ReadCacheShard& shard);
+
+    // Removes every read of |key| for |client_id| from the cache.
+    void evict_pore(int32_t client_id, const UniquePoreIdentifierKey& key);
+
+    // Accounts for |cached_read| leaving the cache of |shard|, whose mutex must be held.
+    void remove_cached_read(ReadCacheShard& shard, CachedRead& cached_read);
+
+    // Spills the signal of the oldest cached reads which aren't being evaluated until
+    // |m_cache_signal_bytes| is back under |m_signal_spill_threshold|. Shards are visited in turn
+    // from where the last call stopped, locking one at a time.
+    void spill_oldest_signals();
+
+    // Order in which pores were first seen, per client, which decides which pore to evict when
+    // there are more than |m_max_num_keys|. Only tracked when the number of pores is limited, and
+    // only locked when a read arrives from a pore which isn't in the cache.
+    std::mutex m_pore_order_mutex;
+    std::unordered_map<int32_t, std::deque<UniquePoreIdentifierKey>> m_pore_order;
 
     /**
      * The maximum number of different channels (pores) to keep in memory concurrently. 
@@ -106,11 +179,12 @@ private:
     size_t m_max_num_reads;
 
     using PairingResult = std::tuple<bool, uint32_t, uint32_t, uint32_t, uint32_t>;
-    PairingResult is_within_time_and_length_criteria(const dorado::SimplexRead& read1,
-                                                     const dorado::SimplexRead& read2,
+    PairingResult is_within_time_and_length_criteria(CachedRead& temp,
+                                                     const dorado::SimplexRead& comp,
                                                      int tid);
 
     PairingResult is_within_alignment_criteria(const dorado::SimplexRead& temp,
+                                               const utils::OverlapIndex& temp_index,
                                                const dorado::SimplexRead& comp,
                                                int delta,
                                                bool allow_rejection,
@@ -119,15 +193,58 @@ private:
     // Store the minimap2 buffers used for mapping. One buffer per thread.
     std::vector<MmTbufPtr> m_tbufs;
 
-    // Track reads which need to be emptied from the cache but are still being
-    // evaluated for pairs by other threads.
-    std::unordered_map<const SimplexRead*, std::atomic<int>> m_reads_in_flight_ctr;
-    std::unordered_set<SimplexReadPtr> m_reads_to_clear;
+    // The number and total duration of a kind of event, along with a histogram of the durations
+    // to report their quantiles. Recording only updates atomic counters, so it never blocks the
+    // threads whose events are being timed.
+    class DurationStats {
+    public:
+        void record(std::chrono::steady_clock::duration duration);
+        // Adds |name|_count, |name|_ms, and the quantiles of the durations as |name|_ms_p50 etc.
+        void add_to(stats::NamedStats& stats, const std::string& name) const;
+
+    private:
+        // Each power of two nanoseconds is split into 2^SUB_BUCKETS_LOG2 buckets, and a quantile
+        // is reported as the middle of its bucket, so it's within 12.5% of the recorded duration.
+        static constexpr int SUB_BUCKETS_LOG2 = 2;
+        static constexpr size_t NUM_BUCKETS = size_t(64 - SUB_BUCKETS_LOG2) << SUB_BUCKETS_LOG2;
+        static size_t bucket_index(int64_t duration_ns);
+        static double bucket_middle_ms(size_t bucket_idx);
+
+        std::atomic<int64_t> m_count{0};
+        std::atomic<int64_t> m_total_ns{0};
+        std::array<std::atomic<int64_t>, NUM_BUCKETS> m_bucket_counts{};
+    };
+
+    // Locks |mutex|, recording how long it took if another thread held it.
+    std::unique_lock<std::mutex> lock_and_record_wait(std::mutex& mutex);
 
     // Stats tracking for pairing node.
     std::atomic<int> m_early_accepted_pairs{0};
     std::atomic<int> m_overlap_accepted_pairs{0};
+    std::atomic<int> m_overlap_indexes_built{0};
+    std::atomic<int> m_overlap_index_reuses{0};
+    std::atomic<int> m_uncached_overlap_indexes{0};
+    std::atomic<int64_t> m_candidate_pairs{0};
+    std::atomic<int64_t> m_non_adjacent_pairs{0};
+    std::atomic<int64_t> m_time_rejected_pairs{0};
+    std::atomic<int64_t> m_length_or_qscore_rejected_pairs{0};
+    std::atomic<int64_t> m_overlap_rejected_pairs{0};
+    std::atomic<int64_t> m_pore_evicted_reads{0};
+    std::atomic<int64_t> m_pore_evicted_unpaired_reads{0};
+    std::atomic<int64_t> m_depth_evicted_reads{0};
+    std::atomic<int64_t> m_depth_evicted_unpaired_reads{0};
+    DurationStats m_overlap_index_build_times;
+    DurationStats m_overlap_times;
+    DurationStats m_lock_wait_times;
     std::atomic<size_t> m_cache_signal_bytes{0};
+    std::atomic<size_t> m_cache_overlap_index_bytes{0};
+    size_t m_max_overlap_index_bytes = 0;
+
+    // Where the signal of cached reads goes once |m_cache_signal_bytes| reaches
+    // |m_signal_spill_threshold|, if spilling is enabled.
+    std::unique_ptr<utils::SignalSpillFile> m_signal_spill_file;
+    size_t m_signal_spill_threshold = 0;
+    std::atomic<size_t> m_next_spill_shard{0};
 };
 
 }  // namespace dorado
@@ -7,6 +7,26 @@
 
 #include <htslib/sam.h>
 
+namespace {
+
+// Probability of channel_idx at seq_pos, where bases without a row have a probability of 0.
+// row_idx tracks the position in the rows, so seq_pos must not decrease between calls.
+uint8_t next_mod_prob(const dorado::utils::SparseModBaseProbs &probs,
+                      size_t &row_idx,
+                      size_t seq_pos,
+                      size_t channel_idx) {
+    const auto &positions = probs.positions();
+    while (row_idx < positions.size() && positions[row_idx] < seq_pos) {
+        ++row_idx;
+    }
+    if (row_idx < positions.size() && positions[row_idx] == seq_pos) {
+        return probs.row(row_idx)[channel_idx];
+    }
+    return 0;
+}
+
+}  // namespace
+
 namespace dorado {
 
 bool is_read_message(const Message &message) {
@@ -141,9 +161,22 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
     const size_t num_channels = mod_base_info->alphabet.size();
     const std::string cardinal_bases = "ACGT";
     char current_cardinal = 0;
-    if (seq.length() * num_channels != base_mod_probs.size()) {
+
+    // A full table of probabilities is written via the sparse form, with a row for every base.
+    utils::SparseModBaseProbs probs_from_dense;
+    if (!base_mod_probs.empty()) {
+        if (seq.length() * num_channels != base_mod_probs.size()) {
+            throw std::runtime_error(
+                    "Mismatch between base_mod_probs size and sequence length * num channels in "
+                    "modbase_alphabet!");
+        }
+        probs_from_dense = utils::SparseModBaseProbs::from_dense(base_mod_probs, num_channels);
+    }
+    const auto &probs = base_mod_probs.empty() ? sparse_base_mod_probs : probs_from_dense;
+    if (!probs.empty() &&
+        (probs.num_states() != num_channels || probs.positions().back() >= seq.length())) {
         throw std::runtime_error(
-                "Mismatch between base_mod_probs size and sequence length * num channels in "
+                "Mismatch between modified base probabilities and sequence length or "
                 "modbase_alphabet!");
     }
 
@@ -166,8 +199,7 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
         }
     }
     auto modbase_mask = context_handler.get_sequence_mask(seq);
-    context_handler.update_mask(modbase_mask, seq, mod_base_info->alphabet, base_mod_probs,
-                                threshold);
+    context_handler.update_mask(modbase_mask, seq, mod_base_info->alphabet, probs, threshold);
 
     if (is_duplex) {
         // If this is a duplex read, we need to compute the reverse complement mask and combine it
@@ -176,25 +208,10 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
         // Compute the reverse complement mask
         auto modbase_mask_rc = context_handler.get_sequence_mask(reverse_complemented_seq);
 
-        auto reverseMatrix = [](const std::vector<uint8_t> &matrix, int m_num_states) {
-            int numRows = static_cast<int>(matrix.size()) / static_cast<int>(m_num_states);
-            std::vector<uint8_t> reversedMatrix(matrix.size());
-
-            for (int i = 0; i < numRows; ++i) {
-                for (int j = 0; j < m_num_states; ++j) {
-                    reversedMatrix[i * m_num_states + j] =
-                            matrix[(numRows - 1 - i) * m_num_states + j];
-                }
-            }
-
-            return reversedMatrix;
-        };
-
-        int num_states = static_cast<int>(base_mod_probs.size()) / static_cast<int>(seq.size());
         // Update the context mask using the reversed sequence
         context_handler.update_mask(modbase_mask_rc, reverse_complemented_seq,
-                                    mod_base_info->alphabet,
-                                    reverseMatrix(base_mod_probs, num_states), threshold);
+                                    mod_base_info->alphabet, probs.reversed(seq.size()),
+                                    threshold);
 
         // Reverse the mask in-place
         std::reverse(modbase_mask_rc.begin(), modbase_mask_rc.end());
@@ -221,13 +238,14 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
             modbase_string += std::string(1, current_cardinal) + "+" + bam_name;
             modbase_string += base_has_context[current_cardinal] ? "?" : ".";
             int skipped_bases = 0;
+            size_t row_idx = 0;
             for (size_t base_idx = 0; base_idx < seq.size(); base_idx++) {
                 if (seq[base_idx] == current_cardinal) {
                     if (modbase_mask[base_idx]) {
                         modbase_string += "," + std::to_string(skipped_bases);
                         skipped_bases = 0;
                         modbase_prob.push_back(
-                                base_mod_probs[base_idx * num_channels + channel_idx]);
+                                next_mod_prob(probs, row_idx, base_idx, channel_idx));
                     } else {
                         // Skip this base
                         skipped_bases++;
@@ -256,13 +274,14 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
                 modbase_string += std::string(1, cardinal_complement) + "-" + bam_name;
                 modbase_string += base_has_context[current_cardinal] ? "?" : ".";
                 int skipped_bases = 0;
+                size_t row_idx = 0;
                 for (size_t base_idx = 0; base_idx < seq.size(); base_idx++) {
                     if (seq[base_idx] == cardinal_complement) {  // complement
                         if (modbase_mask[base_idx]) {            // Not sure this one is right
                             modbase_string += "," + std::to_string(skipped_bases);
                             skipped_bases = 0;
                             modbase_prob.push_back(
-                                    base_mod_probs[base_idx * num_channels + channel_idx]);
+                                    next_mod_prob(probs, row_idx, base_idx, channel_idx));
                         } else {
                             // Skip this base
                             skipped_bases++;
@@ -281,6 +300,13 @@ void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
     bam_aux_update_array(aln, "ML", 'C', int(modbase_prob.size()), (uint8_t *)modbase_prob.data());
 }
 
+std::vector<uint8_t> ReadCommon::dense_base_mod_probs() const {
+    if (!base_mod_probs.empty() || !mod_base_info) {
+        return base_mod_probs;
+    }
+    return sparse_base_mod_probs.to_dense(seq, mod_base_info->alphabet);
+}
+
 float ReadCommon::calculate_mean_qscore() const {
     if (is_rna_model) {
         const size_t polya_start = utils::find_rna_polya(seq);
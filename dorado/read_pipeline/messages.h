@@ -1,6 +1,7 @@
 #pragma once
 
 #include "models/kits.h"
+#include "utils/modbase_probs.h"
 #include "utils/types.h"
 
 #include <ATen/core/TensorBody.h>
@@ -72,6 +73,10 @@ public:
 
     float calculate_mean_qscore() const;
 
+    // Modified base probabilities for every base, from base_mod_probs if it was filled in and from
+    // sparse_base_mod_probs otherwise. Empty if there is no modified base information.
+    std::vector<uint8_t> dense_base_mod_probs() const;
+
     std::vector<BamPtr> extract_sam_lines(bool emit_moves,
                                           uint8_t modbase_threshold,
                                           bool is_duplex_parent) const;
@@ -90,6 +95,10 @@ public:
     std::shared_ptr<const ModBaseInfo>
             mod_base_info;  // Modified base settings of the models that ran on this read
 
+    // Modified base probabilities for only the bases which were called, as filled in by
+    // modified basecalling. Used instead of base_mod_probs when that is empty.
+    utils::SparseModBaseProbs sparse_base_mod_probs;
+
     // Number of samples which have been trimmed from the raw read.
     uint64_t num_trimmed_samples = 0;
 
@@ -0,0 +1,138 @@
+#include "read_chunking.h"
+
+#include "utils/math_utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <limits>
+
+namespace dorado::utils {
+
+size_t read_chunk_size_idx(const std::vector<size_t>& chunk_sizes, size_t read_size) {
+    size_t best_idx = 0;
+    for (size_t i = 1; i < chunk_sizes.size(); ++i) {
+        size_t best_size = chunk_sizes[best_idx];
+        size_t this_size = chunk_sizes[i];
+        if ((best_size < read_size && best_size < this_size) ||
+            (read_size < this_size && this_size < best_size)) {
+            best_idx = i;
+        }
+    }
+    return best_idx;
+}
+
+size_t tail_chunk_size_idx(const std::vector<size_t>& chunk_sizes,
+                           size_t tail_size,
+                           size_t max_chunk_size) {
+    // Chunk sizes larger than the rest of the read's chunks are never used, so the tail chunk
+    // always starts after the previous chunk.
+    const auto max_it = std::find(chunk_sizes.begin(), chunk_sizes.end(), max_chunk_size);
+    assert(max_it != chunk_sizes.end());
+    size_t best_idx = size_t(std::distance(chunk_sizes.begin(), max_it));
+    for (size_t i = 0; i < chunk_sizes.size(); ++i) {
+        size_t this_size = chunk_sizes[i];
+        if (tail_size <= this_size && this_size < chunk_sizes[best_idx]) {
+            best_idx = i;
+        }
+    }
+    return best_idx;
+}
+
+std::vector<ReadChunkPlacement> place_read_chunks(const std::vector<size_t>& chunk_sizes,
+                                                  size_t raw_size,
+                                                  size_t overlap,
+                                                  size_t stride,
+                                                  size_t& tail_size) {
+    const size_t chunk_size_idx = read_chunk_size_idx(chunk_sizes, raw_size);
+    const size_t chunk_size = chunk_sizes[chunk_size_idx];
+    assert(overlap < chunk_size);
+    const size_t signal_chunk_step = chunk_size - overlap;
+
+    std::vector<ReadChunkPlacement> chunks{{0, chunk_size_idx}};
+    size_t offset = 0;
+    tail_size = raw_size;
+    while (offset + chunk_size < raw_size) {
+        if (offset + signal_chunk_step + chunk_size < raw_size) {
+            offset += signal_chunk_step;
+            chunks.push_back({offset, chunk_size_idx});
+            continue;
+        }
+
+        // This is the tail chunk, which ends at the end of the read. Rather than always using a
+        // full chunk, which mostly recomputes the previous chunk, use the smallest chunk size
+        // which still overlaps the previous chunk by overlap. An extra stride is allowed for the
+        // alignment of the chunk start below.
+        tail_size = raw_size - (offset + chunk_size) + overlap + stride;
+        const size_t tail_idx = tail_chunk_size_idx(chunk_sizes, tail_size, chunk_size);
+        auto last_chunk_offset = raw_size - chunk_sizes[tail_idx];
+        auto misalignment = last_chunk_offset % stride;
+        if (misalignment != 0) {
+            // move last chunk start to the next stride boundary. we'll zero pad any excess samples required.
+            last_chunk_offset += stride - misalignment;
+        }
+        offset = last_chunk_offset;
+        chunks.push_back({offset, tail_idx});
+    }
+    return chunks;
+}
+
+std::vector<size_t> suggest_chunk_sizes(const std::vector<int64_t>& tail_size_hist,
+                                        size_t max_chunk_size,
+                                        size_t stride,
+                                        size_t num_chunk_sizes) {
+    // Choose the chunk sizes (in multiples of the histogram bin width) which minimise the number
+    // of padding samples. The largest chunk size is always kept.
+    const size_t num_bins = tail_size_hist.size();
+    if (num_bins == 0) {
+        return {max_chunk_size};
+    }
+    const double bin_width = double(max_chunk_size) / double(num_bins);
+
+    // padding_cost(a, b): padding when bins [a, b) all go to a chunk size at the top of bin b - 1.
+    auto padding_cost = [&](size_t a, size_t b) {
+        double cost = 0;
+        for (size_t i = a; i < b; ++i) {
+            cost += double(tail_size_hist[i]) * (double(b - i) - 0.5) * bin_width;
+        }
+        return cost;
+    };
+
+    // best[k][b]: minimum padding for bins [0, b) using k chunk sizes, the largest ending at bin b.
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    const size_t num_sizes = std::max(size_t{1}, std::min(num_chunk_sizes, num_bins));
+    std::vector<std::vector<double>> best(num_sizes + 1, std::vector<double>(num_bins + 1, inf));
+    std::vector<std::vector<size_t>> prev(num_sizes + 1, std::vector<size_t>(num_bins + 1, 0));
+    best[0][0] = 0;
+    for (size_t k = 1; k <= num_sizes; ++k) {
+        for (size_t b = 1; b <= num_bins; ++b) {
+            for (size_t a = 0; a < b; ++a) {
+                if (best[k - 1][a] == inf) {
+                    continue;
+                }
+                const double cost = best[k - 1][a] + padding_cost(a, b);
+                if (cost < best[k][b]) {
+                    best[k][b] = cost;
+                    prev[k][b] = a;
+                }
+            }
+        }
+    }
+
+    // Only use more chunk sizes if they reduce the padding.
+    size_t k_best = 1;
+    for (size_t k = 1; k <= num_sizes; ++k) {
+        if (best[k][num_bins] < best[k_best][num_bins]) {
+            k_best = k;
+        }
+    }
+
+    std::vector<size_t> chunk_sizes;
+    for (size_t k = k_best, b = num_bins; k > 0; b = prev[k][b], --k) {
+        const size_t size = pad_to(size_t(double(b) * bin_width), stride);
+        chunk_sizes.push_back(std::min(size, max_chunk_size));
+    }
+    return chunk_sizes;
+}
+
+}  // namespace dorado::utils
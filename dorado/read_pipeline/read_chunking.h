@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dorado::utils {
+
+// A chunk of a read: where it starts in the raw data, and which of the basecaller's chunk sizes
+// it is called with.
+struct ReadChunkPlacement {
+    size_t offset;
+    size_t chunk_size_idx;
+};
+
+// Returns the index of the chunk size a read of read_size samples is split with: the smallest
+// which fits the whole read, or the largest if none do.
+size_t read_chunk_size_idx(const std::vector<size_t>& chunk_sizes, size_t read_size);
+
+// Returns the index of the smallest chunk size which fits tail_size samples, only considering
+// chunk sizes no larger than max_chunk_size, or of max_chunk_size if none of those do.
+size_t tail_chunk_size_idx(const std::vector<size_t>& chunk_sizes,
+                           size_t tail_size,
+                           size_t max_chunk_size);
+
+// Splits a read of raw_size samples into chunks which start on a multiple of stride and overlap
+// the chunk before them by at least overlap samples. All but the last chunk use the read's chunk
+// size. The last chunk, which ends at the end of the read, uses the smallest chunk size which
+// still overlaps the previous chunk by overlap. tail_size is set to the number of samples the last
+// chunk needs, which is the whole read if there is only one chunk.
+std::vector<ReadChunkPlacement> place_read_chunks(const std::vector<size_t>& chunk_sizes,
+                                                  size_t raw_size,
+                                                  size_t overlap,
+                                                  size_t stride,
+                                                  size_t& tail_size);
+
+// Returns up to num_chunk_sizes chunk sizes, largest first, which minimise the padding of tail
+// chunks whose sizes follow tail_size_hist. The histogram bins split [0, max_chunk_size) evenly,
+// and each tail is assumed to go to the smallest chunk size which fits it. The sizes are multiples
+// of stride, and the largest is always max_chunk_size.
+std::vector<size_t> suggest_chunk_sizes(const std::vector<int64_t>& tail_size_hist,
+                                        size_t max_chunk_size,
+                                        size_t stride,
+                                        size_t num_chunk_sizes);
+
+}  // namespace dorado::utils
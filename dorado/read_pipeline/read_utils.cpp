@@ -42,6 +42,7 @@ SimplexReadPtr shallow_copy_read(const SimplexRead& read) {
     copy->read_common.model_name = read.read_common.model_name;
 
     copy->read_common.base_mod_probs = read.read_common.base_mod_probs;
+    copy->read_common.sparse_base_mod_probs = read.read_common.sparse_base_mod_probs;
     copy->read_common.mod_base_info = read.read_common.mod_base_info;
 
     copy->read_common.num_trimmed_samples = read.read_common.num_trimmed_samples;
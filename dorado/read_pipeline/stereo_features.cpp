@@ -2,223 +2,206 @@
 
 #include "utils/sequence_utils.h"
 
-#include <ATen/TensorIndexing.h>
-#include <ATen/TensorOperators.h>
+#include <ATen/Functions.h>
+#include <c10/util/Half.h>
 
 #include <algorithm>
 #include <array>
-#include <optional>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
-using namespace at::indexing;
-
-namespace dorado {
-
-at::Tensor generate_stereo_features(const DuplexRead::StereoFeatureInputs& feature_inputs) {
-    const int target_cursor = static_cast<int>(feature_inputs.template_seq_start);
-    const int query_cursor = static_cast<int>(feature_inputs.complement_seq_start);
-
-    // Edlib doesn't provide named constants for alignment array entries, so do it here.
-    // static constexpr unsigned char kAlignMatch = 0;
-    static constexpr unsigned char kAlignInsertionToTarget = 1;
-    static constexpr unsigned char kAlignInsertionToQuery = 2;
-    // static constexpr unsigned char kAlignMismatch = 3;
-
-    // Move along the alignment, filling out the stereo-encoded tensor
-
-    const auto opts = at::TensorOptions().dtype(at::ScalarType::Half).device(at::kCPU);
-
-    static constexpr int kNumFeatures = 13;
-    // Indices of features in the first dimension of the output tensor.
-    static constexpr int kFeatureTemplateSignal = 0;
-    static constexpr int kFeatureComplementSignal = 1;
-    static constexpr int kFeatureTemplateFirstNucleotide = 2;
-    static constexpr int kFeatureComplementFirstNucleotide = 6;
-    static constexpr int kFeatureMoveTable = 10;
-    static constexpr int kFeatureTemplateQScore = 11;
-    static constexpr int kFeatureComplementQScore = 12;
-
-    int template_signal_cursor = 0;
-    int complement_signal_cursor = 0;
-
-    std::vector<uint8_t> template_moves_expanded;
-    for (size_t i = 0; i < feature_inputs.template_moves.size(); ++i) {
-        template_moves_expanded.push_back(feature_inputs.template_moves[i]);
-        for (int j = 0; j < feature_inputs.signal_stride - 1; ++j) {
-            template_moves_expanded.push_back(0);
+namespace {
+
+// Edlib doesn't provide named constants for alignment array entries, so do it here.
+// constexpr unsigned char kAlignMatch = 0;
+constexpr unsigned char kAlignInsertionToTarget = 1;
+constexpr unsigned char kAlignInsertionToQuery = 2;
+// constexpr unsigned char kAlignMismatch = 3;
+
+constexpr int kNumFeatures = 13;
+// Indices of features in the first dimension of the output tensor.
+constexpr int kFeatureTemplateSignal = 0;
+constexpr int kFeatureComplementSignal = 1;
+constexpr int kFeatureTemplateFirstNucleotide = 2;
+constexpr int kFeatureComplementFirstNucleotide = 6;
+constexpr int kFeatureMoveTable = 10;
+constexpr int kFeatureTemplateQScore = 11;
+constexpr int kFeatureComplementQScore = 12;
+
+using SampleType = c10::Half;
+
+// The signal of each base of a read, as the sample index at which each base starts followed by
+// the length of the signal, so base i covers [starts[i], starts[i + 1]).
+class BaseSignalStarts {
+public:
+    // Bases of a read in order, as given by its move table.
+    static BaseSignalStarts forward(const std::vector<uint8_t>& moves, int stride, int signal_len) {
+        BaseSignalStarts starts;
+        for (size_t i = 0; i < moves.size(); ++i) {
+            if (moves[i]) {
+                starts.m_starts.push_back(static_cast<int>(i) * stride);
+            }
         }
+        starts.m_starts.push_back(signal_len);
+        return starts;
     }
 
-    size_t extra_padding = feature_inputs.template_signal.size(0) - template_moves_expanded.size();
-    for (size_t i = 0; i < extra_padding; ++i) {
-        template_moves_expanded.push_back(0);
+    // Bases of a read in reverse order, over its reversed signal. A base starting at sample p of
+    // the signal ends at sample signal_len - p of the reversed signal. The move at sample 0 has no
+    // counterpart, so the start of the reversed signal stands in for it, and if the move table
+    // doesn't begin with a move the samples before the last move are skipped.
+    static BaseSignalStarts reversed(const std::vector<uint8_t>& moves,
+                                     int stride,
+                                     int signal_len) {
+        BaseSignalStarts starts;
+        if (!moves.empty() && moves[0]) {
+            starts.m_starts.push_back(0);
+        }
+        for (size_t i = moves.size(); i-- > 0;) {
+            const int sample = static_cast<int>(i) * stride;
+            if (moves[i] && sample >= 1 && sample < signal_len) {
+                starts.m_starts.push_back(signal_len - sample);
+            }
+        }
+        starts.m_starts.push_back(signal_len);
+        return starts;
     }
 
-    int template_moves_seen = template_moves_expanded[template_signal_cursor];
-    while (template_moves_seen < target_cursor + 1) {
-        ++template_signal_cursor;
-        template_moves_seen += template_moves_expanded[template_signal_cursor];
-    }
+    int start(size_t base) const { return m_starts[base]; }
 
-    std::vector<uint8_t> complement_moves_expanded;
-    for (size_t i = 0; i < feature_inputs.complement_moves.size(); ++i) {
-        complement_moves_expanded.push_back(feature_inputs.complement_moves[i]);
-        for (int j = 0; j < feature_inputs.signal_stride - 1; ++j) {
-            complement_moves_expanded.push_back(0);
+    int length(size_t base) const {
+        if (base + 1 >= m_starts.size()) {
+            throw std::runtime_error("Stereo feature alignment runs past the end of the moves.");
         }
+        return m_starts[base + 1] - m_starts[base];
     }
 
-    extra_padding = feature_inputs.complement_signal.size(0) - complement_moves_expanded.size();
-    for (size_t i = 0; i < extra_padding; ++i) {
-        complement_moves_expanded.push_back(0);
-    }
-    complement_moves_expanded.push_back(1);
-    std::reverse(complement_moves_expanded.begin(), complement_moves_expanded.end());
-    complement_moves_expanded.pop_back();
-
-    int complement_moves_seen = feature_inputs.complement_moves[complement_signal_cursor];
-    while (complement_moves_seen < query_cursor + 1) {
-        ++complement_signal_cursor;
-        complement_moves_seen += complement_moves_expanded[complement_signal_cursor];
+private:
+    std::vector<int> m_starts;
+};
+
+float min_sample(const at::Tensor& signal) {
+    const auto* const samples = signal.data_ptr<SampleType>();
+    float min_value = std::numeric_limits<float>::infinity();
+    for (int64_t i = 0; i < signal.numel(); ++i) {
+        min_value = std::min(min_value, static_cast<float>(samples[i]));
     }
+    return min_value;
+}
 
-    using SampleType = c10::Half;
-
-    // libtorch indexing calls go on a carefree romp through various heap
-    // allocations/deallocations and object constructions/destructions, and so are
-    // glacially slow.  We therefore work with raw pointers within the main loop.
-    const auto* const template_raw_data_ptr = feature_inputs.template_signal.data_ptr<SampleType>();
-    const auto* const flipped_complement_raw_data_ptr =
-            feature_inputs.complement_signal.data_ptr<SampleType>();
-
-    // Package the encoding generation function into a lambda so it can be called
-    // in two modes -
-    // 1. The mode without data copy is run to iterate through data structures
-    // and determine the final size of the tensor needed to store the encoding.
-    // This helps allocate the exact amount of data needed instead of overallocating
-    // the buffer which helps bring down overall memory footprint.
-    // 2. The mode with data copy that actually fills up the encoding tensor
-    // with the right data needed for inference.
-    auto determine_encoding = [&](at::Tensor* stereo_features, int current_target_cursor,
-                                  int current_query_cursor, int current_template_signal_cursor,
-                                  int current_complement_signal_cursor) -> int {
-        size_t stereo_global_cursor = 0;  // Index into the stereo-encoded signal
-        std::array<SampleType*, kNumFeatures> feature_ptrs;
-        if (stereo_features) {
-            for (int feature_idx = 0; feature_idx < kNumFeatures; ++feature_idx) {
-                feature_ptrs[feature_idx] = (*stereo_features)[feature_idx].data_ptr<SampleType>();
-            }
-        }
-        for (auto alignment_entry : feature_inputs.alignment) {
-            // We move along every alignment position. For every position we need to add signal and padding.
-            size_t total_segment_length = 0;
-
-            // Adds the segment of the signal associated with the current base, updating
-            // total_segment_length to reflect the maximum across successive invocations.
-            auto add_signal = [&total_segment_length, stereo_global_cursor, &stereo_features,
-                               feature_ptrs](const std::vector<uint8_t>& moves_expanded,
-                                             int& signal_cursor, int feature_index,
-                                             const SampleType* const raw_data_ptr) {
-                const auto max_signal_length = moves_expanded.size();
-                const auto* const start_ptr = &moves_expanded[signal_cursor + 1];
-                const auto* const next_move_ptr =
-                        static_cast<const uint8_t*>(std::memchr(start_ptr, 1, max_signal_length));
-                const size_t sample_count =
-                        next_move_ptr ? (next_move_ptr - start_ptr) : max_signal_length;
-
-                if (stereo_features) {
-                    // Assumes contiguity of successive elements.
-                    std::memcpy(&feature_ptrs[feature_index][stereo_global_cursor],
-                                &raw_data_ptr[signal_cursor],
-                                (sample_count + 1) * sizeof(SampleType));
-                }
-
-                const size_t segment_length = sample_count + 1;
-                total_segment_length = std::max(total_segment_length, segment_length);
-                signal_cursor += static_cast<int>(segment_length);
-            };
-
-            // If there is *not* an insertion to the query, add the nucleotide from the target cursor.
-            if (alignment_entry != kAlignInsertionToQuery) {
-                add_signal(template_moves_expanded, current_template_signal_cursor,
-                           kFeatureTemplateSignal, template_raw_data_ptr);
-            }
+}  // namespace
 
-            // If there is *not* an insertion to the target, add the nucleotide from the query cursor
-            if (alignment_entry != kAlignInsertionToTarget) {
-                add_signal(complement_moves_expanded, current_complement_signal_cursor,
-                           kFeatureComplementSignal, flipped_complement_raw_data_ptr);
-            }
-
-            // Now, add the nucleotides and q scores.  We need to do this after determining
-            // total_segment_length.
-            auto add_nucleotide_and_q = [total_segment_length, stereo_global_cursor, feature_ptrs](
-                                                const char nucleotide, const char q_score,
-                                                const int first_nucleotide_feature_index,
-                                                const int q_feature_index) {
-                const auto nucleotide_feature_idx =
-                        first_nucleotide_feature_index + dorado::utils::base_to_int(nucleotide);
-                std::fill_n(&feature_ptrs[nucleotide_feature_idx][stereo_global_cursor],
-                            total_segment_length, static_cast<SampleType>(1.0f));
-
-                // Convert Q scores from char to SampleType, with appropriate scale/offset.
-                const auto q_score_sample_type =
-                        static_cast<SampleType>(static_cast<float>(q_score - 33) / 90.0f);
-                std::fill_n(&feature_ptrs[q_feature_index][stereo_global_cursor],
-                            total_segment_length, q_score_sample_type);
-            };
+namespace dorado {
 
+at::Tensor generate_stereo_features(const DuplexRead::StereoFeatureInputs& feature_inputs) {
+    const auto& alignment = feature_inputs.alignment;
+    const auto& template_signal = feature_inputs.template_signal;
+    const auto& complement_signal = feature_inputs.complement_signal;
+
+    // The complement signal has been flipped, so its bases run backwards through its move table.
+    const auto template_starts = BaseSignalStarts::forward(
+            feature_inputs.template_moves, feature_inputs.signal_stride,
+            static_cast<int>(template_signal.size(0)));
+    const auto complement_starts = BaseSignalStarts::reversed(
+            feature_inputs.complement_moves, feature_inputs.signal_stride,
+            static_cast<int>(complement_signal.size(0)));
+
+    const size_t first_template_base = feature_inputs.template_seq_start;
+    const size_t first_complement_base = feature_inputs.complement_seq_start;
+
+    // Every alignment position takes as many samples as the longer of the template and complement
+    // signal for its bases, so walk the alignment once to size the output.
+    size_t num_samples = 0;
+    {
+        size_t template_base = first_template_base;
+        size_t complement_base = first_complement_base;
+        for (const auto alignment_entry : alignment) {
+            int segment_length = 0;
             if (alignment_entry != kAlignInsertionToQuery) {
-                if (stereo_features) {
-                    add_nucleotide_and_q(feature_inputs.template_seq[current_target_cursor],
-                                         feature_inputs.template_qstring[current_target_cursor],
-                                         kFeatureTemplateFirstNucleotide, kFeatureTemplateQScore);
-                }
-
-                // Anything but a query insertion causes the target cursor to advance.
-                ++current_target_cursor;
+                segment_length = template_starts.length(template_base++);
             }
-
-            // Now, add the nucleotides and q scores
             if (alignment_entry != kAlignInsertionToTarget) {
-                if (stereo_features) {
-                    add_nucleotide_and_q(
-                            feature_inputs.complement_seq[current_query_cursor],
-                            feature_inputs.complement_qstring.rbegin()[current_query_cursor],
-                            kFeatureComplementFirstNucleotide, kFeatureComplementQScore);
-                }
-
-                // Anything but a target insertion causes the query cursor to advance.
-                ++current_query_cursor;
-            }
-
-            if (stereo_features) {
-                feature_ptrs[kFeatureMoveTable][stereo_global_cursor] =
-                        static_cast<SampleType>(1);  // set the move table
+                segment_length =
+                        std::max(segment_length, complement_starts.length(complement_base++));
             }
-
-            // Update the global cursor
-            stereo_global_cursor += total_segment_length;
+            num_samples += segment_length;
         }
-        return static_cast<int>(stereo_global_cursor);
-    };
-
-    // Call the encoding lambda first without data copy to get an estimate
-    // of the encoding size.
-    const auto encoding_tensor_size = determine_encoding(
-            nullptr, target_cursor, query_cursor, template_signal_cursor, complement_signal_cursor);
+    }
 
-    const float pad_value = 0.8f * std::min(at::min(feature_inputs.complement_signal).item<float>(),
-                                            at::min(feature_inputs.template_signal).item<float>());
-    auto stereo_features = at::zeros({kNumFeatures, encoding_tensor_size}, opts);
+    // Signal features are padded with a value a little below the smallest sample, and all the
+    // others with zero.
+    const float pad_value =
+            0.8f * std::min(min_sample(complement_signal), min_sample(template_signal));
+    auto stereo_features =
+            at::empty({kNumFeatures, static_cast<int64_t>(num_samples)},
+                      at::TensorOptions().dtype(at::ScalarType::Half).device(at::kCPU));
+    auto* const features = stereo_features.data_ptr<SampleType>();
+    std::array<SampleType*, kNumFeatures> feature_ptrs;
+    for (int feature_idx = 0; feature_idx < kNumFeatures; ++feature_idx) {
+        feature_ptrs[feature_idx] = features + feature_idx * num_samples;
+    }
+    std::fill_n(feature_ptrs[kFeatureTemplateSignal], 2 * num_samples,
+                static_cast<SampleType>(pad_value));
+    std::fill_n(feature_ptrs[kFeatureTemplateFirstNucleotide], (kNumFeatures - 2) * num_samples,
+                static_cast<SampleType>(0.0f));
+
+    const auto* const template_samples = template_signal.data_ptr<SampleType>();
+    const auto* const complement_samples = complement_signal.data_ptr<SampleType>();
+
+    auto add_base = [&feature_ptrs](size_t cursor, size_t segment_length, int signal_feature_idx,
+                                    const SampleType* signal, int signal_length, char nucleotide,
+                                    char q_score, int first_nucleotide_feature_idx,
+                                    int q_feature_idx) {
+        std::memcpy(&feature_ptrs[signal_feature_idx][cursor], signal,
+                    signal_length * sizeof(SampleType));
+
+        const auto nucleotide_feature_idx =
+                first_nucleotide_feature_idx + dorado::utils::base_to_int(nucleotide);
+        std::fill_n(&feature_ptrs[nucleotide_feature_idx][cursor], segment_length,
+                    static_cast<SampleType>(1.0f));
+
+        // Convert Q scores from char to SampleType, with appropriate scale/offset.
+        const auto q_score_sample_type =
+                static_cast<SampleType>(static_cast<float>(q_score - 33) / 90.0f);
+        std::fill_n(&feature_ptrs[q_feature_idx][cursor], segment_length, q_score_sample_type);
+    };
 
-    // Start with all signal feature entries equal to the padding value.
-    stereo_features.index({at::indexing::Slice(None, 2)}) = pad_value;
+    size_t template_base = first_template_base;
+    size_t complement_base = first_complement_base;
+    size_t cursor = 0;  // Index into the stereo-encoded signal
+    for (const auto alignment_entry : alignment) {
+        const bool has_template_base = alignment_entry != kAlignInsertionToQuery;
+        const bool has_complement_base = alignment_entry != kAlignInsertionToTarget;
+        const int template_length = has_template_base ? template_starts.length(template_base) : 0;
+        const int complement_length =
+                has_complement_base ? complement_starts.length(complement_base) : 0;
+        const auto segment_length =
+                static_cast<size_t>(std::max(template_length, complement_length));
+
+        // Anything but a query insertion causes the template cursor to advance, and anything but
+        // a target insertion causes the complement cursor to advance.
+        if (has_template_base) {
+            add_base(cursor, segment_length, kFeatureTemplateSignal,
+                     &template_samples[template_starts.start(template_base)], template_length,
+                     feature_inputs.template_seq[template_base],
+                     feature_inputs.template_qstring[template_base],
+                     kFeatureTemplateFirstNucleotide, kFeatureTemplateQScore);
+            ++template_base;
+        }
+        if (has_complement_base) {
+            add_base(cursor, segment_length, kFeatureComplementSignal,
+                     &complement_samples[complement_starts.start(complement_base)],
+                     complement_length, feature_inputs.complement_seq[complement_base],
+                     feature_inputs.complement_qstring.rbegin()[complement_base],
+                     kFeatureComplementFirstNucleotide, kFeatureComplementQScore);
+            ++complement_base;
+        }
 
-    // Call the encoding lambda again, this time with the correctly sized tensor
-    // allocated for the final data to be filled in.
-    determine_encoding(&stereo_features, target_cursor, query_cursor, template_signal_cursor,
-                       complement_signal_cursor);
+        feature_ptrs[kFeatureMoveTable][cursor] = static_cast<SampleType>(1);  // set the move table
+        cursor += segment_length;
+    }
 
     return stereo_features;
 }
@@ -5,77 +5,97 @@
 
 #include <algorithm>
 #include <cassert>
+#include <numeric>
+#include <stdexcept>
 
 namespace dorado::utils {
 
-void stitch_chunks(ReadCommon& read_common,
-                   const std::vector<std::unique_ptr<Chunk>>& called_chunks) {
-    assert(static_cast<int>(div_round_closest(called_chunks[0]->raw_chunk_size,
-                                              called_chunks[0]->moves.size())) ==
-           read_common.model_stride);
-
-    int start_pos = 0;
-    int mid_point_front = 0;
-    std::vector<uint8_t> moves;
-    std::vector<std::string> sequences;
-    std::vector<std::string> qstrings;
-
-    for (int i = 0; i < int(called_chunks.size() - 1); i++) {
-        auto& current_chunk = called_chunks[i];
-        auto& next_chunk = called_chunks[i + 1];
-        int overlap_size = int((current_chunk->raw_chunk_size + current_chunk->input_offset) -
-                               (next_chunk->input_offset));
-        assert(overlap_size % read_common.model_stride == 0);
-        int overlap_down_sampled = overlap_size / read_common.model_stride;
+ChunkStitcher::ChunkStitcher(std::vector<size_t> chunk_offsets,
+                             size_t raw_data_samples,
+                             int model_stride)
+        : m_chunk_offsets(std::move(chunk_offsets)),
+          m_raw_data_samples(raw_data_samples),
+          m_model_stride(model_stride),
+          m_pending_chunks(m_chunk_offsets.size()) {
+    // There is one move per stride, plus at most one for a partial stride overhang. Each move emits
+    // at most one base, so the same bound covers the bases of every chunk after trimming, and none
+    // of the buffers need to regrow or be trimmed in finalise.
+    const size_t max_moves = raw_data_samples / model_stride + 1;
+    m_moves.reserve(max_moves);
+    m_seq.reserve(max_moves);
+    m_qstring.reserve(max_moves);
+}
+
+bool ChunkStitcher::add_chunk(size_t idx, std::unique_ptr<Chunk> chunk) {
+    if (idx != m_next_chunk_idx) {
+        m_pending_chunks[idx] = std::move(chunk);
+        return false;
+    }
+    append_next_chunk(*chunk);
+    chunk.reset();
+    while (m_next_chunk_idx < m_pending_chunks.size() && m_pending_chunks[m_next_chunk_idx]) {
+        auto next_chunk = std::move(m_pending_chunks[m_next_chunk_idx]);
+        append_next_chunk(*next_chunk);
+    }
+    return m_next_chunk_idx == m_chunk_offsets.size();
+}
+
+void ChunkStitcher::append_next_chunk(const Chunk& chunk) {
+    assert(static_cast<int>(div_round_closest(chunk.raw_chunk_size, chunk.moves.size())) ==
+           m_model_stride);
+    assert(m_next_chunk_idx < m_chunk_offsets.size());
+
+    int start_pos = std::accumulate(chunk.moves.begin(),
+                                    std::next(chunk.moves.begin(), m_mid_point_front), 0);
+
+    const bool is_last_chunk = (m_next_chunk_idx + 1 == m_chunk_offsets.size());
+    if (!is_last_chunk) {
+        const size_t next_offset = m_chunk_offsets[m_next_chunk_idx + 1];
+        int overlap_size = int((chunk.raw_chunk_size + chunk.input_offset) - next_offset);
+        assert(overlap_size % m_model_stride == 0);
+        int overlap_down_sampled = overlap_size / m_model_stride;
         int mid_point_rear = overlap_down_sampled / 2;
 
         int current_chunk_bases_to_trim =
-                std::accumulate(std::prev(current_chunk->moves.end(), mid_point_rear),
-                                current_chunk->moves.end(), 0);
-
-        int current_chunk_seq_len = int(current_chunk->seq.size());
-        int end_pos = current_chunk_seq_len - current_chunk_bases_to_trim;
-        int trimmed_len = end_pos - start_pos;
-        sequences.push_back(current_chunk->seq.substr(start_pos, trimmed_len));
-        qstrings.push_back(current_chunk->qstring.substr(start_pos, trimmed_len));
-        moves.insert(moves.end(), std::next(current_chunk->moves.begin(), mid_point_front),
-                     std::prev(current_chunk->moves.end(), mid_point_rear));
-
-        mid_point_front = overlap_down_sampled - mid_point_rear;
-
-        start_pos = 0;
-        for (int j = 0; j < mid_point_front; j++) {
-            start_pos += (int)next_chunk->moves[j];
-        }
-    }
+                std::accumulate(std::prev(chunk.moves.end(), mid_point_rear), chunk.moves.end(), 0);
 
-    // Append the final chunk
-    auto& last_chunk = called_chunks.back();
-    moves.insert(moves.end(), std::next(last_chunk->moves.begin(), mid_point_front),
-                 last_chunk->moves.end());
+        int end_pos = int(chunk.seq.size()) - current_chunk_bases_to_trim;
+        m_seq.append(chunk.seq, start_pos, end_pos - start_pos);
+        m_qstring.append(chunk.qstring, start_pos, end_pos - start_pos);
+        m_moves.insert(m_moves.end(), std::next(chunk.moves.begin(), m_mid_point_front),
+                       std::prev(chunk.moves.end(), mid_point_rear));
 
-    if (called_chunks.size() == 1) {
+        m_mid_point_front = overlap_down_sampled - mid_point_rear;
+    } else if (m_chunk_offsets.size() == 1) {
         // shorten the sequence, qstring & moves where the read is shorter than chunksize
-        int last_index_in_moves_to_keep =
-                int(read_common.get_raw_data_samples() / read_common.model_stride);
-        moves = std::vector<uint8_t>(moves.begin(), moves.begin() + last_index_in_moves_to_keep);
-        int end = std::accumulate(moves.begin(), moves.end(), 0);
-        sequences.push_back(last_chunk->seq.substr(start_pos, end));
-        qstrings.push_back(last_chunk->qstring.substr(start_pos, end));
-
+        auto moves_end = std::next(chunk.moves.begin(),
+                                   std::min(chunk.moves.size(),
+                                            size_t(m_raw_data_samples / m_model_stride)));
+        int end = std::accumulate(chunk.moves.begin(), moves_end, 0);
+        m_seq.append(chunk.seq, 0, end);
+        m_qstring.append(chunk.qstring, 0, end);
+        m_moves.insert(m_moves.end(), chunk.moves.begin(), moves_end);
     } else {
-        sequences.push_back(last_chunk->seq.substr(start_pos));
-        qstrings.push_back(last_chunk->qstring.substr(start_pos));
+        m_seq.append(chunk.seq, start_pos);
+        m_qstring.append(chunk.qstring, start_pos);
+        m_moves.insert(m_moves.end(), std::next(chunk.moves.begin(), m_mid_point_front),
+                       chunk.moves.end());
+    }
+    ++m_next_chunk_idx;
+}
+
+void ChunkStitcher::finalise(ReadCommon& read_common) {
+    if (m_next_chunk_idx != m_chunk_offsets.size()) {
+        throw std::logic_error("ChunkStitcher finalised before all chunks were added.");
     }
 
-    // Set the read seq and qstring
-    read_common.seq = std::accumulate(sequences.begin(), sequences.end(), std::string(""));
-    read_common.qstring = std::accumulate(qstrings.begin(), qstrings.end(), std::string(""));
-    read_common.moves = std::move(moves);
+    read_common.seq = std::move(m_seq);
+    read_common.qstring = std::move(m_qstring);
+    read_common.moves = std::move(m_moves);
 
     // remove partial stride overhang
     if (static_cast<int>(read_common.moves.size()) >
-        static_cast<int>(read_common.get_raw_data_samples() / read_common.model_stride)) {
+        static_cast<int>(m_raw_data_samples / m_model_stride)) {
         if (read_common.moves.back() == 1) {
             read_common.seq.pop_back();
             read_common.qstring.pop_back();
@@ -86,4 +106,20 @@ void stitch_chunks(ReadCommon& read_common,
     }
 }
 
+void stitch_chunks(ReadCommon& read_common,
+                   const std::vector<std::unique_ptr<Chunk>>& called_chunks) {
+    std::vector<size_t> chunk_offsets;
+    chunk_offsets.reserve(called_chunks.size());
+    for (const auto& chunk : called_chunks) {
+        chunk_offsets.push_back(chunk->input_offset);
+    }
+
+    ChunkStitcher stitcher(std::move(chunk_offsets), read_common.get_raw_data_samples(),
+                           read_common.model_stride);
+    for (const auto& chunk : called_chunks) {
+        stitcher.append_next_chunk(*chunk);
+    }
+    stitcher.finalise(read_common);
+}
+
 }  // namespace dorado::utils
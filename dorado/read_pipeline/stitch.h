@@ -23,6 +23,42 @@ struct Chunk {
     std::vector<uint8_t> moves;  // For stitching.
 };
 
+// Stitches the called chunks of a read (accounting for overlap) as they arrive. Each chunk is
+// trimmed and appended to the read's buffers as soon as all the chunks before it have been, and is
+// then freed, so a long read never holds all of its called chunks or needs a final concatenation.
+// Not thread safe.
+class ChunkStitcher {
+public:
+    // chunk_offsets are the input offsets of every chunk of the read, in order. The buffers are
+    // reserved for a read of raw_data_samples samples called with a model of stride model_stride.
+    ChunkStitcher(std::vector<size_t> chunk_offsets, size_t raw_data_samples, int model_stride);
+
+    // Takes ownership of the called chunk at idx and appends it and any following chunks which
+    // were waiting for it. Returns true once every chunk of the read has been appended.
+    bool add_chunk(size_t idx, std::unique_ptr<Chunk> chunk);
+
+    // Appends chunk as the next chunk of the read, for callers which already have them in order.
+    void append_next_chunk(const Chunk& chunk);
+
+    // Assigns the stitched seq, qstring and moves to read. Must only be called once add_chunk has
+    // returned true.
+    void finalise(ReadCommon& read);
+
+private:
+    const std::vector<size_t> m_chunk_offsets;
+    const size_t m_raw_data_samples;
+    const int m_model_stride;
+    // Chunks which have arrived before their predecessors.
+    std::vector<std::unique_ptr<Chunk>> m_pending_chunks;
+    size_t m_next_chunk_idx = 0;
+    // Moves to skip at the start of the next chunk, which overlap the previous one.
+    int m_mid_point_front = 0;
+
+    std::string m_seq;
+    std::string m_qstring;
+    std::vector<uint8_t> m_moves;
+};
+
 // Given a read and its unstitched chunks, stitch the chunks (accounting for overlap) and assign basecalled read and
 // qstring to Read
 void stitch_chunks(ReadCommon& read, const std::vector<std::unique_ptr<Chunk>>& called_chunks);
@@ -8,7 +8,6 @@
 #include "utils/sequence_utils.h"
 #include "utils/uuid_utils.h"
 
-#include <ATen/TensorIndexing.h>
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
@@ -124,6 +123,8 @@ struct DuplexReadSplitter::ExtRead {
     at::Tensor data_as_float32;
     std::vector<uint64_t> move_sums;
     splitter::PosRanges possible_pore_regions;
+    // Edit distance of the best adapter match near each of |possible_pore_regions|.
+    std::vector<std::size_t> pore_region_adapter_edists;
 };
 
 DuplexReadSplitter::ExtRead DuplexReadSplitter::create_ext_read(SimplexReadPtr r) const {
@@ -134,15 +135,17 @@ DuplexReadSplitter::ExtRead DuplexReadSplitter::create_ext_read(SimplexReadPtr r
     assert(ext_read.move_sums.back() == ext_read.read->read_common.seq.length());
     ext_read.data_as_float32 = ext_read.read->read_common.raw_data.to(at::kFloat);
     ext_read.possible_pore_regions = possible_pore_regions(ext_read);
+    ext_read.pore_region_adapter_edists =
+            nearby_adapter_edists(*ext_read.read, ext_read.possible_pore_regions);
     return ext_read;
 }
 
 PosRanges DuplexReadSplitter::possible_pore_regions(const DuplexReadSplitter::ExtRead& read) const {
     spdlog::trace("Analyzing signal in read {}", read.read->read_common.read_id);
 
-    auto pore_sample_ranges =
-            detect_pore_signal<float>(read.data_as_float32, m_settings.pore_thr,
-                                      m_settings.pore_cl_dist, m_settings.expect_pore_prefix);
+    auto pore_sample_ranges = detect_pore_signal(
+            read.data_as_float32.data_ptr<float>(), uint64_t(read.data_as_float32.size(0)),
+            m_settings.pore_thr, m_settings.pore_cl_dist, m_settings.expect_pore_prefix);
 
     std::vector<std::pair<float, PosRange>> candidate_regions;
     for (auto pore_sample_range : pore_sample_ranges) {
@@ -315,9 +318,10 @@ PosRanges DuplexReadSplitter::find_muA_adapter_spikes(const ExtRead& read) const
         const auto spike_search_begin_s =
                 from_basespace(adapter_match.first - max_spike_adapter_dist);
         const auto spike_search_end_s = from_basespace(muA_range.first);
-        const auto search_span = read.data_as_float32.index(
-                {at::indexing::Slice(spike_search_begin_s, spike_search_end_s)});
-        const auto spike_peak_s = spike_search_begin_s + search_span.argmax().item().toLong();
+        const float* const signal = read.data_as_float32.data_ptr<float>();
+        const auto spike_peak_s = std::distance(
+                signal,
+                std::max_element(signal + spike_search_begin_s, signal + spike_search_end_s));
         // Convert back to base space.
         const auto spike_begin = to_basespace(spike_peak_s);
         const auto spike_end = spike_begin + 5;
@@ -343,14 +347,33 @@ PosRanges DuplexReadSplitter::find_muA_adapter_spikes(const ExtRead& read) const
     return spike_ranges;
 }
 
-bool DuplexReadSplitter::check_nearby_adapter(const SimplexRead& read,
-                                              PosRange r,
-                                              int adapter_edist) const {
-    return find_best_adapter_match(m_settings.adapter, read.read_common.seq, adapter_edist,
-                                   //including spacer region in search
-                                   {r.first, std::min(r.second + m_settings.pore_adapter_span,
-                                                      (uint64_t)read.read_common.seq.size())})
-            .has_value();
+std::vector<std::size_t> DuplexReadSplitter::nearby_adapter_edists(
+        const SimplexRead& read,
+        const PosRanges& pore_regions) const {
+    const std::string_view seq = read.read_common.seq;
+    std::vector<std::string_view> search_spans;
+    search_spans.reserve(pore_regions.size());
+    for (const auto& r : pore_regions) {
+        //including spacer region in search
+        const auto search_start = std::min<uint64_t>(r.first, seq.size());
+        const auto search_end =
+                std::min<uint64_t>(r.second + m_settings.pore_adapter_span, seq.size());
+        search_spans.push_back(seq.substr(search_start, search_end - search_start));
+    }
+    // Every region is searched for the same adapter, so several are scanned at once.
+    return myers_best_edists(m_settings.adapter, search_spans);
+}
+
+PosRanges DuplexReadSplitter::pore_regions_near_adapter(const ExtRead& read,
+                                                        int adapter_edist) const {
+    assert(read.pore_region_adapter_edists.size() == read.possible_pore_regions.size());
+    PosRanges regions;
+    for (size_t i = 0; i < read.possible_pore_regions.size(); ++i) {
+        if (read.pore_region_adapter_edists[i] <= std::size_t(adapter_edist)) {
+            regions.push_back(read.possible_pore_regions[i]);
+        }
+    }
+    return regions;
 }
 
 //'spacer' is region potentially containing templ/compl strand boundary
@@ -526,9 +549,7 @@ std::vector<DuplexReadSplitter::ExtRead> DuplexReadSplitter::apply_split_finders
     split_reads.push_back(std::move(orig_read));
 
     apply_split_finder(split_reads, "PORE_ADAPTER", [this](const ExtRead& read) {
-        return filter_ranges(read.possible_pore_regions, [this, &read](PosRange r) {
-            return check_nearby_adapter(*read.read, r, m_settings.adapter_edist);
-        });
+        return pore_regions_near_adapter(read, m_settings.adapter_edist);
     });
 
     if (is_rapid) {
@@ -547,11 +568,12 @@ std::vector<DuplexReadSplitter::ExtRead> DuplexReadSplitter::apply_split_finders
 
         apply_split_finder(split_reads, "PORE_ALL", [this](const ExtRead& read) {
             auto filter = [this, &read](PosRange r) {
-                return check_nearby_adapter(*read.read, r, m_settings.relaxed_adapter_edist) &&
-                       check_flank_match(*read.read, r, m_settings.relaxed_flank_err);
+                return check_flank_match(*read.read, r, m_settings.relaxed_flank_err);
             };
-            return merge_ranges(filter_ranges(read.possible_pore_regions, filter),
-                                m_settings.strand_end_flank + m_settings.strand_start_flank);
+            return merge_ranges(
+                    filter_ranges(pore_regions_near_adapter(read, m_settings.relaxed_adapter_edist),
+                                  filter),
+                    m_settings.strand_end_flank + m_settings.strand_start_flank);
         });
 
         apply_split_finder(split_reads, "ADAPTER_FLANK", [this](const ExtRead& read) {
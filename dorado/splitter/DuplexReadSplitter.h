@@ -24,9 +24,9 @@ private:
     ExtRead create_ext_read(SimplexReadPtr r) const;
     PosRanges possible_pore_regions(const ExtRead& read) const;
     PosRanges find_muA_adapter_spikes(const ExtRead& read) const;
-    bool check_nearby_adapter(const SimplexRead& read,
-                              splitter::PosRange r,
-                              int adapter_edist) const;
+    std::vector<std::size_t> nearby_adapter_edists(const SimplexRead& read,
+                                                   const PosRanges& pore_regions) const;
+    PosRanges pore_regions_near_adapter(const ExtRead& read, int adapter_edist) const;
     std::optional<std::pair<splitter::PosRange, splitter::PosRange>>
     check_flank_match(const SimplexRead& read, splitter::PosRange r, float err_thr) const;
     std::optional<splitter::PosRange> identify_middle_adapter_split(const SimplexRead& read) const;
@@ -2,11 +2,14 @@
 
 #include "utils/PostCondition.h"
 #include "utils/alignment_utils.h"
+#include "utils/simd.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <iomanip>
+#include <numeric>
 #include <optional>
 #include <ostream>
 
@@ -14,14 +17,44 @@ namespace dorado::splitter {
 
 namespace {
 
-// Returns the array D[0..n], where D[i] is equal to local alignment of the pattern to suffix of text[0..i).
-std::vector<size_t> d_myers(const char* pattern, size_t m, const char* text, size_t n) {
-    constexpr size_t MAX_ALPHABET = 256;
-    assert(m < 64);
-    uint64_t PM[MAX_ALPHABET]{};
+constexpr size_t MAX_ALPHABET = 256;
+constexpr size_t MAX_QUERY_LEN = 63;
+
+// The pattern bitmasks of each character, with bit i set if pattern[i] is that character.
+using PatternMasks = std::array<uint64_t, MAX_ALPHABET>;
+
+PatternMasks pattern_masks(const char* pattern, size_t m) {
+    assert(m <= MAX_QUERY_LEN);
+    PatternMasks PM{};
     for (size_t i = 0; i < m; i++) {
         PM[static_cast<uint8_t>(pattern[i])] |= uint64_t{1} << i;
     }
+    return PM;
+}
+
+// Advances the vertical deltas VP/VN of the last DP column, and the score of its last row, by one
+// text character whose pattern bitmask is EQ.
+inline void myers_step(uint64_t EQ, size_t m, uint64_t& VP, uint64_t& VN, size_t& score) {
+    const uint64_t D0 = (((EQ & VP) + VP) ^ VP) | EQ | VN;
+    uint64_t HP = VN | ~(D0 | VP);
+    uint64_t HN = D0 & VP;
+
+    if (HP & (uint64_t{1} << (m - 1))) {
+        score++;
+    }
+    if (HN & (uint64_t{1} << (m - 1))) {
+        score--;
+    }
+
+    HP <<= 1;
+    HN <<= 1;
+    VP = HN | ~(D0 | HP);
+    VN = D0 & HP;
+}
+
+// Returns the array D[0..n], where D[i] is equal to local alignment of the pattern to suffix of text[0..i).
+std::vector<size_t> d_myers(const char* pattern, size_t m, const char* text, size_t n) {
+    const auto PM = pattern_masks(pattern, m);
 
     std::vector<size_t> D(n + 1);
     uint64_t VP = ~uint64_t{0};
@@ -29,38 +62,185 @@ std::vector<size_t> d_myers(const char* pattern, size_t m, const char* text, siz
     size_t score = m;
     D[0] = score;
     for (size_t j = 0; j < n; j++) {
-        const uint64_t EQ = PM[static_cast<uint8_t>(text[j])];
-        const uint64_t D0 = (((EQ & VP) + VP) ^ VP) | EQ | VN;
-        uint64_t HP = VN | ~(D0 | VP);
-        uint64_t HN = D0 & VP;
+        myers_step(PM[static_cast<uint8_t>(text[j])], m, VP, VN, score);
+        D[j + 1] = score;
+    }
+    return D;
+}
 
-        if (HP & (uint64_t{1} << (m - 1))) {
-            score++;
+// Number of query and sequence pairs that myers_lanes() scans together, one in each 64-bit lane of
+// an AVX2 register.
+constexpr size_t NUM_LANES = 4;
+
+// A query and the sequence it's scanned over in each lane. The lanes can hold several queries over
+// the same sequence, or the same query over several sequences. Unused lanes have an empty query
+// and sequence.
+struct Lanes {
+    std::array<const PatternMasks*, NUM_LANES> masks{};
+    std::array<uint64_t, NUM_LANES> query_lens{};
+    std::array<const char*, NUM_LANES> seqs{};
+    std::array<uint64_t, NUM_LANES> seq_lens{};
+};
+
+using LaneColumns = std::array<std::vector<size_t>, NUM_LANES>;
+
+// Scans the query of each lane over its sequence, returning the lowest score of the query's last
+// row in each lane, which is the best edist of the whole query against any part of the sequence.
+// If |columns| isn't null, (*columns)[k] is filled with the d_myers() column of lane k too.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+std::array<size_t, NUM_LANES> myers_lanes(const Lanes& lanes, LaneColumns* columns) {
+    std::array<size_t, NUM_LANES> best{};
+    for (size_t lane = 0; lane < NUM_LANES; lane++) {
+        const size_t m = lanes.query_lens[lane];
+        const size_t n = lanes.seq_lens[lane];
+        if (m == 0) {
+            continue;
         }
-        if (HN & (uint64_t{1} << (m - 1))) {
-            score--;
+        const auto& PM = *lanes.masks[lane];
+        uint64_t VP = ~uint64_t{0};
+        uint64_t VN = 0;
+        size_t score = m;
+        best[lane] = score;
+        if (columns) {
+            (*columns)[lane].resize(n + 1);
+            (*columns)[lane][0] = score;
+        }
+        for (size_t j = 0; j < n; j++) {
+            myers_step(PM[static_cast<uint8_t>(lanes.seqs[lane][j])], m, VP, VN, score);
+            best[lane] = std::min(best[lane], score);
+            if (columns) {
+                (*columns)[lane][j + 1] = score;
+            }
         }
-        D[j + 1] = score;
-
-        HP <<= 1;
-        HN <<= 1;
-        VP = HN | ~(D0 | HP);
-        VN = D0 & HP;
     }
-    return D;
+    return best;
 }
 
-}  // namespace
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2"))) std::array<size_t, NUM_LANES> myers_lanes(const Lanes& lanes,
+                                                                          LaneColumns* columns) {
+    const __m256i all_ones = _mm256_set1_epi64x(-1);
+    std::array<uint64_t, NUM_LANES> last_bits{};
+    size_t longest_lane = 0;
+    for (size_t lane = 0; lane < NUM_LANES; lane++) {
+        if (lanes.query_lens[lane] > 0) {
+            last_bits[lane] = uint64_t{1} << (lanes.query_lens[lane] - 1);
+        }
+        if (lanes.seq_lens[lane] > lanes.seq_lens[longest_lane]) {
+            longest_lane = lane;
+        }
+        if (columns) {
+            (*columns)[lane].resize(lanes.seq_lens[lane] + 1);
+            (*columns)[lane][0] = lanes.query_lens[lane];
+        }
+    }
+    const __m256i last_bit = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(last_bits.data()));
+    const __m256i seq_lens =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.seq_lens.data()));
+    __m256i VP = all_ones;
+    __m256i VN = _mm256_setzero_si256();
+    __m256i score = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.query_lens.data()));
+    // The running minimum of each lane stays in a register, and is only stored once at the end.
+    __m256i best = score;
 
-std::vector<EdistResult> myers_align(std::string_view query,
-                                     std::string_view seq,
-                                     std::size_t max_edist) {
+    // The scores of a block of characters are stored interleaved, one vector per character, and
+    // copied out to each lane's column once the block is done.
+    constexpr size_t BLOCK_SIZE = 64;
+    std::array<uint64_t, NUM_LANES * BLOCK_SIZE> block_scores;
+    size_t block_start = 0;
+    auto copy_out_block = [&](size_t block_end) {
+        for (size_t lane = 0; lane < NUM_LANES; lane++) {
+            const size_t lane_end = std::min(block_end, size_t(lanes.seq_lens[lane]));
+            auto& column = (*columns)[lane];
+            for (size_t j = block_start; j < lane_end; j++) {
+                column[j + 1] = block_scores[(j - block_start) * NUM_LANES + lane];
+            }
+        }
+        block_start = block_end;
+    };
+
+    // Lanes past the end of their sequence, or unused, read the longest sequence through masks
+    // which match nothing, so the loop over characters doesn't need to check every lane.
+    static const PatternMasks no_matches{};
+    std::array<const PatternMasks*, NUM_LANES> masks;
+    std::array<const uint8_t*, NUM_LANES> seqs;
+    const size_t max_seq_len = lanes.seq_lens[longest_lane];
+    for (size_t j = 0; j < max_seq_len;) {
+        // Step up to the end of the next sequence to finish.
+        size_t segment_end = max_seq_len;
+        for (size_t lane = 0; lane < NUM_LANES; lane++) {
+            if (j < lanes.seq_lens[lane]) {
+                masks[lane] = lanes.masks[lane];
+                seqs[lane] = reinterpret_cast<const uint8_t*>(lanes.seqs[lane]);
+                segment_end = std::min(segment_end, size_t(lanes.seq_lens[lane]));
+            } else {
+                masks[lane] = &no_matches;
+                seqs[lane] = reinterpret_cast<const uint8_t*>(lanes.seqs[longest_lane]);
+            }
+        }
+        // Lanes past the end of their sequence keep stepping, but their scores are ignored.
+        const __m256i in_seq = _mm256_cmpgt_epi64(seq_lens, _mm256_set1_epi64x(int64_t(j)));
+
+        for (; j < segment_end; j++) {
+            // The same step as myers_step(), for every lane at once.
+            const __m256i EQ = _mm256_set_epi64x(
+                    int64_t((*masks[3])[seqs[3][j]]), int64_t((*masks[2])[seqs[2][j]]),
+                    int64_t((*masks[1])[seqs[1][j]]), int64_t((*masks[0])[seqs[0][j]]));
+            const __m256i D0 = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_xor_si256(
+                                            _mm256_add_epi64(_mm256_and_si256(EQ, VP), VP), VP),
+                                    EQ),
+                    VN);
+            __m256i HP =
+                    _mm256_or_si256(VN, _mm256_andnot_si256(_mm256_or_si256(D0, VP), all_ones));
+            __m256i HN = _mm256_and_si256(D0, VP);
+
+            // The comparisons are -1 in the lanes where the last row's bit is set. They cancel out
+            // in unused lanes, which have no last row.
+            score = _mm256_sub_epi64(
+                    score, _mm256_cmpeq_epi64(_mm256_and_si256(HP, last_bit), last_bit));
+            score = _mm256_add_epi64(
+                    score, _mm256_cmpeq_epi64(_mm256_and_si256(HN, last_bit), last_bit));
+
+            const __m256i improved = _mm256_and_si256(in_seq, _mm256_cmpgt_epi64(best, score));
+            best = _mm256_blendv_epi8(best, score, improved);
+            if (columns) {
+                _mm256_storeu_si256(
+                        reinterpret_cast<__m256i*>(&block_scores[(j - block_start) * NUM_LANES]),
+                        score);
+                if (j + 1 - block_start == BLOCK_SIZE) {
+                    copy_out_block(j + 1);
+                }
+            }
+
+            HP = _mm256_slli_epi64(HP, 1);
+            HN = _mm256_slli_epi64(HN, 1);
+            VP = _mm256_or_si256(HN, _mm256_andnot_si256(_mm256_or_si256(D0, HP), all_ones));
+            VN = _mm256_and_si256(D0, HP);
+        }
+        if (columns) {
+            copy_out_block(j);
+        }
+    }
+
+    std::array<uint64_t, NUM_LANES> best_scores;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(best_scores.data()), best);
+    std::array<size_t, NUM_LANES> result;
+    std::copy(best_scores.begin(), best_scores.end(), result.begin());
+    return result;
+}
+#endif
+
+// Returns the matches of |query| in |seq| with edist <= |max_edist|, given the d_myers() column
+// |local_edists| of the two.
+std::vector<EdistResult> find_matches(std::string_view query,
+                                      std::string_view seq,
+                                      const std::vector<size_t>& local_edists,
+                                      std::size_t max_edist) {
     std::vector<EdistResult> ranges;
     const auto query_len = query.size();
-    if (seq.size() < query_len) {
-        // Too small, don't bother.
-        return ranges;
-    }
 
     auto add_match = [&](std::size_t end, std::size_t edist) {
         // |edist| is for the full query ending at |end|, so we know the earliest that the match can start.
@@ -104,9 +284,6 @@ std::vector<EdistResult> myers_align(std::string_view query,
         }
     };
 
-    // Calculate edit distances for each index.
-    const auto local_edists = d_myers(query.data(), query.size(), seq.data(), seq.size());
-
     // Look for drops below the threshold and join neighbouring ranges together.
     //
     // TODO: can we improve on this, since we have cases such as:
@@ -147,6 +324,111 @@ std::vector<EdistResult> myers_align(std::string_view query,
     return ranges;
 }
 
+}  // namespace
+
+std::vector<EdistResult> myers_align(std::string_view query,
+                                     std::string_view seq,
+                                     std::size_t max_edist) {
+    if (seq.size() < query.size()) {
+        // Too small, don't bother.
+        return {};
+    }
+
+    // Calculate edit distances for each index.
+    const auto local_edists = d_myers(query.data(), query.size(), seq.data(), seq.size());
+    return find_matches(query, seq, local_edists, max_edist);
+}
+
+std::vector<std::vector<EdistResult>> myers_align_multi(
+        const std::vector<std::string_view>& queries,
+        std::string_view seq,
+        std::size_t max_edist) {
+    std::vector<std::vector<EdistResult>> results(queries.size());
+
+    // As in myers_align(), queries that are longer than the sequence aren't searched.
+    std::vector<std::size_t> to_search;
+    for (std::size_t i = 0; i < queries.size(); i++) {
+        if (!queries[i].empty() && queries[i].size() <= seq.size()) {
+            to_search.push_back(i);
+        }
+    }
+
+    // Scan the sequence once for each group of NUM_LANES queries.
+    std::array<PatternMasks, NUM_LANES> masks;
+    LaneColumns local_edists;
+    for (std::size_t first = 0; first < to_search.size(); first += NUM_LANES) {
+        const auto num_in_group = std::min(NUM_LANES, to_search.size() - first);
+        Lanes lanes;
+        for (std::size_t lane = 0; lane < num_in_group; lane++) {
+            const auto query = queries[to_search[first + lane]];
+            masks[lane] = pattern_masks(query.data(), query.size());
+            lanes.masks[lane] = &masks[lane];
+            lanes.query_lens[lane] = query.size();
+            lanes.seqs[lane] = seq.data();
+            lanes.seq_lens[lane] = seq.size();
+        }
+        myers_lanes(lanes, &local_edists);
+        for (std::size_t lane = 0; lane < num_in_group; lane++) {
+            const auto i = to_search[first + lane];
+            results[i] = find_matches(queries[i], seq, local_edists[lane], max_edist);
+        }
+    }
+    return results;
+}
+
+std::vector<std::size_t> myers_best_edists(std::string_view query,
+                                           const std::vector<std::string_view>& seqs) {
+    const auto query_len = query.size();
+    std::vector<std::size_t> best_edists(seqs.size(), query_len);
+    if (query_len == 0) {
+        return best_edists;
+    }
+
+    if (query_len > MAX_QUERY_LEN) {
+        // Too long for a single word, so hand over to edlib.
+        for (size_t i = 0; i < seqs.size(); i++) {
+            if (seqs[i].empty()) {
+                continue;
+            }
+            auto edlib_cfg =
+                    edlibNewAlignConfig(-1, EDLIB_MODE_HW, EDLIB_TASK_DISTANCE, nullptr, 0);
+            auto edlib_result = edlibAlign(query.data(), static_cast<int>(query_len),
+                                           seqs[i].data(), static_cast<int>(seqs[i].size()),
+                                           edlib_cfg);
+            assert(edlib_result.status == EDLIB_STATUS_OK);
+            auto edlib_cleanup = utils::PostCondition([&] { edlibFreeAlignResult(edlib_result); });
+            if (edlib_result.status == EDLIB_STATUS_OK) {
+                best_edists[i] = static_cast<std::size_t>(edlib_result.editDistance);
+            }
+        }
+        return best_edists;
+    }
+
+    // Sequences of similar lengths share a scan, so fewer lanes sit idle once theirs ends.
+    std::vector<std::size_t> order(seqs.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return seqs[lhs].size() > seqs[rhs].size();
+    });
+
+    const auto PM = pattern_masks(query.data(), query_len);
+    for (std::size_t first = 0; first < order.size(); first += NUM_LANES) {
+        const auto num_in_group = std::min(NUM_LANES, order.size() - first);
+        Lanes lanes;
+        for (std::size_t lane = 0; lane < num_in_group; lane++) {
+            lanes.masks[lane] = &PM;
+            lanes.query_lens[lane] = query_len;
+            lanes.seqs[lane] = seqs[order[first + lane]].data();
+            lanes.seq_lens[lane] = seqs[order[first + lane]].size();
+        }
+        const auto lane_best_edists = myers_lanes(lanes, nullptr);
+        for (std::size_t lane = 0; lane < num_in_group; lane++) {
+            best_edists[order[first + lane]] = lane_best_edists[lane];
+        }
+    }
+    return best_edists;
+}
+
 void print_edists(std::ostream& os, std::string_view seq, const std::vector<size_t>& edists) {
     assert(edists.size() == seq.size() + 1);
 
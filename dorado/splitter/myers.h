@@ -15,6 +15,20 @@ std::vector<EdistResult> myers_align(std::string_view query,
                                      std::string_view seq,
                                      std::size_t max_edist);
 
+// Runs myers_align() for each of |queries|, returning the matches of queries[i] in element i.
+// Several queries are scanned through |seq| at once, so this is faster than aligning them one at a
+// time. Empty queries have no matches.
+std::vector<std::vector<EdistResult>> myers_align_multi(
+        const std::vector<std::string_view>& queries,
+        std::string_view seq,
+        std::size_t max_edist);
+
+// Returns, for each of |seqs|, the edit distance of the best match of the whole of |query| to any
+// part of it. Sequences are scanned up to four at a time, one in each lane of an AVX2 register where
+// it's available, with the same Myers step as myers_align().
+std::vector<std::size_t> myers_best_edists(std::string_view query,
+                                           const std::vector<std::string_view>& seqs);
+
 void print_edists(std::ostream& os, std::string_view seq, const std::vector<size_t>& edists);
 
 }  // namespace dorado::splitter
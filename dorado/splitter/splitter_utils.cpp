@@ -2,6 +2,7 @@
 
 #include "read_pipeline/ReadPipeline.h"
 #include "read_pipeline/read_utils.h"
+#include "utils/simd.h"
 #include "utils/time_utils.h"
 
 #include <ATen/TensorIndexing.h>
@@ -23,6 +24,57 @@ __attribute__((optimize("O0")))
         subread->read_common.parent_read_id = read.read_common.read_id;
     }
 }
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+uint64_t first_sample_above(const float* signal, uint64_t begin, uint64_t end, float threshold) {
+    // Check a block at a time without branching on each sample, which compilers can vectorise.
+    constexpr uint64_t kBlockSize = 16;
+    auto i = begin;
+    for (; i + kBlockSize <= end; i += kBlockSize) {
+        bool any_above = false;
+        for (uint64_t j = 0; j < kBlockSize; j++) {
+            any_above |= signal[i + j] > threshold;
+        }
+        if (any_above) {
+            break;
+        }
+    }
+    for (; i < end; i++) {
+        if (signal[i] > threshold) {
+            return i;
+        }
+    }
+    return end;
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2"))) uint64_t first_sample_above(const float* signal,
+                                                            uint64_t begin,
+                                                            uint64_t end,
+                                                            float threshold) {
+    const __m256 thresholds = _mm256_set1_ps(threshold);
+    auto i = begin;
+    for (; i + 16 <= end; i += 16) {
+        const __m256 above_low = _mm256_cmp_ps(_mm256_loadu_ps(signal + i), thresholds, _CMP_GT_OQ);
+        const __m256 above_high =
+                _mm256_cmp_ps(_mm256_loadu_ps(signal + i + 8), thresholds, _CMP_GT_OQ);
+        const uint32_t mask = uint32_t(_mm256_movemask_ps(above_low)) |
+                              (uint32_t(_mm256_movemask_ps(above_high)) << 8);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; i < end; i++) {
+        if (signal[i] > threshold) {
+            return i;
+        }
+    }
+    return end;
+}
+#endif
+
 }  // namespace
 
 SimplexReadPtr subread(const SimplexRead& read,
@@ -31,7 +83,8 @@ SimplexReadPtr subread(const SimplexRead& read,
     //TODO support mods
     //NB: currently doesn't support mods
     //assert(read.mod_base_info == nullptr && read.base_mod_probs.empty());
-    if (read.read_common.mod_base_info != nullptr || !read.read_common.base_mod_probs.empty()) {
+    if (read.read_common.mod_base_info != nullptr || !read.read_common.base_mod_probs.empty() ||
+        !read.read_common.sparse_base_mod_probs.empty()) {
         throw std::runtime_error(std::string("Read splitting doesn't support mods yet"));
     }
 
@@ -87,6 +140,10 @@ SimplexReadPtr subread(const SimplexRead& read,
     return subread;
 }
 
+uint64_t find_sample_above(const float* signal, uint64_t begin, uint64_t end, float threshold) {
+    return first_sample_above(signal, begin, end, threshold);
+}
+
 PosRanges merge_ranges(const PosRanges& ranges, uint64_t merge_dist) {
     PosRanges merged;
     for (auto& r : ranges) {
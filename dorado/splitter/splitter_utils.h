@@ -48,45 +48,68 @@ struct SampleRange {
 template <typename T>
 using SampleRanges = std::vector<SampleRange<T>>;
 
+// Returns the index of the first sample of signal[begin, end) above threshold, or end if none are.
 template <typename T>
-SampleRanges<T> detect_pore_signal(const at::Tensor& signal,
+uint64_t find_sample_above(const T* signal, uint64_t begin, uint64_t end, T threshold) {
+    for (auto i = begin; i < end; i++) {
+        if (signal[i] > threshold) {
+            return i;
+        }
+    }
+    return end;
+}
+
+// Vectorised for float signal, where almost every sample is below the threshold.
+uint64_t find_sample_above(const float* signal, uint64_t begin, uint64_t end, float threshold);
+
+template <typename T>
+SampleRanges<T> detect_pore_signal(const T* signal,
+                                   uint64_t num_samples,
                                    T threshold,
                                    uint64_t cluster_dist,
                                    uint64_t ignore_prefix) {
     SampleRanges<T> ans;
-    auto pore_a = signal.accessor<T, 1>();
     int64_t cl_start = -1;
     int64_t cl_end = -1;
 
     T cl_max = std::numeric_limits<T>::min();
     int64_t cl_argmax = -1;
-    for (auto i = ignore_prefix; i < uint64_t(pore_a.size(0)); i++) {
-        if (pore_a[i] > threshold) {
-            //check if we need to start new cluster
-            if (cl_end == -1 || i > cl_end + cluster_dist) {
-                //report previous cluster
-                if (cl_end != -1) {
-                    assert(cl_start != -1);
-                    ans.push_back(SampleRange(cl_start, cl_end, cl_argmax, cl_max));
-                }
-                cl_start = i;
-                cl_max = std::numeric_limits<T>::min();
-            }
-            if (pore_a[i] >= cl_max) {
-                cl_max = pore_a[i];
-                cl_argmax = i;
+    for (auto i = find_sample_above(signal, ignore_prefix, num_samples, threshold);
+         i < num_samples; i = find_sample_above(signal, i + 1, num_samples, threshold)) {
+        //check if we need to start new cluster
+        if (cl_end == -1 || i > cl_end + cluster_dist) {
+            //report previous cluster
+            if (cl_end != -1) {
+                assert(cl_start != -1);
+                ans.push_back(SampleRange(cl_start, cl_end, cl_argmax, cl_max));
             }
-            cl_end = i + 1;
+            cl_start = i;
+            cl_max = std::numeric_limits<T>::min();
         }
+        if (signal[i] >= cl_max) {
+            cl_max = signal[i];
+            cl_argmax = i;
+        }
+        cl_end = i + 1;
     }
     //report last cluster
     if (cl_end != -1) {
         assert(cl_start != -1);
-        assert(cl_start < pore_a.size(0) && cl_end <= pore_a.size(0));
+        assert(uint64_t(cl_start) < num_samples && uint64_t(cl_end) <= num_samples);
         ans.push_back(SampleRange(cl_start, cl_end, cl_argmax, cl_max));
     }
 
     return ans;
 }
 
+template <typename T>
+SampleRanges<T> detect_pore_signal(const at::Tensor& signal,
+                                   T threshold,
+                                   uint64_t cluster_dist,
+                                   uint64_t ignore_prefix) {
+    const auto contiguous_signal = signal.contiguous();
+    return detect_pore_signal(contiguous_signal.data_ptr<T>(), uint64_t(contiguous_signal.size(0)),
+                              threshold, cluster_dist, ignore_prefix);
+}
+
 }  // namespace dorado::splitter
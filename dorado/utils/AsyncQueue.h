@@ -4,19 +4,65 @@
 #include <atomic>
 #include <cassert>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace dorado::utils {
 
 // Status return by push/pop methods.
 enum class AsyncQueueStatus { Success, Timeout, Terminate };
 
-// Asynchronous queue for producer/consumer use.
-// Items must be movable.
+// Item storage for AsyncQueue which orders items by a deadline, counted in pushes: an item's
+// deadline is its push sequence number plus delay_of(item).  The item with the earliest deadline
+// is at the front, and of items with equal deadlines, the oldest.  Since later items have later
+// sequence numbers, an item is always popped before any item pushed more than delay_of(item)
+// pushes after it, so delays reorder items but can't starve any of them.  With no delay_of, items
+// come out oldest first.  Pushes and pops are O(log n).
 template <class Item>
+class DeadlineOrderedItems {
+public:
+    using DelayFn = std::function<uint64_t(const Item&)>;
+
+    explicit DeadlineOrderedItems(DelayFn delay_of = {}) : m_delay_of(std::move(delay_of)) {}
+
+    void push_back(Item&& item) {
+        const uint64_t delay = m_delay_of ? m_delay_of(item) : 0;
+        m_entries.push_back({{m_next_seq + delay, m_next_seq}, std::move(item)});
+        ++m_next_seq;
+        std::push_heap(m_entries.begin(), m_entries.end(), later);
+    }
+    // Only the key is compared when the heap is rearranged, so the front item can be moved from
+    // before pop_front is called.
+    Item& front() { return m_entries.front().item; }
+    void pop_front() {
+        std::pop_heap(m_entries.begin(), m_entries.end(), later);
+        m_entries.pop_back();
+    }
+    bool empty() const { return m_entries.empty(); }
+    size_t size() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        std::pair<uint64_t, uint64_t> key;  // Deadline, then push sequence number.
+        Item item;
+    };
+    static bool later(const Entry& a, const Entry& b) { return a.key > b.key; }
+
+    DelayFn m_delay_of;
+    std::vector<Entry> m_entries;  // Min-heap on key.
+    uint64_t m_next_seq = 0;
+};
+
+// Asynchronous queue for producer/consumer use.
+// Items must be movable.  Items are stored in an Items container, which provides push_back, front,
+// pop_front, empty and size, and which decides the order they are popped in.
+template <class Item, class Items = std::deque<Item>>
 class AsyncQueue {
     // Guards the entire structure.  Should be held while adding/removing items,
     // or interacting with m_terminate.
@@ -27,8 +73,8 @@ class AsyncQueue {
     mutable std::condition_variable m_not_full_cv;
     // Signalled when an item has been added, and the queue therefore is not empty.
     std::condition_variable m_not_empty_cv;
-    // Holds the items.
-    std::queue<Item> m_items;
+    // Holds the items, next to be popped first.
+    Items m_items;
     // Number of items that can be added before further additions block, pending
     // consumption of items.
     size_t m_capacity = 0;
@@ -46,7 +92,7 @@ class AsyncQueue {
         assert(lock.owns_lock());
         assert(!m_items.empty());
         item = std::move(m_items.front());
-        m_items.pop();
+        m_items.pop_front();
         ++m_num_pops;
 
         // Inform a waiting thread that the queue is not full.
@@ -65,7 +111,7 @@ class AsyncQueue {
         size_t num_to_pop = std::min(m_items.size(), max_count);
         for (size_t i = 0; i < num_to_pop; ++i) {
             process_fn(std::move(m_items.front()));
-            m_items.pop();
+            m_items.pop_front();
         }
         m_num_pops += num_to_pop;
 
@@ -96,7 +142,8 @@ class AsyncQueue {
 
 public:
     // Attempts to push items beyond capacity will block.
-    explicit AsyncQueue(size_t capacity) : m_capacity(capacity) {}
+    explicit AsyncQueue(size_t capacity, Items items = Items())
+            : m_items(std::move(items)), m_capacity(capacity) {}
 
     ~AsyncQueue() {
         // Ensure CV waits terminate before destruction.
@@ -128,7 +175,7 @@ public:
             return AsyncQueueStatus::Terminate;
         }
 
-        m_items.push(std::move(item));
+        m_items.push_back(std::move(item));
         ++m_num_pushes;
 
         // Inform a waiting thread that there is now an item available.
@@ -0,0 +1,228 @@
+#include "duplex_pair_list.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+namespace {
+
+constexpr size_t kUuidLength = 36;
+// Below this much of the file per thread, starting another thread costs more than it saves.
+constexpr size_t kMinBytesPerThread = size_t{1} << 20;
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// Orders pair list entries by read, and then with the complement role before the template role.
+constexpr auto kByReadAndRole = [](const auto& lhs, const auto& rhs) {
+    return std::tie(lhs.read, lhs.read_is_template) < std::tie(rhs.read, rhs.read_is_template);
+};
+
+bool is_dash_position(size_t pos) { return pos == 8 || pos == 13 || pos == 18 || pos == 23; }
+
+// Parses a lower case UUID. Upper case isn't accepted, so a key always converts back to the id
+// it was parsed from.
+bool parse_uuid(std::string_view read_id, std::array<uint8_t, 16>& key) {
+    if (read_id.size() != kUuidLength) {
+        return false;
+    }
+    size_t byte_idx = 0;
+    for (size_t pos = 0; pos < kUuidLength;) {
+        if (is_dash_position(pos)) {
+            if (read_id[pos] != '-') {
+                return false;
+            }
+            ++pos;
+            continue;
+        }
+        const int high = hex_value(read_id[pos]);
+        const int low = hex_value(read_id[pos + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        key[byte_idx++] = uint8_t((high << 4) | low);
+        pos += 2;
+    }
+    return true;
+}
+
+std::string uuid_to_string(const std::array<uint8_t, 16>& key) {
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    std::string read_id(kUuidLength, '-');
+    size_t byte_idx = 0;
+    for (size_t pos = 0; pos < kUuidLength;) {
+        if (is_dash_position(pos)) {
+            ++pos;
+            continue;
+        }
+        read_id[pos] = kHexDigits[key[byte_idx] >> 4];
+        read_id[pos + 1] = kHexDigits[key[byte_idx] & 0xf];
+        ++byte_idx;
+        pos += 2;
+    }
+    return read_id;
+}
+
+}  // namespace
+
+namespace dorado::utils {
+
+void DuplexPairList::ParsedPairs::add(std::string_view template_id,
+                                      std::string_view complement_id) {
+    Entry template_entry{};
+    Entry complement_entry{};
+    if (parse_uuid(template_id, template_entry.read) &&
+        parse_uuid(complement_id, complement_entry.read)) {
+        template_entry.partner = complement_entry.read;
+        template_entry.read_is_template = true;
+        complement_entry.partner = template_entry.read;
+        complement_entry.read_is_template = false;
+        entries.push_back(template_entry);
+        entries.push_back(complement_entry);
+        return;
+    }
+
+    // Keep the same precedence as the sorted entries: the template role over the complement role,
+    // and later pairs over earlier ones.
+    auto& complement_partner = other_reads[std::string(complement_id)];
+    if (complement_partner.read_id.empty() || !complement_partner.read_is_template) {
+        complement_partner = Partner{std::string(template_id), false};
+    }
+    other_reads[std::string(template_id)] = Partner{std::string(complement_id), true};
+}
+
+DuplexPairList::ParsedPairs DuplexPairList::parse(std::string_view text) {
+    ParsedPairs parsed;
+    while (!text.empty()) {
+        const auto line_end = text.find('\n');
+        auto line = text.substr(0, line_end);
+        text = line_end == std::string_view::npos ? std::string_view{} : text.substr(line_end + 1);
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        const auto delim_pos = line.find(' ');
+        if (delim_pos == std::string_view::npos) {
+            continue;
+        }
+        parsed.add(line.substr(0, delim_pos), line.substr(delim_pos + 1));
+    }
+
+    std::stable_sort(parsed.entries.begin(), parsed.entries.end(), kByReadAndRole);
+    return parsed;
+}
+
+void DuplexPairList::merge(std::vector<ParsedPairs>& parsed) {
+    m_entries.clear();
+    m_other_reads.clear();
+    for (auto& run : parsed) {
+        // Merging is stable, so entries for the same read and role stay in the order listed.
+        const auto run_start = std::ptrdiff_t(m_entries.size());
+        m_entries.insert(m_entries.end(), run.entries.begin(), run.entries.end());
+        std::inplace_merge(m_entries.begin(), m_entries.begin() + run_start, m_entries.end(),
+                           kByReadAndRole);
+        run.entries = {};
+
+        for (auto& [read_id, partner] : run.other_reads) {
+            auto it = m_other_reads.find(read_id);
+            if (it == m_other_reads.end() || partner.read_is_template ||
+                !it->second.read_is_template) {
+                m_other_reads[read_id] = std::move(partner);
+            }
+        }
+        run.other_reads = {};
+    }
+
+    // The last entry for each read has the role and pair which take precedence.
+    auto out = m_entries.begin();
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        const auto next = std::next(it);
+        if (next == m_entries.end() || next->read != it->read) {
+            *out++ = *it;
+        }
+    }
+    m_entries.erase(out, m_entries.end());
+    m_entries.shrink_to_fit();
+}
+
+DuplexPairList::DuplexPairList(const std::map<std::string, std::string>& template_complement_map) {
+    std::vector<ParsedPairs> parsed(1);
+    for (const auto& [template_id, complement_id] : template_complement_map) {
+        parsed[0].add(template_id, complement_id);
+    }
+    std::stable_sort(parsed[0].entries.begin(), parsed[0].entries.end(), kByReadAndRole);
+    merge(parsed);
+}
+
+DuplexPairList DuplexPairList::load(const std::string& pairs_file_path, size_t num_threads) {
+    std::ifstream pairs_file(pairs_file_path, std::ios::binary | std::ios::ate);
+    if (!pairs_file.is_open()) {
+        throw std::runtime_error("Pairs file does not exist.");
+    }
+    std::string contents(size_t(pairs_file.tellg()), '\0');
+    pairs_file.seekg(0);
+    pairs_file.read(contents.data(), std::streamsize(contents.size()));
+
+    // Split the file into one run of whole lines per thread.
+    num_threads = std::clamp<size_t>(contents.size() / kMinBytesPerThread, 1,
+                                     std::max<size_t>(num_threads, 1));
+    const std::string_view text = contents;
+    std::vector<std::string_view> runs;
+    size_t run_start = 0;
+    for (size_t i = 1; i <= num_threads && run_start < text.size(); ++i) {
+        size_t run_end = i == num_threads ? text.size() : text.size() * i / num_threads;
+        run_end = std::max(run_end, run_start);
+        const auto line_end = text.find('\n', run_end);
+        run_end = line_end == std::string_view::npos ? text.size() : line_end + 1;
+        runs.push_back(text.substr(run_start, run_end - run_start));
+        run_start = run_end;
+    }
+
+    std::vector<ParsedPairs> parsed(runs.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < runs.size(); ++i) {
+        threads.emplace_back([&parsed, &runs, i] { parsed[i] = parse(runs[i]); });
+    }
+    if (!runs.empty()) {
+        parsed[0] = parse(runs[0]);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    DuplexPairList pair_list;
+    pair_list.merge(parsed);
+    return pair_list;
+}
+
+std::optional<DuplexPairList::Partner> DuplexPairList::find_partner(
+        std::string_view read_id) const {
+    ReadKey key;
+    if (parse_uuid(read_id, key)) {
+        const auto it = std::lower_bound(
+                m_entries.begin(), m_entries.end(), key,
+                [](const Entry& entry, const ReadKey& read) { return entry.read < read; });
+        if (it != m_entries.end() && it->read == key) {
+            return Partner{uuid_to_string(it->partner), it->read_is_template};
+        }
+    }
+    if (!m_other_reads.empty()) {
+        const auto it = m_other_reads.find(std::string(read_id));
+        if (it != m_other_reads.end()) {
+            return it->second;
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace dorado::utils
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dorado::utils {
+
+// The template/complement read pairs listed in a pairs file, held compactly so that lists of tens
+// of millions of pairs load quickly and fit in memory. Read ids which are lower case UUIDs, as all
+// dorado read ids are, are stored as their 16 bytes in a sorted array, and any pairs with other
+// read ids are kept as strings. The list never changes once built, so lookups need no locking.
+class DuplexPairList {
+public:
+    struct Partner {
+        std::string read_id;
+        // Whether the read that was looked up is the template of the pair.
+        bool read_is_template = false;
+    };
+
+    DuplexPairList() = default;
+
+    // Builds the list from a map of template_id to complement_id.
+    explicit DuplexPairList(const std::map<std::string, std::string>& template_complement_map);
+
+    // Loads a space-delimited pairs file in `template_id complement_id` format, parsing it on up
+    // to num_threads threads. Throws if the file can't be opened.
+    static DuplexPairList load(const std::string& pairs_file_path, size_t num_threads);
+
+    // Returns the other read of the pair read_id is in, or nullopt if it isn't in any. A read
+    // which is the template of one pair and the complement of another is paired as the template,
+    // and a read listed more than once in the same role is paired as it was last listed.
+    std::optional<Partner> find_partner(std::string_view read_id) const;
+
+    // Number of distinct reads in the pairs.
+    size_t num_reads() const { return m_entries.size() + m_other_reads.size(); }
+    bool empty() const { return num_reads() == 0; }
+
+private:
+    using ReadKey = std::array<uint8_t, 16>;
+
+    // One for each read of a pair, sorted by read.
+    struct Entry {
+        ReadKey read;
+        ReadKey partner;
+        bool read_is_template;
+    };
+
+    // The pairs of a run of lines, with entries sorted by read and then role, with ties in the
+    // order they were listed.
+    struct ParsedPairs {
+        std::vector<Entry> entries;
+        std::unordered_map<std::string, Partner> other_reads;
+
+        void add(std::string_view template_id, std::string_view complement_id);
+    };
+
+    static ParsedPairs parse(std::string_view text);
+    // Sets the list from parsed runs of lines, given in the order the lines were listed.
+    void merge(std::vector<ParsedPairs>& parsed);
+
+    std::vector<Entry> m_entries;
+    std::unordered_map<std::string, Partner> m_other_reads;
+};
+
+}  // namespace dorado::utils
@@ -1,49 +1,145 @@
 #include "duplex_utils.h"
 
+#include "simd.h"
+
 #include <ATen/Functions.h>
 #include <ATen/TensorIndexing.h>
 #include <ATen/TensorOperators.h>
+#include <edlib.h>
 
 #include <algorithm>
-#include <fstream>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <tuple>
 #include <vector>
 
-namespace dorado::utils {
-std::map<std::string, std::string> load_pairs_file(const std::string& pairs_file_path) {
-    std::ifstream dataFile;
-    dataFile.open(pairs_file_path);
+namespace {
 
-    std::map<std::string, std::string> template_complement_map;
+// Score of cells outside the band, low enough that adding to it can't overflow.
+constexpr int32_t kOutsideBand = std::numeric_limits<int32_t>::max() / 2;
 
-    if (!dataFile.is_open()) {
-        throw std::runtime_error("Pairs file does not exist.");
-    }
-    std::string cell;
+// Which neighbour a cell's score came from.
+constexpr uint8_t kFromDiagonal = 0;
+constexpr uint8_t kFromAbove = 1;
+constexpr uint8_t kFromLeft = 2;
 
-    std::getline(dataFile, cell);
-    while (!dataFile.eof()) {
-        char delim = ' ';
-        auto delim_pos = cell.find(delim);
+// Edlib doesn't provide named constants for alignment array entries, so do it here.
+constexpr unsigned char kAlignMatch = 0;
+constexpr unsigned char kAlignInsertionToTarget = 1;
+constexpr unsigned char kAlignInsertionToQuery = 2;
+constexpr unsigned char kAlignMismatch = 3;
 
-        std::string t = cell.substr(0, delim_pos);
-        std::string c = cell.substr(delim_pos + 1, delim_pos * 2 - 1);
-        template_complement_map[t] = c;
+// The band of global_alignment, which widens slowly with read length to allow for the drift of
+// indels along the alignment.
+constexpr int kMinBandHalfWidth = 64;
+constexpr size_t kBandHalfWidthLengthDivisor = 256;
+// Past this many cells the band's traceback takes more memory than edlib.
+constexpr size_t kMaxBandCells = size_t{1} << 26;
+// How banded_global_alignment spots an alignment the band has forced out of step without it
+// reaching the band's edge, as happens when the reads are offset by more than the band. Bases out
+// of step only match by chance, so such a stretch is mostly mismatches, whereas the reads of a
+// duplex pair each have an error rate of a few percent, so a window of 64 operations of their true
+// alignment has a handful of mismatches at most. A window with more than a quarter of its
+// operations mismatched is well clear of both, and the alignment is left to edlib instead.
+constexpr size_t kMismatchWindow = 64;
+constexpr int kMaxBandedWindowMismatches = int(kMismatchWindow / 4);
+
+// Scores one cell of an anti-diagonal of the DP matrix, from the cell diagonally before it on the
+// anti-diagonal two back, and the cells above and to the left of it on the previous anti-diagonal.
+// Ties favour the diagonal, then the cell above.
+inline void fill_cell(const int32_t* diagonal,
+                      const int32_t* previous,
+                      const char* query_bases,
+                      const char* target_bases,
+                      int32_t* scores,
+                      uint8_t* directions,
+                      size_t x) {
+    const int32_t diagonal_score = diagonal[x] + (query_bases[x] != target_bases[x] ? 1 : 0);
+    const int32_t above_score = previous[x] + 1;
+    const int32_t left_score = previous[x + 1] + 1;
+    const int32_t best_score = std::min(diagonal_score, above_score);
+    scores[x] = std::min(best_score, left_score);
+    directions[x] = left_score < best_score        ? kFromLeft
+                    : above_score < diagonal_score ? kFromAbove
+                                                   : kFromDiagonal;
+}
 
-        std::getline(dataFile, cell);
+// Scores count consecutive cells of an anti-diagonal, where diagonal[x] and previous[x] are the
+// diagonal neighbour and the neighbour above of cell x, previous[x + 1] is its neighbour to the
+// left, and query_bases[x] and target_bases[x] are the bases it compares.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void fill_antidiagonal(const int32_t* diagonal,
+                       const int32_t* previous,
+                       const char* query_bases,
+                       const char* target_bases,
+                       int32_t* scores,
+                       uint8_t* directions,
+                       size_t count) {
+    for (size_t x = 0; x < count; ++x) {
+        fill_cell(diagonal, previous, query_bases, target_bases, scores, directions, x);
     }
-    return template_complement_map;
 }
 
-std::unordered_set<std::string> get_read_list_from_pairs(
-        const std::map<std::string, std::string>& template_complement_map) {
-    std::unordered_set<std::string> read_list;
-    for (const auto& x : template_complement_map) {
-        read_list.insert(x.first);
-        read_list.insert(x.second);
+#if ENABLE_AVX2_IMPL
+// AVX2 implementation which scores 8 cells at once. Cells of an anti-diagonal don't depend on
+// each other, unlike cells of a row or column, so there's nothing to carry between lanes.
+__attribute__((target("avx2"))) void fill_antidiagonal(const int32_t* diagonal,
+                                                       const int32_t* previous,
+                                                       const char* query_bases,
+                                                       const char* target_bases,
+                                                       int32_t* scores,
+                                                       uint8_t* directions,
+                                                       size_t count) {
+    const __m256i kOnes = _mm256_set1_epi32(1);
+    const __m256i kFromLeftLanes = _mm256_set1_epi32(kFromLeft);
+
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        const __m128i query_chunk =
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(query_bases + x));
+        const __m128i target_chunk =
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(target_bases + x));
+        // All ones where the bases match, so adding one gives the mismatch cost.
+        const __m256i matches = _mm256_cvtepi8_epi32(_mm_cmpeq_epi8(query_chunk, target_chunk));
+        const __m256i diagonal_scores =
+                _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(diagonal + x)),
+                                 _mm256_add_epi32(matches, kOnes));
+        const __m256i above_scores = _mm256_add_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous + x)), kOnes);
+        const __m256i left_scores = _mm256_add_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previous + x + 1)), kOnes);
+
+        // Only a strictly better score displaces the diagonal, and then the cell above.
+        const __m256i from_above = _mm256_cmpgt_epi32(diagonal_scores, above_scores);
+        __m256i best = _mm256_min_epi32(diagonal_scores, above_scores);
+        const __m256i from_left = _mm256_cmpgt_epi32(best, left_scores);
+        best = _mm256_min_epi32(best, left_scores);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(scores + x), best);
+
+        // kFromAbove is 1, so masking it with ones gives its direction.
+        const __m256i direction_lanes = _mm256_blendv_epi8(_mm256_and_si256(from_above, kOnes),
+                                                           kFromLeftLanes, from_left);
+        // Narrow to bytes, which leaves lanes 0-3 in bytes 0-3 and lanes 4-7 in bytes 16-19.
+        const __m256i direction_words = _mm256_packs_epi32(direction_lanes, direction_lanes);
+        const __m256i narrowed = _mm256_packs_epi16(direction_words, direction_words);
+        const uint32_t low_directions = uint32_t(_mm256_extract_epi32(narrowed, 0));
+        const uint32_t high_directions = uint32_t(_mm256_extract_epi32(narrowed, 4));
+        std::memcpy(directions + x, &low_directions, sizeof(low_directions));
+        std::memcpy(directions + x + 4, &high_directions, sizeof(high_directions));
+    }
+    for (; x < count; ++x) {
+        fill_cell(diagonal, previous, query_bases, target_bases, scores, directions, x);
     }
-    return read_list;
 }
+#endif
+
+}  // namespace
 
+namespace dorado::utils {
 std::pair<std::pair<int, int>, std::pair<int, int>> get_trimmed_alignment(
         int num_consecutive_wanted,
         unsigned char* alignment,
@@ -105,6 +201,148 @@ std::pair<std::pair<int, int>, std::pair<int, int>> get_trimmed_alignment(
     return std::make_pair(alignment_start_end, query_target_cursors);
 }
 
+std::optional<GlobalAlignment> banded_global_alignment(std::string_view query,
+                                                       std::string_view target,
+                                                       int band_half_width) {
+    const int query_len = int(query.size());
+    const int target_len = int(target.size());
+    const int num_antidiagonals = query_len + target_len + 1;
+
+    // Diagonals are numbered by target position less query position, so the alignment runs from
+    // diagonal 0 to diagonal target_len - query_len, and the band covers both with some to spare.
+    band_half_width = std::max(band_half_width, 1);
+    const int length_difference = target_len - query_len;
+    const int min_diagonal = std::min(0, length_difference) - band_half_width;
+    const int max_diagonal = std::max(0, length_difference) + band_half_width;
+
+    // The rows of the band on each anti-diagonal, which is the cells with query position plus
+    // target position equal to its index, and where each one's traceback directions start.
+    std::vector<int> first_rows(num_antidiagonals);
+    std::vector<int> last_rows(num_antidiagonals);
+    std::vector<size_t> direction_offsets(num_antidiagonals + 1, 0);
+    for (int d = 0; d < num_antidiagonals; ++d) {
+        first_rows[d] = std::max(
+                {0, d - target_len, d > max_diagonal ? (d - max_diagonal + 1) / 2 : 0});
+        last_rows[d] = std::min({query_len, d, (d - min_diagonal) / 2});
+        if (first_rows[d] > last_rows[d]) {
+            return std::nullopt;
+        }
+        direction_offsets[d + 1] = direction_offsets[d] + size_t(last_rows[d] - first_rows[d] + 1);
+    }
+    if (direction_offsets.back() > kMaxBandCells) {
+        return std::nullopt;
+    }
+    std::vector<uint8_t> directions(direction_offsets.back());
+
+    // Sentinels before the query and after the reversed target mean the first row and column can
+    // be scored like any other cell. The target is reversed so that the bases compared along an
+    // anti-diagonal are consecutive in both.
+    std::string padded_query(1, '\0');
+    padded_query.append(query);
+    std::string reversed_target(target.rbegin(), target.rend());
+    reversed_target.push_back('\0');
+
+    // The last three anti-diagonals, indexed by row plus one so that the row before the first,
+    // which is outside the band, is always there.
+    std::array<std::vector<int32_t>, 3> scores;
+    for (auto& antidiagonal_scores : scores) {
+        antidiagonal_scores.assign(query_len + 3, kOutsideBand);
+    }
+    scores[0][1] = 0;
+
+    for (int d = 1; d < num_antidiagonals; ++d) {
+        const auto& diagonal = scores[(d + 1) % 3];
+        const auto& previous = scores[(d + 2) % 3];
+        auto& current = scores[d % 3];
+        const int first_row = first_rows[d];
+        const int last_row = last_rows[d];
+        fill_antidiagonal(diagonal.data() + first_row, previous.data() + first_row,
+                          padded_query.data() + first_row,
+                          reversed_target.data() + (target_len - d + first_row),
+                          current.data() + first_row + 1, &directions[direction_offsets[d]],
+                          size_t(last_row - first_row + 1));
+        // Cells either side of the band, which the next two anti-diagonals can read.
+        current[first_row] = kOutsideBand;
+        current[last_row + 2] = kOutsideBand;
+    }
+
+    GlobalAlignment result;
+    result.edit_distance = scores[(num_antidiagonals - 1) % 3][query_len + 1];
+    result.alignment.reserve(size_t(std::max(query_len, target_len)));
+    int row = query_len;
+    int col = target_len;
+    int window_mismatches = 0;
+    while (row > 0 || col > 0) {
+        // An alignment which runs along the edge of the band might have been cut short by it.
+        const int diagonal = col - row;
+        if (diagonal == min_diagonal || diagonal == max_diagonal) {
+            return std::nullopt;
+        }
+        const int d = row + col;
+        const auto direction = directions[direction_offsets[d] + size_t(row - first_rows[d])];
+        if (direction == kFromDiagonal) {
+            --row;
+            --col;
+            result.alignment.push_back(query[row] == target[col] ? kAlignMatch : kAlignMismatch);
+        } else if (direction == kFromAbove) {
+            --row;
+            result.alignment.push_back(kAlignInsertionToTarget);
+        } else {
+            --col;
+            result.alignment.push_back(kAlignInsertionToQuery);
+        }
+
+        // The band can also cut off an alignment without it reaching the edge, such as when the
+        // reads are offset by more than the band, which leaves the sequences out of step along
+        // the diagonal. That shows up as a run of mismatches that real reads don't have.
+        const size_t num_ops = result.alignment.size();
+        window_mismatches += result.alignment.back() == kAlignMismatch;
+        if (num_ops > kMismatchWindow) {
+            window_mismatches -= result.alignment[num_ops - kMismatchWindow - 1] == kAlignMismatch;
+        }
+        if (window_mismatches > kMaxBandedWindowMismatches) {
+            return std::nullopt;
+        }
+    }
+    std::reverse(result.alignment.begin(), result.alignment.end());
+    return result;
+}
+
+GlobalAlignment global_alignment(std::string_view query, std::string_view target) {
+    const size_t longest = std::max(query.size(), target.size());
+    const int band_half_width =
+            std::max(kMinBandHalfWidth, int(longest / kBandHalfWidthLengthDivisor));
+    if (auto banded = banded_global_alignment(query, target, band_half_width)) {
+        return std::move(*banded);
+    }
+
+    EdlibAlignConfig align_config = edlibDefaultAlignConfig();
+    align_config.task = EDLIB_TASK_PATH;
+    EdlibAlignResult edlib_result = edlibAlign(query.data(), int(query.size()), target.data(),
+                                               int(target.size()), align_config);
+    GlobalAlignment result;
+    result.edit_distance = edlib_result.editDistance;
+    if (edlib_result.alignment) {
+        result.alignment.assign(edlib_result.alignment,
+                                edlib_result.alignment + edlib_result.alignmentLength);
+    }
+    edlibFreeAlignResult(edlib_result);
+    return result;
+}
+
+TrimmedAlignment get_trimmed_alignment(int num_consecutive_wanted,
+                                       std::string_view query,
+                                       std::string_view target) {
+    TrimmedAlignment result;
+    result.alignment = global_alignment(query, target);
+    auto [alignment_start_end, cursors] = get_trimmed_alignment(
+            num_consecutive_wanted, result.alignment.alignment.data(),
+            int(result.alignment.alignment.size()), 0, 0, 0, int(target.size()) - 1);
+    std::tie(result.start_alignment_position, result.end_alignment_position) = alignment_start_end;
+    std::tie(result.query_cursor, result.target_cursor) = cursors;
+    return result;
+}
+
 // Applies a min pool filter to q scores for basespace-duplex algorithm
 void preprocess_quality_scores(std::vector<uint8_t>& quality_scores) {
     // Apply a min-pool window to the quality scores
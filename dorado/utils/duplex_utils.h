@@ -1,17 +1,14 @@
 #pragma once
 
 #include <iostream>
-#include <map>
+#include <optional>
 #include <sstream>
 #include <string>
-#include <unordered_set>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace dorado::utils {
-// Given a path to a space-delimited csv in `tempate_id complement_id` format,
-// returns a map of template_id to  complement_id
-std::map<std::string, std::string> load_pairs_file(const std::string& pairs_file);
-
 // Returns subset of alignment for which start and end start with  `num_consecutive_wanted` consecutive nucleotides.
 std::pair<std::pair<int, int>, std::pair<int, int>> get_trimmed_alignment(
         int num_consecutive_wanted,
@@ -22,10 +19,44 @@ std::pair<std::pair<int, int>, std::pair<int, int>> get_trimmed_alignment(
         int start_alignment_position,
         int end_alignment_position);
 
+// A global alignment of a query to a target, as edit operations in edlib's format (EdlibEdop)
+// which is what get_trimmed_alignment expects.
+struct GlobalAlignment {
+    int edit_distance = -1;
+    std::vector<unsigned char> alignment;
+};
+
+// Aligns query to target end to end with unit edit costs, filling only the cells of the DP matrix
+// within band_half_width of the diagonals between the start and the end of the alignment.
+// Returns nullopt if the best alignment within the band reaches its edge, or has runs of
+// mismatches which show the sequences have been forced out of step, as a better alignment might
+// lie outside the band.
+std::optional<GlobalAlignment> banded_global_alignment(std::string_view query,
+                                                       std::string_view target,
+                                                       int band_half_width);
+
+// Aligns query to target end to end with unit edit costs, as edlib does in EDLIB_MODE_NW. Pairs of
+// reads of a duplex molecule are close to identical, so a band sized from their lengths is tried
+// first, falling back to edlib if the band isn't wide enough. Among equally good alignments the
+// one chosen may differ from edlib's.
+GlobalAlignment global_alignment(std::string_view query, std::string_view target);
+
+// A global alignment along with the part of it kept by get_trimmed_alignment.
+struct TrimmedAlignment {
+    GlobalAlignment alignment;
+    int start_alignment_position = 0;
+    int end_alignment_position = 0;
+    int query_cursor = 0;
+    int target_cursor = 0;
+};
+
+// Aligns query to target with global_alignment, then trims the alignment with the overload above,
+// searching forwards from its start and backwards from the operation at the target's last index.
+TrimmedAlignment get_trimmed_alignment(int num_consecutive_wanted,
+                                       std::string_view query,
+                                       std::string_view target);
+
 // Applies a min pool filter to q scores for basespace-duplex algorithm
 void preprocess_quality_scores(std::vector<uint8_t>& quality_scores);
 
-std::unordered_set<std::string> get_read_list_from_pairs(
-        const std::map<std::string, std::string>& template_complement_map);
-
 }  // namespace dorado::utils
@@ -1,6 +1,9 @@
 
+#include "fs_utils.h"
+
 #include <spdlog/spdlog.h>
 
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <optional>
@@ -8,6 +11,7 @@
 #include <set>
 #include <sstream>
 #include <stdexcept>
+#include <system_error>
 
 namespace fs = std::filesystem;
 
@@ -84,4 +88,48 @@ void clean_temporary_models(const std::set<std::filesystem::path>& paths) {
     }
 }
 
+std::optional<fs::path> get_user_cache_dir(const std::string& name) {
+    auto env_path = [](const char* var) -> std::optional<fs::path> {
+        const char* value = std::getenv(var);
+        // Relative paths are ignored, as the XDG spec requires.
+        if (value == nullptr || *value == '\0' || !fs::path(value).is_absolute()) {
+            return std::nullopt;
+        }
+        return fs::path(value);
+    };
+
+#ifdef _WIN32
+    auto cache_root = env_path("LOCALAPPDATA");
+#else
+    auto cache_root = env_path("XDG_CACHE_HOME");
+    if (!cache_root) {
+        cache_root = env_path("HOME");
+        if (cache_root) {
+            *cache_root /= ".cache";
+        }
+    }
+#endif
+    if (!cache_root) {
+        return std::nullopt;
+    }
+
+    const auto dorado_dir = *cache_root / "dorado";
+    const auto dir = dorado_dir / name;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        spdlog::debug("Failed to create cache directory {}: {}", dir.u8string(), ec.message());
+        return std::nullopt;
+    }
+    // Other users mustn't be able to read or plant cached data.
+    for (const auto& path : {dorado_dir, dir}) {
+        fs::permissions(path, fs::perms::owner_all, fs::perm_options::replace, ec);
+        if (ec) {
+            spdlog::debug("Failed to restrict access to {}: {}", path.u8string(), ec.message());
+            return std::nullopt;
+        }
+    }
+    return dir;
+}
+
 }  // namespace dorado::utils
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <optional>
 #include <set>
+#include <string>
 
 namespace dorado::utils {
 
@@ -20,4 +21,10 @@ std::filesystem::path get_downloads_path(const std::optional<std::filesystem::pa
 // Removes paths
 void clean_temporary_models(const std::set<std::filesystem::path>& paths);
 
+// Returns the directory |name| in dorado's cache directory for the current user, which is
+// $XDG_CACHE_HOME/dorado or ~/.cache/dorado (%LOCALAPPDATA%\dorado on Windows). The directories
+// are created if needed and are only accessible to their owner.
+// Returns std::nullopt if the user has no home directory or the directory can't be created.
+std::optional<std::filesystem::path> get_user_cache_dir(const std::string& name);
+
 }  // namespace dorado::utils
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "modbase_probs.h"
+
+#include "sequence_utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace dorado::utils {
+
+SparseModBaseProbs::SparseModBaseProbs(size_t num_states, std::vector<uint32_t> positions)
+        : m_num_states(num_states),
+          m_positions(std::move(positions)),
+          m_probs(m_positions.size() * num_states, 0) {}
+
+SparseModBaseProbs SparseModBaseProbs::from_dense(const std::vector<uint8_t>& dense,
+                                                  size_t num_states) {
+    if (num_states == 0 || dense.size() % num_states != 0) {
+        throw std::runtime_error("Modified base probabilities are not a whole number of rows.");
+    }
+    std::vector<uint32_t> positions(dense.size() / num_states);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        positions[i] = uint32_t(i);
+    }
+    SparseModBaseProbs probs(num_states, std::move(positions));
+    probs.m_probs = dense;
+    return probs;
+}
+
+size_t SparseModBaseProbs::find(size_t seq_pos) const {
+    auto it = std::lower_bound(m_positions.begin(), m_positions.end(), seq_pos);
+    if (it == m_positions.end() || *it != seq_pos) {
+        return npos;
+    }
+    return size_t(std::distance(m_positions.begin(), it));
+}
+
+std::vector<uint8_t> SparseModBaseProbs::to_dense(const std::string& seq,
+                                                  const std::vector<std::string>& alphabet) const {
+    const size_t num_states = alphabet.size();
+    if (!empty() && num_states != m_num_states) {
+        throw std::runtime_error("Modified base alphabet doesn't match the probabilities.");
+    }
+
+    std::array<size_t, 4> canonical_offsets{};
+    for (size_t channel_idx = 0; channel_idx < num_states; ++channel_idx) {
+        const auto& name = alphabet[channel_idx];
+        const int base_id = name.size() == 1 ? BaseInfo::BASE_IDS[uint8_t(name[0])] : -1;
+        if (base_id >= 0) {
+            canonical_offsets[base_id] = channel_idx;
+        }
+    }
+
+    std::vector<uint8_t> dense(seq.size() * num_states, 0);
+    for (size_t i = 0; i < seq.size(); ++i) {
+        const int base_id = BaseInfo::BASE_IDS[uint8_t(seq[i])];
+        if (base_id >= 0) {
+            dense[i * num_states + canonical_offsets[base_id]] = 1;
+        }
+    }
+    for (size_t idx = 0; idx < m_positions.size() && m_positions[idx] < seq.size(); ++idx) {
+        std::memcpy(&dense[m_positions[idx] * num_states], row(idx), num_states);
+    }
+    return dense;
+}
+
+void SparseModBaseProbs::trim(const std::pair<int, int>& trim_interval) {
+    const auto first = std::lower_bound(m_positions.begin(), m_positions.end(),
+                                        uint32_t(std::max(trim_interval.first, 0)));
+    const auto last = std::lower_bound(first, m_positions.end(),
+                                       uint32_t(std::max(trim_interval.second, 0)));
+    const auto first_idx = size_t(std::distance(m_positions.begin(), first));
+    const auto last_idx = size_t(std::distance(m_positions.begin(), last));
+
+    std::vector<uint32_t> positions(first, last);
+    for (auto& pos : positions) {
+        pos -= uint32_t(trim_interval.first);
+    }
+    m_positions = std::move(positions);
+    m_probs = std::vector<uint8_t>(m_probs.begin() + first_idx * m_num_states,
+                                   m_probs.begin() + last_idx * m_num_states);
+}
+
+SparseModBaseProbs SparseModBaseProbs::reversed(size_t seq_len) const {
+    std::vector<uint32_t> positions(m_positions.rbegin(), m_positions.rend());
+    for (auto& pos : positions) {
+        pos = uint32_t(seq_len - 1 - pos);
+    }
+    SparseModBaseProbs reversed_probs(m_num_states, std::move(positions));
+    for (size_t idx = 0; idx < size(); ++idx) {
+        std::memcpy(reversed_probs.row(size() - 1 - idx), row(idx), m_num_states);
+    }
+    return reversed_probs;
+}
+
+}  // namespace dorado::utils
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dorado::utils {
+
+// Modified base probabilities for the positions of a read which have been called, each stored as
+// a row of num_states quantised probabilities in the same channel order as the dense layout of
+// seq.size() * num_states entries. Positions without a row are implicitly 100% canonical and are
+// read as 0 in every modified channel, which is what the dense layout was initialised to.
+class SparseModBaseProbs {
+public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    SparseModBaseProbs() = default;
+
+    // Creates a zeroed row for each of positions, which must be sorted and unique.
+    SparseModBaseProbs(size_t num_states, std::vector<uint32_t> positions);
+
+    // Stores every row of a dense table of seq_len * num_states entries.
+    static SparseModBaseProbs from_dense(const std::vector<uint8_t>& dense, size_t num_states);
+
+    bool empty() const { return m_positions.empty(); }
+    size_t size() const { return m_positions.size(); }
+    size_t num_states() const { return m_num_states; }
+    const std::vector<uint32_t>& positions() const { return m_positions; }
+
+    // Index of the row for seq_pos, or npos if it has no row.
+    size_t find(size_t seq_pos) const;
+
+    uint8_t* row(size_t idx) { return &m_probs[idx * m_num_states]; }
+    const uint8_t* row(size_t idx) const { return &m_probs[idx * m_num_states]; }
+
+    // Dense table of seq.size() * num_states entries, with a probability of 1 in the canonical
+    // channel of positions which have no row, where the canonical channels are the entries of
+    // alphabet which are a single ACGT base.
+    std::vector<uint8_t> to_dense(const std::string& seq,
+                                  const std::vector<std::string>& alphabet) const;
+
+    // Keeps the rows in [trim_interval.first, trim_interval.second), which become relative to
+    // the start of the interval.
+    void trim(const std::pair<int, int>& trim_interval);
+
+    // The rows of a sequence of seq_len bases in reverse order, i.e. position i moves to
+    // seq_len - 1 - i.
+    SparseModBaseProbs reversed(size_t seq_len) const;
+
+private:
+    size_t m_num_states = 0;
+    std::vector<uint32_t> m_positions;
+    std::vector<uint8_t> m_probs;
+};
+
+}  // namespace dorado::utils
@@ -13,4 +13,19 @@ inline void load_state_dict(torch::nn::Module& module, const std::vector<at::Ten
     }
 }
 
+// Like load_state_dict, except that each parameter takes over the storage of its weight, and so its
+// dtype and device, rather than copying it. Weights which view a mapped file then stay in the
+// mapping. A weight whose shape differs from its parameter's is copied as before.
+inline void share_state_dict(torch::nn::Module& module, const std::vector<at::Tensor>& weights) {
+    auto parameters = module.parameters();
+    assert(weights.size() == parameters.size());
+    for (size_t idx = 0; idx < weights.size(); idx++) {
+        if (parameters[idx].sizes() == weights[idx].sizes()) {
+            parameters[idx].set_data(weights[idx]);
+        } else {
+            parameters[idx].data() = weights[idx].data();
+        }
+    }
+}
+
 }  // namespace dorado::utils
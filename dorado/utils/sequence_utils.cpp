@@ -17,6 +17,7 @@
 #include <iterator>
 #include <numeric>
 #include <optional>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -129,6 +130,18 @@ __attribute__((target("avx2"))) std::string reverse_complement_impl(const std::s
 }
 #endif
 
+// Index and mapping options for overlapping a pair of reads, equivalent to
+// "-x map-hifi --cap-kalloc 100m --cap-sw-mem 50m".
+std::pair<mm_idxopt_t, mm_mapopt_t> overlap_options() {
+    mm_idxopt_t idx_opt;
+    mm_mapopt_t map_opt;
+    mm_set_opt(0, &idx_opt, &map_opt);
+    mm_set_opt("map-hifi", &idx_opt, &map_opt);
+    map_opt.cap_kalloc = 100'000'000;
+    map_opt.max_sw_mat = 50'000'000;
+    return {idx_opt, map_opt};
+}
+
 }  // namespace
 
 namespace dorado::utils {
@@ -261,37 +274,50 @@ std::vector<uint64_t> moves_to_map(const std::vector<uint8_t>& moves,
     return seq_to_sig_map;
 }
 
-std::optional<OverlapResult> compute_overlap(const std::string& query_seq,
-                                             const std::string& query_name,
-                                             const std::string& target_seq,
-                                             const std::string& target_name,
-                                             MmTbufPtr& working_buffer) {
-    std::optional<OverlapResult> overlap_result;
-
-    // Add mm2 based overlap check.
-    mm_idxopt_t idx_opt;
-    mm_mapopt_t map_opt;
-    mm_set_opt(0, &idx_opt, &map_opt);
-    mm_set_opt("map-hifi", &idx_opt, &map_opt);
+struct OverlapIndex::Impl {
+    mm_idx_t* index = nullptr;
+    mm_mapopt_t map_opt{};
+    size_t memory_bytes = 0;
+};
 
-    // Equivalent to "--cap-kalloc 100m --cap-sw-mem 50m"
-    map_opt.cap_kalloc = 100'000'000;
-    map_opt.max_sw_mat = 50'000'000;
+OverlapIndex::OverlapIndex(const std::string& query_seq, const std::string& query_name)
+        : m_impl(std::make_unique<Impl>()) {
+    static const auto options = overlap_options();
+    const auto& idx_opt = options.first;
+    m_impl->map_opt = options.second;
 
     const char* seqs[] = {query_seq.c_str()};
     const char* names[] = {query_name.c_str()};
-    mm_idx_t* index = mm_idx_str(idx_opt.w, idx_opt.k, 0, idx_opt.bucket_bits, 1, seqs, names);
-    mm_mapopt_update(&map_opt, index);
+    m_impl->index = mm_idx_str(idx_opt.w, idx_opt.k, 0, idx_opt.bucket_bits, 1, seqs, names);
+    mm_mapopt_update(&m_impl->map_opt, m_impl->index);
+
+    // minimap2 doesn't report the size of an index, so estimate it. Every index has 2^b buckets,
+    // each holding a vector, a count and two pointers, whatever the length of the sequence. A
+    // minimizer is sampled every (w + 1) / 2 bases on average, and costs about 24 bytes in its
+    // bucket's hash table or position array. The sequence itself is packed at 4 bits per base.
+    constexpr size_t kBucketBytes = 48;
+    constexpr size_t kMinimizerBytes = 24;
+    const size_t num_minimizers = 2 * query_seq.length() / size_t(idx_opt.w + 1);
+    m_impl->memory_bytes = (size_t(1) << idx_opt.bucket_bits) * kBucketBytes +
+                           num_minimizers * kMinimizerBytes + (query_seq.length() + 1) / 2;
+}
+
+OverlapIndex::~OverlapIndex() { mm_idx_destroy(m_impl->index); }
+
+size_t OverlapIndex::memory_bytes() const { return m_impl->memory_bytes; }
+
+std::optional<OverlapResult> OverlapIndex::map(const std::string& target_seq,
+                                               const std::string& target_name,
+                                               MmTbufPtr& working_buffer) const {
+    std::optional<OverlapResult> overlap_result;
 
     if (!working_buffer) {
         working_buffer = MmTbufPtr(mm_tbuf_init());
     }
 
     int hits = 0;
-    mm_reg1_t* reg = mm_map(index, int(target_seq.length()), target_seq.c_str(), &hits,
-                            working_buffer.get(), &map_opt, target_name.c_str());
-
-    mm_idx_destroy(index);
+    mm_reg1_t* reg = mm_map(m_impl->index, int(target_seq.length()), target_seq.c_str(), &hits,
+                            working_buffer.get(), &m_impl->map_opt, target_name.c_str());
 
     if (hits > 0) {
         OverlapResult result;
@@ -317,6 +343,14 @@ std::optional<OverlapResult> compute_overlap(const std::string& query_seq,
     return overlap_result;
 }
 
+std::optional<OverlapResult> compute_overlap(const std::string& query_seq,
+                                             const std::string& query_name,
+                                             const std::string& target_seq,
+                                             const std::string& target_name,
+                                             MmTbufPtr& working_buffer) {
+    return OverlapIndex(query_seq, query_name).map(target_seq, target_name, working_buffer);
+}
+
 // Query is the read that the moves table is associated with. A new moves table will be generated
 // Which is aligned to the target sequence.
 std::tuple<int, int, std::vector<uint8_t>> realign_moves(const std::string& query_sequence,
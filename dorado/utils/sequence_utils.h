@@ -4,6 +4,7 @@
 
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -58,6 +59,30 @@ std::optional<OverlapResult> compute_overlap(const std::string& query_seq,
                                              const std::string& target_name,
                                              MmTbufPtr& working_buffer);
 
+// A minimap2 index of a single sequence, built with the same settings as compute_overlap, so that
+// the sequence can be overlapped with any number of other sequences without being re-indexed.
+class OverlapIndex {
+public:
+    OverlapIndex(const std::string& query_seq, const std::string& query_name);
+    ~OverlapIndex();
+
+    OverlapIndex(const OverlapIndex&) = delete;
+    OverlapIndex& operator=(const OverlapIndex&) = delete;
+
+    // Gives the same result as compute_overlap(query_seq, query_name, target_seq, target_name).
+    // Safe to call from several threads at once, each with its own |working_buffer|.
+    std::optional<OverlapResult> map(const std::string& target_seq,
+                                     const std::string& target_name,
+                                     MmTbufPtr& working_buffer) const;
+
+    // Approximate number of bytes of memory held by the index.
+    size_t memory_bytes() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
 // Compute reverse complement of a nucleotide sequence.
 // Bases are specified as capital letters.
 // Undefined output if characters other than A, C, G, T appear.
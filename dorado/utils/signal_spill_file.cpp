@@ -0,0 +1,196 @@
+#include "signal_spill_file.h"
+
+#include <ATen/Functions.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Spilled tensors are aligned to this, which is enough for any vectorised load.
+constexpr size_t DATA_ALIGNMENT = 64;
+
+}  // namespace
+
+namespace dorado::utils {
+
+struct SignalSpillFile::File {
+    ~File() {
+#ifndef _WIN32
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    // Returns the offset of an unused segment, extending the file if none are free.
+    std::optional<uint64_t> acquire_segment() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!free_offsets.empty()) {
+            const auto offset = free_offsets.back();
+            free_offsets.pop_back();
+            return offset;
+        }
+#ifndef _WIN32
+        if (ftruncate(fd, off_t(size + SEGMENT_SIZE)) == 0) {
+            const auto offset = size;
+            size += SEGMENT_SIZE;
+            return offset;
+        }
+#endif
+        return std::nullopt;
+    }
+
+    void release_segment(uint64_t offset) {
+#ifdef __linux__
+        // Give the disk space back until the segment is reused.
+        fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, off_t(offset),
+                  off_t(SEGMENT_SIZE));
+#endif
+        std::lock_guard<std::mutex> lock(mutex);
+        free_offsets.push_back(offset);
+    }
+
+    int fd = -1;
+    std::atomic<size_t> bytes_in_use{0};
+
+    std::mutex mutex;
+    uint64_t size = 0;
+    std::vector<uint64_t> free_offsets;
+};
+
+class SignalSpillFile::Segment {
+public:
+    // Maps an unused segment of file, or returns nullptr if the file can't be extended or mapped.
+    static std::shared_ptr<Segment> create(const std::shared_ptr<File>& file) {
+#ifndef _WIN32
+        const auto offset = file->acquire_segment();
+        if (!offset) {
+            return nullptr;
+        }
+        void* data = mmap(nullptr, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd,
+                          off_t(*offset));
+        if (data == MAP_FAILED) {
+            file->release_segment(*offset);
+            return nullptr;
+        }
+        return std::shared_ptr<Segment>(new Segment(file, *offset, static_cast<char*>(data)));
+#else
+        (void)file;
+        return nullptr;
+#endif
+    }
+
+    ~Segment() {
+#ifndef _WIN32
+        munmap(m_data, SEGMENT_SIZE);
+#endif
+        m_file->release_segment(m_offset);
+        m_file->bytes_in_use -= SEGMENT_SIZE;
+    }
+
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    // Returns space for nbytes, or nullptr if the segment is full.
+    char* allocate(size_t nbytes) {
+        if (nbytes > SEGMENT_SIZE - m_used) {
+            return nullptr;
+        }
+        char* const dest = m_data + m_used;
+        m_used = std::min(SEGMENT_SIZE, (m_used + nbytes + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT *
+                                                DATA_ALIGNMENT);
+        return dest;
+    }
+
+    // Starts writing the segment out, so that the kernel can drop its pages without waiting.
+    void start_writeback() const {
+#ifdef __linux__
+        sync_file_range(m_file->fd, off_t(m_offset), off_t(m_used), SYNC_FILE_RANGE_WRITE);
+#endif
+    }
+
+private:
+    Segment(std::shared_ptr<File> file, uint64_t offset, char* data)
+            : m_file(std::move(file)), m_offset(offset), m_data(data) {
+        m_file->bytes_in_use += SEGMENT_SIZE;
+    }
+
+    std::shared_ptr<File> m_file;
+    uint64_t m_offset;
+    char* m_data;
+    size_t m_used = 0;
+};
+
+SignalSpillFile::SignalSpillFile(const std::filesystem::path& dir) {
+#ifndef _WIN32
+    std::string path_template = (dir / "dorado_signal_spill_XXXXXX").string();
+    std::vector<char> path(path_template.begin(), path_template.end());
+    path.push_back('\0');
+    const int fd = mkstemp(path.data());
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create signal spill file in " + dir.string());
+    }
+    // Unlink straight away, so that the file goes when the last mapping or descriptor does.
+    unlink(path.data());
+    m_file = std::make_shared<File>();
+    m_file->fd = fd;
+    spdlog::debug("Spilling signal to {}", path.data());
+#else
+    spdlog::warn("Signal spilling isn't supported on this platform, {} won't be used",
+                 dir.string());
+#endif
+}
+
+SignalSpillFile::~SignalSpillFile() = default;
+
+at::Tensor SignalSpillFile::spill(const at::Tensor& tensor) {
+    const auto nbytes = size_t(tensor.nbytes());
+    if (!m_file || !tensor.is_cpu() || nbytes == 0 || nbytes > SEGMENT_SIZE) {
+        return tensor;
+    }
+
+    std::shared_ptr<Segment> segment;
+    char* dest = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_current_segment) {
+            dest = m_current_segment->allocate(nbytes);
+        }
+        if (dest == nullptr) {
+            if (m_current_segment) {
+                m_current_segment->start_writeback();
+            }
+            m_current_segment = Segment::create(m_file);
+            if (!m_current_segment) {
+                return tensor;
+            }
+            dest = m_current_segment->allocate(nbytes);
+        }
+        segment = m_current_segment;
+    }
+
+    // The space is ours alone, so it can be filled without holding the lock.
+    const auto src = tensor.contiguous();
+    std::memcpy(dest, src.data_ptr(), nbytes);
+    // Each tensor holds a reference to its segment, which is released with the last one.
+    return at::from_blob(
+            dest, src.sizes(), [segment](void*) mutable { segment.reset(); }, src.options());
+}
+
+size_t SignalSpillFile::spilled_bytes() const { return m_file ? m_file->bytes_in_use.load() : 0; }
+
+}  // namespace dorado::utils
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ATen/core/TensorBody.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+namespace dorado::utils {
+
+// A file which CPU tensors can be moved into, so that their data no longer has to stay in memory.
+// The file is mapped in fixed size segments and spilled tensors view the mapping, so their data is
+// paged back in by the kernel only when it's read. The file is unlinked as soon as it's created,
+// so it never outlives the process, and a segment is reused once every tensor in it is destroyed.
+// Spilled tensors may outlive the SignalSpillFile.
+class SignalSpillFile {
+public:
+    // Size of each mapped segment. Tensors larger than this aren't spilled.
+    static constexpr size_t SEGMENT_SIZE = size_t{64} << 20;
+
+    // Creates the spill file in dir. Throws if it can't be created.
+    explicit SignalSpillFile(const std::filesystem::path& dir);
+    ~SignalSpillFile();
+
+    SignalSpillFile(const SignalSpillFile&) = delete;
+    SignalSpillFile& operator=(const SignalSpillFile&) = delete;
+
+    // Copies tensor into the file and returns a tensor with the same contents and shape which
+    // views it. Returns tensor unchanged if it's not on the CPU, is larger than a segment, or
+    // spilling isn't supported on this platform.
+    at::Tensor spill(const at::Tensor& tensor);
+
+    // Bytes of the file in use, counting every segment which holds a live spilled tensor.
+    size_t spilled_bytes() const;
+
+private:
+    struct File;
+    class Segment;
+
+    std::shared_ptr<File> m_file;
+    std::mutex m_mutex;
+    std::shared_ptr<Segment> m_current_segment;
+};
+
+}  // namespace dorado::utils
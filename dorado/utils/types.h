@@ -204,9 +204,21 @@ private:
 
 enum class ReadOrder { UNRESTRICTED, BY_CHANNEL, BY_TIME };
 
+/// Default limit on the memory used by the overlap indexes in the duplex pairing cache.
+constexpr static size_t DEFAULT_MAX_OVERLAP_INDEX_BYTES = size_t(1) << 30;
+
 struct DuplexPairingParameters {
     ReadOrder read_order;
     size_t cache_depth;
+    // Once the signal held in the pairing cache reaches this many bytes, the signal of the oldest
+    // cached reads is moved to a spill file in signal_spill_dir until it's back under the limit.
+    // 0 disables spilling.
+    size_t signal_spill_threshold = 0;
+    // Directory for the spill file. The system temporary directory is used if this is empty.
+    std::string signal_spill_dir{};
+    // The most bytes of overlap indexes of cached reads to keep for reuse. Once it's reached, the
+    // index of a candidate template is built for each candidate pair and then freed.
+    size_t max_overlap_index_bytes = DEFAULT_MAX_OVERLAP_INDEX_BYTES;
 };
 /// Default cache depth to be used for the duplex pairing cache.
 constexpr static size_t DEFAULT_DUPLEX_CACHE_DEPTH = 10;
@@ -0,0 +1,289 @@
+#include "weight_cache.h"
+
+#include "crypto_utils.h"
+
+#include <ATen/Functions.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <tuple>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char MAGIC[8] = {'D', 'O', 'R', 'A', 'D', 'O', 'W', 'C'};
+constexpr uint32_t VERSION = 1;
+// Tensor data offsets are aligned to this, which is enough for any vectorised load.
+constexpr uint64_t DATA_ALIGNMENT = 64;
+
+uint64_t align_up(uint64_t offset) {
+    return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+}
+
+// The contents of a weight cache file, either mapped or read into memory.
+class CacheFileData {
+public:
+    explicit CacheFileData(const std::filesystem::path &path) {
+#ifndef _WIN32
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st {};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *data = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                              fd, 0);
+            if (data != MAP_FAILED) {
+                m_data = static_cast<char *>(data);
+                m_size = size_t(st.st_size);
+            }
+        }
+        close(fd);
+#else
+        // No mmap on Windows, so read the whole file in one go instead.
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return;
+        }
+        const auto size = size_t(file.tellg());
+        m_buffer = std::make_unique<char[]>(size);
+        file.seekg(0);
+        if (file.read(m_buffer.get(), std::streamsize(size))) {
+            m_data = m_buffer.get();
+            m_size = size;
+        }
+#endif
+    }
+
+    ~CacheFileData() {
+#ifndef _WIN32
+        if (m_data != nullptr) {
+            munmap(m_data, m_size);
+        }
+#endif
+    }
+
+    CacheFileData(const CacheFileData &) = delete;
+    CacheFileData &operator=(const CacheFileData &) = delete;
+
+    char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    char *m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    std::unique_ptr<char[]> m_buffer;
+#endif
+};
+
+// Sequential reader over the header of a cache file which fails on out of range reads.
+class HeaderReader {
+public:
+    HeaderReader(const char *data, size_t size) : m_data(data), m_size(size) {}
+
+    template <typename T>
+    bool read(T &value) {
+        return read_bytes(&value, sizeof(T));
+    }
+
+    bool read_bytes(void *dest, size_t count) {
+        if (count > m_size - m_pos) {
+            return false;
+        }
+        std::memcpy(dest, m_data + m_pos, count);
+        m_pos += count;
+        return true;
+    }
+
+private:
+    const char *m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+};
+
+struct TensorEntry {
+    int32_t scalar_type;
+    std::vector<int64_t> sizes;
+    uint64_t offset;
+    uint64_t nbytes;
+};
+
+template <typename T>
+void write_value(std::ostream &out, const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+}  // namespace
+
+namespace dorado::utils {
+
+std::string directory_fingerprint(const std::filesystem::path &dir) {
+    std::vector<std::tuple<std::string, uintmax_t, int64_t>> entries;
+    for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        const auto mtime = entry.last_write_time().time_since_epoch().count();
+        entries.emplace_back(entry.path().filename().string(), entry.file_size(), int64_t(mtime));
+    }
+    std::sort(entries.begin(), entries.end());
+
+    std::ostringstream fingerprint;
+    for (const auto &[name, size, mtime] : entries) {
+        fingerprint << name << ':' << size << ':' << mtime << ';';
+    }
+    return fingerprint.str();
+}
+
+std::string cache_file_stem(const std::filesystem::path &model_path, std::string_view key) {
+    const auto key_digest = crypto::sha256(key);
+    std::ostringstream stem;
+    stem << model_path.filename().string() << '_' << std::hex;
+    stem.fill('0');
+    for (size_t i = 0; i < 8; ++i) {
+        stem << std::setw(2) << static_cast<int>(key_digest[i]);
+    }
+    return stem.str();
+}
+
+void save_weight_cache(const std::filesystem::path &path,
+                       const std::string &fingerprint,
+                       const std::vector<at::Tensor> &tensors) {
+    std::vector<at::Tensor> cpu_tensors;
+    std::vector<TensorEntry> entries;
+    cpu_tensors.reserve(tensors.size());
+    entries.reserve(tensors.size());
+
+    // Header size, so that the data offsets can be filled in before writing.
+    uint64_t header_size = sizeof(MAGIC) + sizeof(VERSION) + sizeof(uint32_t) + sizeof(uint64_t) +
+                           fingerprint.size();
+    for (const auto &tensor : tensors) {
+        auto cpu_tensor = tensor.to(at::kCPU).contiguous();
+        entries.push_back({static_cast<int32_t>(cpu_tensor.scalar_type()),
+                           cpu_tensor.sizes().vec(), 0, uint64_t(cpu_tensor.nbytes())});
+        header_size += sizeof(int32_t) + sizeof(uint32_t) + sizeof(int64_t) * cpu_tensor.dim() +
+                       2 * sizeof(uint64_t);
+        cpu_tensors.push_back(std::move(cpu_tensor));
+    }
+    uint64_t offset = align_up(header_size);
+    for (auto &entry : entries) {
+        entry.offset = offset;
+        offset = align_up(offset + entry.nbytes);
+    }
+
+    std::filesystem::create_directories(path.parent_path());
+    std::random_device rd;
+    auto tmp_path = path;
+    tmp_path += ".tmp" + std::to_string(rd());
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to open weight cache file " + tmp_path.string());
+        }
+        out.write(MAGIC, sizeof(MAGIC));
+        write_value(out, VERSION);
+        write_value(out, uint32_t(entries.size()));
+        write_value(out, uint64_t(fingerprint.size()));
+        out.write(fingerprint.data(), std::streamsize(fingerprint.size()));
+        for (const auto &entry : entries) {
+            write_value(out, entry.scalar_type);
+            write_value(out, uint32_t(entry.sizes.size()));
+            for (auto size : entry.sizes) {
+                write_value(out, size);
+            }
+            write_value(out, entry.offset);
+            write_value(out, entry.nbytes);
+        }
+
+        const std::vector<char> padding(DATA_ALIGNMENT, 0);
+        uint64_t pos = header_size;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            out.write(padding.data(), std::streamsize(entries[i].offset - pos));
+            out.write(static_cast<const char *>(cpu_tensors[i].data_ptr()),
+                      std::streamsize(entries[i].nbytes));
+            pos = entries[i].offset + entries[i].nbytes;
+        }
+        if (!out) {
+            std::error_code ec;
+            out.close();
+            std::filesystem::remove(tmp_path, ec);
+            throw std::runtime_error("Failed to write weight cache file " + tmp_path.string());
+        }
+    }
+    std::filesystem::rename(tmp_path, path);
+}
+
+std::optional<std::vector<at::Tensor>> load_weight_cache(const std::filesystem::path &path,
+                                                         const std::string &fingerprint) {
+    auto file = std::make_shared<CacheFileData>(path);
+    if (file->data() == nullptr) {
+        return std::nullopt;
+    }
+
+    HeaderReader reader(file->data(), file->size());
+    char magic[sizeof(MAGIC)];
+    uint32_t version = 0;
+    uint32_t num_tensors = 0;
+    uint64_t fingerprint_size = 0;
+    if (!reader.read_bytes(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !reader.read(version) || version != VERSION || !reader.read(num_tensors) ||
+        !reader.read(fingerprint_size) || fingerprint_size != fingerprint.size()) {
+        spdlog::debug("Ignoring invalid or outdated weight cache {}", path.string());
+        return std::nullopt;
+    }
+    std::string file_fingerprint(fingerprint_size, '\0');
+    if (!reader.read_bytes(file_fingerprint.data(), fingerprint_size) ||
+        file_fingerprint != fingerprint) {
+        spdlog::debug("Ignoring outdated weight cache {}", path.string());
+        return std::nullopt;
+    }
+
+    std::vector<at::Tensor> tensors;
+    tensors.reserve(num_tensors);
+    for (uint32_t i = 0; i < num_tensors; ++i) {
+        TensorEntry entry{};
+        uint32_t ndim = 0;
+        if (!reader.read(entry.scalar_type) || !reader.read(ndim)) {
+            return std::nullopt;
+        }
+        entry.sizes.resize(ndim);
+        for (auto &size : entry.sizes) {
+            if (!reader.read(size)) {
+                return std::nullopt;
+            }
+        }
+        if (!reader.read(entry.offset) || !reader.read(entry.nbytes) ||
+            entry.offset > file->size() || entry.nbytes > file->size() - entry.offset) {
+            return std::nullopt;
+        }
+
+        const auto options = at::TensorOptions().dtype(at::ScalarType(entry.scalar_type));
+        // Each tensor holds a reference to the file data, which is released with the last one.
+        auto tensor = at::from_blob(
+                file->data() + entry.offset, entry.sizes,
+                [file](void *) mutable { file.reset(); }, options);
+        if (uint64_t(tensor.nbytes()) != entry.nbytes) {
+            return std::nullopt;
+        }
+        tensors.push_back(std::move(tensor));
+    }
+    return tensors;
+}
+
+}  // namespace dorado::utils
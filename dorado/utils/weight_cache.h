@@ -0,0 +1,37 @@
+#pragma once
+
+#include <ATen/core/TensorBody.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dorado::utils {
+
+// Fingerprint of the regular files directly inside dir, from their names, sizes and modification
+// times. Used to invalidate data derived from the contents of a model directory.
+std::string directory_fingerprint(const std::filesystem::path& dir);
+
+// Stem for the name of a file cached from the model at model_path: the model's directory name,
+// then the first 8 bytes of the SHA-256 digest of key in hex. Unlike std::hash, the digest is the
+// same whichever build of dorado computes it.
+std::string cache_file_stem(const std::filesystem::path& model_path, std::string_view key);
+
+// Writes tensors to a single file at path, laid out contiguously with each tensor aligned so that
+// it can be used in place once the file is mapped. fingerprint is stored in the file and checked
+// by load_weight_cache. The file is written to a temporary path and then renamed, so concurrent
+// readers never see a partial file.
+void save_weight_cache(const std::filesystem::path& path,
+                       const std::string& fingerprint,
+                       const std::vector<at::Tensor>& tensors);
+
+// Memory-maps a file written by save_weight_cache and returns CPU tensors which view the mapping.
+// The mapping is private, so writes to the tensors don't reach the file, and is released when the
+// last tensor is destroyed.
+// Returns std::nullopt if the file doesn't exist, is malformed, or has a different fingerprint.
+std::optional<std::vector<at::Tensor>> load_weight_cache(const std::filesystem::path& path,
+                                                         const std::string& fingerprint);
+
+}  // namespace dorado::utils
@@ -140,4 +140,54 @@ TEST_CASE(TEST_GROUP ": process_and_pop_n") {
     std::iota(expected.begin(), expected.end(), 0);
     CHECK(popped_items == expected);
     CHECK(queue.size() == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE(TEST_GROUP ": deadline ordered items") {
+    // Delay items by their value, so later items with smaller values overtake earlier ones, and
+    // items with equal deadlines come out oldest first.
+    using Items = dorado::utils::DeadlineOrderedItems<int>;
+    AsyncQueue<int, Items> queue(10, Items([](int a) { return uint64_t(a); }));
+    for (int i : {5, 3, 7, 3, 1, 8}) {
+        int ii = i;
+        const auto status = queue.try_push(std::move(ii));
+        REQUIRE(status == AsyncQueueStatus::Success);
+    }
+
+    // Deadlines are 5, 4, 9, 6, 5, 13.
+    const auto timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(100);
+    std::vector<int> popped_items;
+    int item = -1;
+    while (queue.try_pop_until(item, timeout) == AsyncQueueStatus::Success) {
+        popped_items.push_back(item);
+    }
+
+    const std::vector<int> expected{3, 5, 1, 3, 7, 8};
+    CHECK(popped_items == expected);
+    CHECK(queue.size() == 0);
+}
+
+TEST_CASE(TEST_GROUP ": deadline ordered items can't be starved") {
+    // An item with a long delay is overtaken by undelayed items, but only by those pushed before
+    // its deadline.
+    using Items = dorado::utils::DeadlineOrderedItems<int>;
+    constexpr int delay = 10;
+    AsyncQueue<int, Items> queue(100, Items([](int a) { return a < 0 ? uint64_t(delay) : 0; }));
+    int delayed_item = -1;
+    REQUIRE(queue.try_push(std::move(delayed_item)) == AsyncQueueStatus::Success);
+
+    std::vector<int> popped_items;
+    int item = 0;
+    for (int i = 0; i < 2 * delay; ++i) {
+        int ii = i;
+        REQUIRE(queue.try_push(std::move(ii)) == AsyncQueueStatus::Success);
+        REQUIRE(queue.try_pop(item) == AsyncQueueStatus::Success);
+        popped_items.push_back(item);
+    }
+
+    // The delayed item has deadline 10, and the item pushed at sequence number 10 has the same
+    // deadline, so the delayed item goes before it.
+    REQUIRE(popped_items.size() == size_t(2 * delay));
+    CHECK(popped_items[delay - 2] == delay - 2);
+    CHECK(popped_items[delay - 1] == -1);
+    CHECK(queue.size() == 1);
+}
@@ -0,0 +1,69 @@
+#include "read_pipeline/BaseSpaceDuplexCallerNode.h"
+
+#include "MessageSinkUtils.h"
+#include "TestUtils.h"
+#include "utils/duplex_pair_list.h"
+#include "utils/sequence_utils.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#define TEST_GROUP "[BaseSpaceDuplexCallerNodeTest]"
+
+TEST_CASE("Pairs are called as their reads stream in", TEST_GROUP) {
+    const auto temp_dir = make_temp_dir("basespace_duplex");
+    const auto reads_file = temp_dir.m_path / "reads.fastq";
+
+    const auto template_1 = generate_random_sequence_string(600);
+    const auto template_2 = generate_random_sequence_string(600);
+    const std::vector<std::pair<std::string, std::string>> reads{
+            {"template_1", template_1},
+            {"unpaired", generate_random_sequence_string(600)},
+            {"template_2", template_2},
+            // Read after the complement it's paired with.
+            {"complement_2", dorado::utils::reverse_complement(template_2)},
+            {"complement_1", dorado::utils::reverse_complement(template_1)},
+            {"template_3", generate_random_sequence_string(600)},
+    };
+    {
+        std::ofstream fastq(reads_file);
+        for (const auto& [read_id, seq] : reads) {
+            fastq << '@' << read_id << '\n'
+                  << seq << "\n+\n"
+                  << std::string(seq.size(), '5') << '\n';
+        }
+    }
+
+    const std::map<std::string, std::string> template_complement_map{
+            {"template_1", "complement_1"},
+            {"template_2", "complement_2"},
+            // Missing from the file.
+            {"template_3", "complement_3"}};
+    dorado::utils::DuplexPairList pair_list(template_complement_map);
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    pipeline_desc.add_node<dorado::BaseSpaceDuplexCallerNode>(
+            {sink}, std::move(pair_list), reads_file.string(), 2);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+    pipeline.reset();
+
+    auto duplex_reads = ConvertMessages<dorado::DuplexReadPtr>(std::move(messages));
+    std::sort(duplex_reads.begin(), duplex_reads.end(), [](const auto& a, const auto& b) {
+        return a->read_common.read_id < b->read_common.read_id;
+    });
+    REQUIRE(duplex_reads.size() == 2);
+    CHECK(duplex_reads[0]->read_common.read_id == "template_1;complement_1");
+    CHECK(duplex_reads[1]->read_common.read_id == "template_2;complement_2");
+    for (const auto& duplex_read : duplex_reads) {
+        CHECK(duplex_read->read_common.is_duplex);
+        CHECK(!duplex_read->read_common.seq.empty());
+    }
+}
@@ -0,0 +1,223 @@
+#include "read_pipeline/BasecallerNode.h"
+
+#include "MessageSinkUtils.h"
+#include "TestUtils.h"
+#include "basecall/CRFModelConfig.h"
+#include "basecall/ModelRunnerBase.h"
+#include "read_pipeline/DefaultClientInfo.h"
+
+#include <ATen/Functions.h>
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_GROUP "[BasecallerNode]"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr size_t kChunkSize = 100;
+constexpr size_t kOverlap = 10;
+
+// The batches a MockRunner has been asked to call. Each chunk is identified by the first sample of
+// its signal, which push_read() sets to read_tag * 1000 + the chunk's offset in the read.
+struct CalledBatches {
+    std::mutex mutex;
+    std::vector<std::vector<int>> chunk_ids;
+
+    // If gated, the first call waits until the gate is released.
+    bool gated = false;
+    std::promise<void> first_call_started;
+    std::promise<void> release_gate;
+
+    std::vector<std::vector<int>> get() {
+        std::lock_guard lock(mutex);
+        return chunk_ids;
+    }
+};
+
+class MockRunner final : public dorado::basecall::ModelRunnerBase {
+public:
+    MockRunner(const dorado::basecall::CRFModelConfig &config,
+               size_t batch_size,
+               int batch_timeout_ms,
+               std::shared_ptr<CalledBatches> batches)
+            : m_config(config),
+              m_batch_size(batch_size),
+              m_batch_timeout_ms(batch_timeout_ms),
+              m_batches(std::move(batches)),
+              m_chunk_ids(batch_size) {}
+
+    void accept_chunk(int chunk_idx, const at::Tensor &chunk) override {
+        m_chunk_ids[chunk_idx] = int(chunk[0][0].item<float>());
+    }
+
+    std::vector<dorado::basecall::decode::DecodedChunk> call_chunks(int num_chunks) override {
+        bool wait_for_gate = false;
+        {
+            std::lock_guard lock(m_batches->mutex);
+            m_batches->chunk_ids.emplace_back(m_chunk_ids.begin(),
+                                              m_chunk_ids.begin() + num_chunks);
+            wait_for_gate = m_batches->gated && m_batches->chunk_ids.size() == 1;
+        }
+        if (wait_for_gate) {
+            m_batches->first_call_started.set_value();
+            m_batches->release_gate.get_future().wait();
+        }
+
+        // One base per sample.
+        dorado::basecall::decode::DecodedChunk called{std::string(kChunkSize, 'A'),
+                                                      std::string(kChunkSize, '!'),
+                                                      std::vector<uint8_t>(kChunkSize, 1)};
+        return std::vector<dorado::basecall::decode::DecodedChunk>(size_t(num_chunks), called);
+    }
+
+    const dorado::basecall::CRFModelConfig &config() const override { return m_config; }
+    size_t chunk_size() const override { return kChunkSize; }
+    size_t batch_size() const override { return m_batch_size; }
+    int batch_timeout_ms() const override { return m_batch_timeout_ms; }
+    bool is_low_latency() const override { return true; }
+    void terminate() override {}
+    void restart() override {}
+    std::string get_name() const override { return "MockRunner"; }
+    dorado::stats::NamedStats sample_stats() const override { return {}; }
+
+private:
+    const dorado::basecall::CRFModelConfig &m_config;
+    const size_t m_batch_size;
+    const int m_batch_timeout_ms;
+    std::shared_ptr<CalledBatches> m_batches;
+    std::vector<int> m_chunk_ids;
+};
+
+class BasecallerNodeFixture {
+protected:
+    BasecallerNodeFixture() {
+        // The node checks the model's name to see whether it's an RNA model.
+        const auto model_path = m_model_dir.m_path / "dna_mock_model";
+        std::filesystem::create_directories(model_path);
+        m_config.stride = 1;
+        m_config.num_features = 1;
+        m_config.model_path = model_path;
+    }
+
+    void create_pipeline(size_t batch_size, int batch_timeout_ms) {
+        std::vector<dorado::basecall::RunnerPtr> runners;
+        runners.push_back(
+                std::make_unique<MockRunner>(m_config, batch_size, batch_timeout_ms, m_batches));
+
+        dorado::PipelineDescriptor pipeline_desc;
+        auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 1000, m_messages);
+        m_basecaller = pipeline_desc.add_node<dorado::BasecallerNode>(
+                {sink}, std::move(runners), kOverlap, "dna_mock_model", 1000, "basecaller", 0);
+        m_pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+    }
+
+    void push_read(int read_tag, int64_t num_samples) {
+        auto read = std::make_unique<dorado::SimplexRead>();
+        read->read_common.raw_data = at::arange(num_samples, at::kFloat) + float(read_tag * 1000);
+        read->read_common.read_id = "read_" + std::to_string(read_tag);
+        read->read_common.client_info = std::make_shared<dorado::DefaultClientInfo>();
+        m_pipeline->push_message(std::move(read));
+    }
+
+    dorado::stats::NamedStats sample_stats() {
+        return m_pipeline->get_node_ref(m_basecaller).sample_stats();
+    }
+
+    TempDir m_model_dir = make_temp_dir("basecaller_node");
+    dorado::basecall::CRFModelConfig m_config{};
+    std::shared_ptr<CalledBatches> m_batches = std::make_shared<CalledBatches>();
+    std::vector<dorado::Message> m_messages;
+    dorado::NodeHandle m_basecaller{};
+    std::unique_ptr<dorado::Pipeline> m_pipeline;
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(BasecallerNodeFixture,
+                 TEST_GROUP " low latency chunks of reads close to completion go first",
+                 TEST_GROUP) {
+    m_batches->gated = true;
+    create_pipeline(4, 100);
+
+    // Hold the worker in the first batch, which is the 4 chunks of read 1, so that the chunks of
+    // the next reads queue up behind it.
+    auto first_call_started = m_batches->first_call_started.get_future();
+    push_read(1, 370);
+    REQUIRE(first_call_started.wait_for(10s) == std::future_status::ready);
+
+    // A read of 5 chunks, then a read of 1 chunk.
+    push_read(2, 460);
+    push_read(3, 50);
+    const auto wait_start = std::chrono::steady_clock::now();
+    while (sample_stats().at("queued_chunks") < 6 &&
+           std::chrono::steady_clock::now() - wait_start < 10s) {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(sample_stats().at("queued_chunks") == 6);
+    m_batches->release_gate.set_value();
+    m_pipeline->terminate(dorado::DefaultFlushOptions());
+
+    // A chunk's delay is 8 pushes for each chunk of its read after it. Read 1's chunks may have
+    // been taken as soon as they were pushed, so their order depends on timing.
+    auto batches = m_batches->get();
+    REQUIRE(batches.size() == 3);
+    std::sort(batches[0].begin(), batches[0].end());
+    CHECK(batches[0] == std::vector{1000, 1090, 1180, 1270});
+    // Read 2's last chunk is due first, then read 3's only chunk, then the rest of read 2 from its
+    // end back to its start.
+    CHECK(batches[1] == std::vector{2360, 3000, 2270, 2180});
+    CHECK(batches[2] == std::vector{2090, 2000});
+
+    const auto stats = sample_stats();
+    CHECK(stats.at("batches_called") == 3);
+    CHECK(stats.at("called_reads_pushed") == 3);
+    m_pipeline.reset();
+    CHECK(m_messages.size() == 3);
+}
+
+TEST_CASE_METHOD(BasecallerNodeFixture,
+                 TEST_GROUP " low latency partial batches are flushed by read age",
+                 TEST_GROUP) {
+    // Single chunk reads arrive more often than the batch timeout, so waiting for a gap in the
+    // reads would hold the batch back until it was full.
+    constexpr size_t batch_size = 16;
+    constexpr auto batch_timeout = 300ms;
+    create_pipeline(batch_size, int(batch_timeout.count()));
+
+    for (int i = 0; i < 20; ++i) {
+        push_read(i + 1, 50);
+        std::this_thread::sleep_for(batch_timeout / 6);
+    }
+    m_pipeline->terminate(dorado::DefaultFlushOptions());
+
+    // Pushing the reads takes several batch timeouts but far fewer than a batch of reads arrive
+    // within one, so the first batch can only have been called before it was full if it was
+    // flushed by the age of its reads.
+    const auto batches = m_batches->get();
+    REQUIRE(batches.size() > 1);
+    CHECK(batches.front().size() < batch_size);
+    CHECK(sample_stats().at("partial_batches_called") >= 1);
+    // Every read has a single chunk, so the reads are called in the order they arrived.
+    std::vector<int> chunk_ids;
+    for (const auto &batch : batches) {
+        chunk_ids.insert(chunk_ids.end(), batch.begin(), batch.end());
+    }
+    std::vector<int> expected_chunk_ids;
+    for (int i = 0; i < 20; ++i) {
+        expected_chunk_ids.push_back((i + 1) * 1000);
+    }
+    CHECK(chunk_ids == expected_chunk_ids);
+
+    m_pipeline.reset();
+    CHECK(m_messages.size() == 20);
+}
@@ -0,0 +1,161 @@
+#include "basecall/decode/CPUDecoder.h"
+#include "basecall/decode/beam_search.h"
+
+#include <torch/torch.h>
+// Catch2 must come after torch since both define CHECK()
+#include <catch2/catch.hpp>
+
+#include <random>
+
+#define CUT_TAG "[BeamSearch]"
+
+namespace {
+
+// Transition scores (TNC) for chunks with a random path through 4^state_len states. Steps along
+// the path are boosted by path_score over unit Gaussian noise, except in every 4th window of 50
+// blocks where the boost is ambiguous_path_score.
+at::Tensor make_scores(int num_chunks,
+                       int num_blocks,
+                       int state_len,
+                       float path_score,
+                       float ambiguous_path_score) {
+    const int num_state_bits = 2 * state_len;
+    const int num_states = 1 << num_state_bits;
+    auto scores = torch::randn({num_blocks, num_chunks, num_states * 4});
+    auto scores_a = scores.accessor<float, 3>();
+
+    std::minstd_rand rng(42);
+    for (int n = 0; n < num_chunks; ++n) {
+        int state = int(rng() % num_states);
+        for (int t = 0; t < num_blocks; ++t) {
+            if (rng() % 3 == 0) {
+                // Stay.
+                continue;
+            }
+            const int new_state = ((state << 2) & (num_states - 1)) | int(rng() % 4);
+            const int move_idx = (new_state << 2) + (state >> (num_state_bits - 2));
+            scores_a[t][n][move_idx] += (t / 50) % 4 == 3 ? ambiguous_path_score : path_score;
+            state = new_state;
+        }
+    }
+    return scores;
+}
+
+std::vector<dorado::basecall::decode::DecodedChunk> decode(
+        const at::Tensor &scores,
+        const dorado::basecall::decode::DecoderOptions &options) {
+    dorado::basecall::decode::CPUDecoder decoder;
+    return decoder.beam_search_part_2({scores, int(scores.size(1)), options});
+}
+
+// Mean number of beam elements kept per block over all chunks, decoding each chunk as
+// CPUDecoder does.
+float mean_beam_width(const at::Tensor &scores,
+                      const dorado::basecall::decode::DecoderOptions &options) {
+    namespace decode = dorado::basecall::decode;
+    const auto bwd = decode::inner::backward_scores(scores, options.blank_score);
+    const auto fwd = decode::inner::forward_scores(scores, options.blank_score);
+    const auto posts = at::softmax(fwd + bwd, -1).transpose(0, 1).contiguous();
+    const auto scores_NTC = scores.transpose(0, 1);
+    const auto bwd_NTC = bwd.transpose(0, 1).contiguous();
+
+    size_t num_beam_elements = 0;
+    for (int n = 0; n < int(scores.size(1)); ++n) {
+        size_t chunk_beam_elements = 0;
+        decode::beam_search_decode(scores_NTC[n], bwd_NTC[n], posts[n], options.beam_width,
+                                   options.beam_cut, options.blank_score, options.q_shift,
+                                   options.q_scale, 1.0f,
+                                   options.adaptive_beam ? options.min_beam_width : 0,
+                                   options.adaptive_beam_margin, &chunk_beam_elements);
+        num_beam_elements += chunk_beam_elements;
+    }
+    return float(num_beam_elements) / float(scores.size(0) * scores.size(1));
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": adaptive beam matches fixed beam on unambiguous scores", CUT_TAG) {
+    torch::manual_seed(1);
+    const auto scores = make_scores(4, 1000, 3, 10.f, 10.f);
+
+    dorado::basecall::decode::DecoderOptions fixed_options;
+    auto adaptive_options = fixed_options;
+    adaptive_options.adaptive_beam = true;
+
+    const auto fixed = decode(scores, fixed_options);
+    const auto adaptive = decode(scores, adaptive_options);
+    REQUIRE(fixed.size() == adaptive.size());
+    for (size_t i = 0; i < fixed.size(); ++i) {
+        CHECK(adaptive[i].sequence == fixed[i].sequence);
+        CHECK(adaptive[i].qstring == fixed[i].qstring);
+        CHECK(adaptive[i].moves == fixed[i].moves);
+    }
+}
+
+TEST_CASE(CUT_TAG ": adaptive beam with no narrowing matches fixed beam", CUT_TAG) {
+    torch::manual_seed(2);
+    const auto scores = make_scores(4, 1000, 3, 3.f, 0.5f);
+
+    dorado::basecall::decode::DecoderOptions fixed_options;
+    auto adaptive_options = fixed_options;
+    adaptive_options.adaptive_beam = true;
+    adaptive_options.min_beam_width = fixed_options.beam_width;
+
+    const auto fixed = decode(scores, fixed_options);
+    const auto adaptive = decode(scores, adaptive_options);
+    REQUIRE(fixed.size() == adaptive.size());
+    for (size_t i = 0; i < fixed.size(); ++i) {
+        CHECK(adaptive[i].sequence == fixed[i].sequence);
+        CHECK(adaptive[i].moves == fixed[i].moves);
+    }
+}
+
+TEST_CASE(CUT_TAG ": adaptive beam narrows on confident blocks and widens on ambiguous ones",
+          CUT_TAG) {
+    torch::manual_seed(4);
+    const auto confident_scores = make_scores(4, 1000, 3, 10.f, 10.f);
+    const auto mixed_scores = make_scores(4, 1000, 3, 10.f, 0.5f);
+
+    // Use a beam cut loose enough that only the beam width limits the beam.
+    dorado::basecall::decode::DecoderOptions fixed_options;
+    fixed_options.beam_cut = 1e10f;
+    auto adaptive_options = fixed_options;
+    adaptive_options.adaptive_beam = true;
+
+    const float fixed_width = mean_beam_width(confident_scores, fixed_options);
+    const float confident_width = mean_beam_width(confident_scores, adaptive_options);
+    const float mixed_width = mean_beam_width(mixed_scores, adaptive_options);
+
+    CHECK(fixed_width >= float(fixed_options.beam_width) * 0.8f);
+    CHECK(confident_width < fixed_width / 2);
+    CHECK(confident_width >= float(adaptive_options.min_beam_width));
+    // A quarter of the blocks are ambiguous, and the beam should open up in those.
+    CHECK(mixed_width > confident_width);
+    CHECK(mixed_width <= float(fixed_options.beam_width));
+}
+
+TEST_CASE(CUT_TAG ": benchmark adaptive beam", "[!benchmark]" CUT_TAG) {
+    torch::manual_seed(3);
+    const auto scores = make_scores(32, 2000, 5, 4.f, 1.f);
+
+    dorado::basecall::decode::DecoderOptions fixed_options;
+    auto adaptive_options = fixed_options;
+    adaptive_options.adaptive_beam = true;
+
+    // Accuracy relative to the fixed beam, as the fraction of chunks decoded identically.
+    const auto fixed = decode(scores, fixed_options);
+    const auto adaptive = decode(scores, adaptive_options);
+    size_t num_identical = 0;
+    for (size_t i = 0; i < fixed.size(); ++i) {
+        if (adaptive[i].sequence == fixed[i].sequence) {
+            ++num_identical;
+        }
+    }
+    WARN("Chunks decoded identically with adaptive beam: " << num_identical << "/"
+                                                           << fixed.size());
+    WARN("Mean beam width: fixed " << mean_beam_width(scores, fixed_options) << ", adaptive "
+                                   << mean_beam_width(scores, adaptive_options));
+
+    BENCHMARK("fixed beam") { return decode(scores, fixed_options); };
+    BENCHMARK("adaptive beam") { return decode(scores, adaptive_options); };
+}
@@ -0,0 +1,141 @@
+#include "TestUtils.h"
+#include "basecall/cpu_autotune.h"
+
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#define CUT_TAG "[CPUAutotune]"
+
+using namespace dorado::basecall;
+using namespace dorado::basecall::details;
+
+namespace {
+
+void write_cache(const std::filesystem::path &path, const std::string &contents) {
+    std::ofstream file(path);
+    file << contents;
+}
+
+// Throughput of a candidate, as a product of factors for its batch size and runner count,
+// recording which candidates were measured.
+struct FakeThroughput {
+    std::map<int, double> per_batch_size;
+    std::map<size_t, double> per_runner_count;
+    std::vector<std::pair<int, size_t>> measured;
+
+    double operator()(const CPUBasecallSettings &settings) {
+        measured.emplace_back(settings.batch_size, settings.num_runners);
+        return per_batch_size.at(settings.batch_size) *
+               per_runner_count.at(settings.num_runners);
+    }
+};
+
+using Candidates = std::vector<std::pair<int, size_t>>;
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": cached settings round trip", CUT_TAG) {
+    auto temp_dir = make_temp_dir("cpu_autotune_round_trip");
+    const auto cache_path = temp_dir.m_path / "settings.txt";
+
+    const CPUBasecallSettings settings{128, 4, 2};
+    save_cpu_basecall_settings(cache_path, settings);
+
+    auto loaded = load_cpu_basecall_settings(cache_path, 8, 0);
+    REQUIRE(loaded.has_value());
+    CHECK(loaded->batch_size == settings.batch_size);
+    CHECK(loaded->num_runners == settings.num_runners);
+    CHECK(loaded->decode_threads == settings.decode_threads);
+
+    // The settings were tuned for 4 runners, so they're also good when 4 are asked for.
+    CHECK(load_cpu_basecall_settings(cache_path, 8, 4).has_value());
+    CHECK_FALSE(load_cpu_basecall_settings(cache_path, 8, 2).has_value());
+    // A host with fewer threads couldn't have chosen them.
+    CHECK_FALSE(load_cpu_basecall_settings(cache_path, 2, 0).has_value());
+}
+
+TEST_CASE(CUT_TAG ": invalid cached settings are ignored", CUT_TAG) {
+    auto temp_dir = make_temp_dir("cpu_autotune_invalid");
+    const auto cache_path = temp_dir.m_path / "settings.txt";
+
+    CHECK_FALSE(load_cpu_basecall_settings(cache_path, 8, 0).has_value());
+
+    auto contents = GENERATE("", "garbage", "128 4", "0 4 2", "-128 4 2", "128 0 2", "128 -1 2",
+                             "128 4 0", "128 4 -2", "128 9 2", "128 4 9", "4 4 8", "100000 4 2",
+                             "99999999999 4 2");
+    CAPTURE(contents);
+    write_cache(cache_path, contents);
+    CHECK_FALSE(load_cpu_basecall_settings(cache_path, 8, 0).has_value());
+}
+
+TEST_CASE(CUT_TAG ": candidate selection", CUT_TAG) {
+    constexpr int num_threads = 8;
+    auto max_num_runners = [](int) { return size_t(8); };
+
+    SECTION("runner counts are doubled at the middle batch size until the throughput drops") {
+        FakeThroughput throughput{
+                {{64, 64.0}, {128, 128.0}, {256, 256.0}}, {{1, 1.0}, {2, 1.8}, {4, 3.0}, {8, 2.5}}};
+        const auto best = select_cpu_basecall_settings({64, 128, 256}, max_num_runners, 0,
+                                                       num_threads, std::ref(throughput));
+        CHECK(best.batch_size == 256);
+        CHECK(best.num_runners == 4);
+        CHECK(best.decode_threads == 2);
+        // The larger batch size improved, so the smaller one isn't tried.
+        CHECK(throughput.measured ==
+              Candidates{{128, 1}, {128, 2}, {128, 4}, {128, 8}, {256, 4}});
+    }
+
+    SECTION("larger runner counts aren't tried once the throughput drops") {
+        FakeThroughput throughput{{{64, 1.0}}, {{1, 1.0}, {2, 0.5}}};
+        const auto best = select_cpu_basecall_settings({64}, max_num_runners, 0, num_threads,
+                                                       std::ref(throughput));
+        CHECK(best.num_runners == 1);
+        CHECK(best.decode_threads == 8);
+        CHECK(throughput.measured == Candidates{{64, 1}, {64, 2}});
+    }
+
+    SECTION("smaller batch sizes are tried when larger ones don't help") {
+        FakeThroughput throughput{{{64, 3.0}, {128, 2.0}, {256, 1.0}}, {{1, 1.0}, {2, 0.5}}};
+        const auto best = select_cpu_basecall_settings({64, 128, 256}, max_num_runners, 0,
+                                                       num_threads, std::ref(throughput));
+        CHECK(best.batch_size == 64);
+        CHECK(best.num_runners == 1);
+        CHECK(throughput.measured == Candidates{{128, 1}, {128, 2}, {256, 1}, {64, 1}});
+    }
+
+    SECTION("runner counts are limited per batch size") {
+        FakeThroughput throughput{{{64, 1.0}, {128, 1.0}, {256, 2.0}},
+                                  {{1, 1.0}, {2, 2.0}, {4, 4.0}}};
+        auto limited_runners = [](int batch_size) { return size_t(batch_size > 128 ? 2 : 4); };
+        const auto best = select_cpu_basecall_settings({64, 128, 256}, limited_runners, 0,
+                                                       num_threads, std::ref(throughput));
+        CHECK(best.batch_size == 128);
+        CHECK(best.num_runners == 4);
+        CHECK(throughput.measured ==
+              Candidates{{128, 1}, {128, 2}, {128, 4}, {256, 2}, {64, 4}});
+    }
+
+    SECTION("a fixed runner count is kept") {
+        FakeThroughput throughput{{{64, 64.0}, {128, 128.0}, {256, 256.0}}, {{3, 1.0}}};
+        const auto best = select_cpu_basecall_settings({64, 128, 256}, max_num_runners, 3,
+                                                       num_threads, std::ref(throughput));
+        CHECK(best.batch_size == 256);
+        CHECK(best.num_runners == 3);
+        CHECK(best.decode_threads == 2);
+        CHECK(throughput.measured == Candidates{{128, 3}, {256, 3}});
+        CHECK(is_valid(best, num_threads, 3));
+    }
+
+    SECTION("decode threads are limited by the batch size") {
+        FakeThroughput throughput{{{4, 4.0}}, {{1, 1.0}, {2, 0.5}}};
+        const auto best = select_cpu_basecall_settings({4}, max_num_runners, 0, num_threads,
+                                                       std::ref(throughput));
+        CHECK(best.decode_threads == 4);
+        CHECK(is_valid(best, num_threads, 0));
+    }
+}
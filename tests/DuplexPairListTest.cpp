@@ -0,0 +1,138 @@
+#include "utils/duplex_pair_list.h"
+
+#include "TestUtils.h"
+
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+
+#define TEST_GROUP "[DuplexPairList]"
+
+namespace {
+
+constexpr auto kTemplate1 = "0f8c4e6b-1a2d-4b3c-9d8e-7f6a5b4c3d2e";
+constexpr auto kComplement1 = "1e2d3c4b-5a6f-4e8d-9c0b-a1b2c3d4e5f6";
+constexpr auto kTemplate2 = "2a3b4c5d-6e7f-4a8b-9c0d-e1f2a3b4c5d6";
+constexpr auto kComplement2 = "3b4c5d6e-7f8a-4b9c-8d0e-f1a2b3c4d5e6";
+
+std::string random_uuid(std::minstd_rand& rng) {
+    std::string uuid = "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx";
+    for (auto& c : uuid) {
+        if (c == 'x') {
+            c = "0123456789abcdef"[rng() % 16];
+        }
+    }
+    return uuid;
+}
+
+void check_partner(const dorado::utils::DuplexPairList& pair_list,
+                   const std::string& read_id,
+                   const std::string& expected_partner,
+                   bool expected_is_template) {
+    CAPTURE(read_id);
+    const auto partner = pair_list.find_partner(read_id);
+    REQUIRE(partner.has_value());
+    CHECK(partner->read_id == expected_partner);
+    CHECK(partner->read_is_template == expected_is_template);
+}
+
+}  // namespace
+
+TEST_CASE("Pairs file is loaded", TEST_GROUP) {
+    const auto temp_dir = make_temp_dir("duplex_pair_list");
+    const auto pairs_file = temp_dir.m_path / "pairs.txt";
+    {
+        std::ofstream pairs(pairs_file, std::ios::binary);
+        pairs << kTemplate1 << ' ' << kComplement1 << "\r\n"
+              << "not_a_pair\n"
+              << "template_read complement_read\n"
+              << "\n"
+              // The last line has no trailing newline.
+              << kTemplate2 << ' ' << kComplement2;
+    }
+
+    const auto pair_list = dorado::utils::DuplexPairList::load(pairs_file.string(), 4);
+    CHECK(pair_list.num_reads() == 6);
+    check_partner(pair_list, kTemplate1, kComplement1, true);
+    check_partner(pair_list, kComplement1, kTemplate1, false);
+    check_partner(pair_list, kTemplate2, kComplement2, true);
+    check_partner(pair_list, kComplement2, kTemplate2, false);
+    check_partner(pair_list, "template_read", "complement_read", true);
+    check_partner(pair_list, "complement_read", "template_read", false);
+
+    CHECK_FALSE(pair_list.find_partner("not_a_pair").has_value());
+    CHECK_FALSE(pair_list.find_partner("4c5d6e7f-8a9b-4c0d-9e1f-a2b3c4d5e6f7").has_value());
+    // Read ids are matched exactly, so an upper case UUID is a different read.
+    CHECK_FALSE(pair_list.find_partner("0F8C4E6B-1A2D-4B3C-9D8E-7F6A5B4C3D2E").has_value());
+}
+
+TEST_CASE("Missing pairs file throws", TEST_GROUP) {
+    const auto temp_dir = make_temp_dir("duplex_pair_list");
+    const auto pairs_file = temp_dir.m_path / "missing.txt";
+    CHECK_THROWS(dorado::utils::DuplexPairList::load(pairs_file.string(), 1));
+}
+
+TEST_CASE("Reads listed more than once", TEST_GROUP) {
+    const auto temp_dir = make_temp_dir("duplex_pair_list");
+    const auto pairs_file = temp_dir.m_path / "pairs.txt";
+    {
+        std::ofstream pairs(pairs_file);
+        // kTemplate1 is also the complement of a pair, and kComplement1 is the complement of
+        // two pairs.
+        pairs << kTemplate2 << ' ' << kTemplate1 << '\n'
+              << kTemplate1 << ' ' << kComplement1 << '\n'
+              << kComplement2 << ' ' << kComplement1 << '\n'
+              << "a b\n"
+              << "c a\n";
+    }
+
+    const auto pair_list = dorado::utils::DuplexPairList::load(pairs_file.string(), 1);
+    check_partner(pair_list, kTemplate1, kComplement1, true);
+    check_partner(pair_list, kComplement1, kComplement2, false);
+    check_partner(pair_list, kTemplate2, kTemplate1, true);
+    check_partner(pair_list, "a", "b", true);
+    check_partner(pair_list, "c", "a", true);
+}
+
+TEST_CASE("Pair list matches the template-complement map", TEST_GROUP) {
+    // Enough pairs for the file to be parsed on several threads.
+    std::minstd_rand rng(42);
+    std::map<std::string, std::string> template_complement_map;
+    for (int i = 0; i < 100000; ++i) {
+        template_complement_map[random_uuid(rng)] = random_uuid(rng);
+    }
+    template_complement_map["template_read"] = "complement_read";
+
+    const auto temp_dir = make_temp_dir("duplex_pair_list");
+    const auto pairs_file = temp_dir.m_path / "pairs.txt";
+    {
+        std::ofstream pairs(pairs_file);
+        for (const auto& [template_id, complement_id] : template_complement_map) {
+            pairs << template_id << ' ' << complement_id << '\n';
+        }
+    }
+
+    const size_t num_threads = GENERATE(1, 8);
+    CAPTURE(num_threads);
+    const auto loaded = dorado::utils::DuplexPairList::load(pairs_file.string(), num_threads);
+    const dorado::utils::DuplexPairList from_map(template_complement_map);
+    for (const auto* pair_list : {&loaded, &from_map}) {
+        CHECK(pair_list->num_reads() == 2 * template_complement_map.size());
+        size_t num_mismatched = 0;
+        for (const auto& [template_id, complement_id] : template_complement_map) {
+            const auto template_partner = pair_list->find_partner(template_id);
+            const auto complement_partner = pair_list->find_partner(complement_id);
+            if (!template_partner || template_partner->read_id != complement_id ||
+                !template_partner->read_is_template || !complement_partner ||
+                complement_partner->read_id != template_id ||
+                complement_partner->read_is_template) {
+                ++num_mismatched;
+            }
+        }
+        CHECK(num_mismatched == 0);
+    }
+}
@@ -0,0 +1,171 @@
+#include "utils/duplex_utils.h"
+
+#include <catch2/catch.hpp>
+#include <edlib.h>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define TEST_GROUP "[duplex_utils]"
+
+namespace {
+
+std::string random_sequence(std::minstd_rand& rng, size_t len) {
+    std::string seq(len, 'A');
+    for (auto& base : seq) {
+        base = "ACGT"[rng() % 4];
+    }
+    return seq;
+}
+
+// Applies num_edits random substitutions, insertions and deletions to seq.
+std::string mutate(std::minstd_rand& rng, std::string seq, size_t num_edits) {
+    for (size_t i = 0; i < num_edits && !seq.empty(); ++i) {
+        const size_t pos = rng() % seq.size();
+        switch (rng() % 3) {
+        case 0:
+            seq[pos] = "ACGT"[rng() % 4];
+            break;
+        case 1:
+            seq.insert(pos, 1, "ACGT"[rng() % 4]);
+            break;
+        default:
+            seq.erase(pos, 1);
+            break;
+        }
+    }
+    return seq;
+}
+
+int edlib_edit_distance(const std::string& query, const std::string& target) {
+    EdlibAlignResult result = edlibAlign(query.data(), int(query.size()), target.data(),
+                                         int(target.size()), edlibDefaultAlignConfig());
+    const int edit_distance = result.editDistance;
+    edlibFreeAlignResult(result);
+    return edit_distance;
+}
+
+// Checks that alignment takes query to target at the cost it claims.
+void check_alignment(const std::string& query,
+                     const std::string& target,
+                     const dorado::utils::GlobalAlignment& alignment) {
+    size_t query_pos = 0;
+    size_t target_pos = 0;
+    int cost = 0;
+    for (const auto op : alignment.alignment) {
+        if (op == EDLIB_EDOP_MATCH || op == EDLIB_EDOP_MISMATCH) {
+            REQUIRE(query_pos < query.size());
+            REQUIRE(target_pos < target.size());
+            CHECK((query[query_pos] == target[target_pos]) == (op == EDLIB_EDOP_MATCH));
+            cost += op == EDLIB_EDOP_MISMATCH;
+            ++query_pos;
+            ++target_pos;
+        } else if (op == EDLIB_EDOP_INSERT) {
+            ++cost;
+            ++query_pos;
+        } else {
+            REQUIRE(op == EDLIB_EDOP_DELETE);
+            ++cost;
+            ++target_pos;
+        }
+    }
+    CHECK(query_pos == query.size());
+    CHECK(target_pos == target.size());
+    CHECK(cost == alignment.edit_distance);
+}
+
+}  // namespace
+
+TEST_CASE(TEST_GROUP " global_alignment matches edlib", TEST_GROUP) {
+    std::minstd_rand rng(42);
+    for (int i = 0; i < 50; ++i) {
+        const auto query = random_sequence(rng, 100 + rng() % 5000);
+        auto target = mutate(rng, query, query.size() / 20);
+        // Trim the ends of some targets, as pairs don't always cover the same bases.
+        if (i % 3 == 0) {
+            target = target.substr(rng() % 50);
+        }
+        CAPTURE(i, query.size(), target.size());
+
+        const auto alignment = dorado::utils::global_alignment(query, target);
+        CHECK(alignment.edit_distance == edlib_edit_distance(query, target));
+        check_alignment(query, target, alignment);
+    }
+}
+
+TEST_CASE(TEST_GROUP " banded_global_alignment", TEST_GROUP) {
+    std::minstd_rand rng(7);
+    const auto query = random_sequence(rng, 1000);
+
+    SECTION("Empty sequences") {
+        const auto alignment = dorado::utils::banded_global_alignment(query, "", 1);
+        REQUIRE(alignment.has_value());
+        CHECK(alignment->edit_distance == 1000);
+        check_alignment(query, "", *alignment);
+    }
+
+    SECTION("Alignment within the band") {
+        const auto target = mutate(rng, query, 10);
+        const auto alignment = dorado::utils::banded_global_alignment(query, target, 32);
+        REQUIRE(alignment.has_value());
+        CHECK(alignment->edit_distance == edlib_edit_distance(query, target));
+        check_alignment(query, target, *alignment);
+    }
+
+    SECTION("Alignment leaving the band") {
+        // Shifting the target by more than the band means the best alignment can't be found.
+        const auto target = query.substr(100) + random_sequence(rng, 100);
+        CHECK_FALSE(dorado::utils::banded_global_alignment(query, target, 32).has_value());
+        const auto alignment = dorado::utils::global_alignment(query, target);
+        CHECK(alignment.edit_distance == edlib_edit_distance(query, target));
+        check_alignment(query, target, alignment);
+    }
+}
+
+TEST_CASE(TEST_GROUP " get_trimmed_alignment of sequences", TEST_GROUP) {
+    std::minstd_rand rng(11);
+    const auto query = random_sequence(rng, 1000);
+    auto target = query;
+    // Mismatches at 2 and 4 mean the first run of 11 matches starts at 5.
+    target[2] = target[2] == 'A' ? 'C' : 'A';
+    target[4] = target[4] == 'A' ? 'C' : 'A';
+
+    const auto trimmed = dorado::utils::get_trimmed_alignment(11, query, target);
+    check_alignment(query, target, trimmed.alignment);
+    CHECK(trimmed.alignment.edit_distance == 2);
+    CHECK(trimmed.start_alignment_position == 5);
+    CHECK(trimmed.end_alignment_position == 999);
+    CHECK(trimmed.query_cursor == 5);
+    CHECK(trimmed.target_cursor == 5);
+}
+
+TEST_CASE(TEST_GROUP " benchmark global alignment", "[!benchmark]" TEST_GROUP) {
+    std::minstd_rand rng(3);
+    const auto query = random_sequence(rng, 20000);
+    // Edit rates either side of a typical duplex pair, and a pair offset by more than the band,
+    // which pays for the banded attempt before falling back to edlib.
+    const std::pair<std::string, std::string> targets[] = {
+            {"1% edits", mutate(rng, query, 200)},
+            {"5% edits", mutate(rng, query, 1000)},
+            {"offset", query.substr(500) + random_sequence(rng, 500)},
+    };
+
+    for (const auto& name_and_target : targets) {
+        const auto& name = name_and_target.first;
+        const auto& target = name_and_target.second;
+        BENCHMARK("global_alignment " + name) {
+            return dorado::utils::global_alignment(query, target);
+        };
+        BENCHMARK("edlibAlign " + name) {
+            EdlibAlignConfig align_config = edlibDefaultAlignConfig();
+            align_config.task = EDLIB_TASK_PATH;
+            EdlibAlignResult result = edlibAlign(query.data(), int(query.size()), target.data(),
+                                                 int(target.size()), align_config);
+            const int edit_distance = result.editDistance;
+            edlibFreeAlignResult(result);
+            return edit_distance;
+        };
+    }
+}
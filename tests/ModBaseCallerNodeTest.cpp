@@ -0,0 +1,152 @@
+#include "read_pipeline/ModBaseCallerNode.h"
+
+#include "MessageSinkUtils.h"
+#include "TestUtils.h"
+#include "api/runner_creation.h"
+#include "models/models.h"
+#include "read_pipeline/DefaultClientInfo.h"
+#include "utils/dev_utils.h"
+
+#include <torch/torch.h>
+// Catch2 must come after torch since both define CHECK()
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_GROUP "[ModBaseCallerNode]"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr size_t kBatchSize = 8;
+constexpr int kModelStride = 6;
+// Each repeat is a CG hit for the 5mCG_5hmCG model and an A hit for the 6mA model.
+constexpr char kRepeat[] = "CGTA";
+constexpr size_t kRepeatsPerRead = 4;
+
+class ModBaseCallerNodeFixture {
+protected:
+    ModBaseCallerNodeFixture() {
+        for (const auto &model_name : {"dna_r10.4.1_e8.2_400bps_fast@v4.2.0_5mCG_5hmCG@v2",
+                                       "dna_r10.4.1_e8.2_400bps_sup@v4.2.0_6mA@v3"}) {
+            REQUIRE(dorado::models::download_models(m_model_dir.m_path.string(), model_name));
+            m_model_paths.push_back(m_model_dir.m_path / model_name);
+        }
+    }
+
+    ~ModBaseCallerNodeFixture() {
+        // Don't leave the batch age set for other tests.
+        dorado::utils::details::g_dev_options.erase("modbase_max_batch_age_ms");
+    }
+
+    void set_max_batch_age(std::chrono::milliseconds max_batch_age) {
+        dorado::utils::details::extract_dev_options("modbase_max_batch_age_ms=" +
+                                                    std::to_string(max_batch_age.count()));
+    }
+
+    void create_pipeline() {
+        // A single runner, so that every batch for a model goes through the same worker.
+        auto runners = dorado::api::create_modbase_runners(m_model_paths, "cpu", 1, kBatchSize);
+        REQUIRE(runners.front()->num_callers() == 2);
+
+        dorado::PipelineDescriptor pipeline_desc;
+        auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, m_messages);
+        m_modbase_node = pipeline_desc.add_node<dorado::ModBaseCallerNode>(
+                {sink}, std::move(runners), 2, kModelStride, 1000);
+        m_pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+    }
+
+    void push_read(int read_idx) {
+        auto read = std::make_unique<dorado::SimplexRead>();
+        auto &read_common = read->read_common;
+        for (size_t i = 0; i < kRepeatsPerRead; ++i) {
+            read_common.seq += kRepeat;
+        }
+        read_common.qstring = std::string(read_common.seq.size(), '*');
+        // One base per block of signal.
+        read_common.model_stride = kModelStride;
+        read_common.moves.assign(read_common.seq.size(), 1);
+        read_common.raw_data =
+                torch::randn({int64_t(read_common.seq.size() * kModelStride)}).to(torch::kHalf);
+        read_common.read_id = "read_" + std::to_string(read_idx);
+        read_common.client_info = std::make_shared<dorado::DefaultClientInfo>();
+        m_pipeline->push_message(std::move(read));
+    }
+
+    dorado::stats::NamedStats sample_stats() {
+        return m_pipeline->get_node_ref(m_modbase_node).sample_stats();
+    }
+
+    TempDir m_model_dir = make_temp_dir("modbase_caller_node");
+    std::vector<std::filesystem::path> m_model_paths;
+    std::vector<dorado::Message> m_messages;
+    dorado::NodeHandle m_modbase_node{};
+    std::unique_ptr<dorado::Pipeline> m_pipeline;
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(ModBaseCallerNodeFixture,
+                 TEST_GROUP " chunks from several reads and models are packed into full batches",
+                 TEST_GROUP) {
+    // Partial batches would only be called when the pipeline is flushed.
+    set_max_batch_age(1h);
+    create_pipeline();
+
+    // Each read has half a batch of chunks for each model.
+    constexpr int num_reads = 6;
+    for (int i = 0; i < num_reads; ++i) {
+        push_read(i);
+    }
+    m_pipeline->terminate(dorado::DefaultFlushOptions());
+
+    const auto stats = sample_stats();
+    constexpr size_t chunks_per_model = num_reads * kRepeatsPerRead;
+    CHECK(stats.at("context_hits") == double(2 * chunks_per_model));
+    CHECK(stats.at("chunks_called") == double(2 * chunks_per_model));
+    CHECK(stats.at("batches_called") == double(2 * chunks_per_model / kBatchSize));
+    CHECK(stats.at("partial_batches_called") == 0);
+    CHECK(stats.at("batch_fill_ratio") == 1.0);
+    CHECK(stats.at("mod_base_reads_pushed") == num_reads);
+
+    m_pipeline.reset();
+    REQUIRE(m_messages.size() == num_reads);
+    for (auto &message : m_messages) {
+        const auto &read_common = std::get<dorado::SimplexReadPtr>(message)->read_common;
+        CHECK(!read_common.dense_base_mod_probs().empty());
+    }
+}
+
+TEST_CASE_METHOD(ModBaseCallerNodeFixture,
+                 TEST_GROUP " partial batches are called once they are too old",
+                 TEST_GROUP) {
+    constexpr auto max_batch_age = 200ms;
+    set_max_batch_age(max_batch_age);
+    create_pipeline();
+
+    // Half a batch of chunks for each model, and nothing more to fill them.
+    const auto start = std::chrono::steady_clock::now();
+    push_read(0);
+    while (sample_stats().at("mod_base_reads_pushed") < 1 &&
+           std::chrono::steady_clock::now() - start < 30s) {
+        std::this_thread::sleep_for(1ms);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // The read came out without the pipeline being flushed, but not before its chunks were old.
+    const auto stats = sample_stats();
+    REQUIRE(stats.at("mod_base_reads_pushed") == 1);
+    CHECK(elapsed >= max_batch_age);
+    CHECK(stats.at("batches_called") == 2);
+    CHECK(stats.at("partial_batches_called") == 2);
+    CHECK(stats.at("chunks_called") == double(2 * kRepeatsPerRead));
+
+    m_pipeline->terminate(dorado::DefaultFlushOptions());
+    m_pipeline.reset();
+    CHECK(m_messages.size() == 1);
+}
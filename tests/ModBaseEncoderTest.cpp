@@ -4,6 +4,8 @@
 
 #include <catch2/catch.hpp>
 
+#include <random>
+
 #define TEST_GROUP "[modbase_encoder]"
 
 TEST_CASE("Encode sequence for modified basecalling", TEST_GROUP) {
@@ -91,3 +93,34 @@ TEST_CASE("Encode sequence for modified basecalling", TEST_GROUP) {
     // clang-format on    
     CHECK(expected_slice2 == slice2.data);
 }
+
+TEST_CASE("Encode kmers of every length", TEST_GROUP) {
+    // Covers every number of vectors per kmer row, and the generic fallback beyond that.
+    const int MAX_BASES_EITHER_SIDE = 20;
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> base_dist(-1, 3);
+    std::uniform_int_distribution<int> samples_dist(0, 12);
+
+    for (int bases_before = 0; bases_before <= MAX_BASES_EITHER_SIDE; ++bases_before) {
+        for (int bases_after = 0; bases_after <= MAX_BASES_EITHER_SIDE; ++bases_after) {
+            CAPTURE(bases_before, bases_after);
+            for (int seq_len : {1, 2, 7, 33}) {
+                std::vector<int> seq(seq_len + bases_before + bases_after);
+                for (auto& base : seq) {
+                    base = base_dist(gen);
+                }
+                std::vector<int> seq_mappings(seq_len + 1, 0);
+                for (int i = 1; i <= seq_len; ++i) {
+                    seq_mappings[i] = seq_mappings[i - 1] + samples_dist(gen);
+                }
+                const int context_samples = seq_mappings.back();
+
+                auto expected = dorado::modbase::details::encode_kmer_generic(
+                        seq, seq_mappings, bases_before, bases_after, context_samples);
+                auto encoded = dorado::modbase::details::encode_kmer(
+                        seq, seq_mappings, bases_before, bases_after, context_samples);
+                CHECK(encoded == expected);
+            }
+        }
+    }
+}
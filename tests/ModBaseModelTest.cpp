@@ -0,0 +1,216 @@
+#include "MessageSinkUtils.h"
+#include "TestUtils.h"
+#include "api/pipeline_creation.h"
+#include "api/runner_creation.h"
+#include "basecall/CRFModelConfig.h"
+#include "data_loader/DataLoader.h"
+#include "models/models.h"
+#include "modbase/ModBaseModelConfig.h"
+#include "modbase/nn/ModBaseModel.h"
+#include "utils/dev_utils.h"
+#include "utils/sequence_utils.h"
+
+#include <torch/torch.h>
+// Catch2 must come after torch since both define CHECK()
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define CUT_TAG "[ModBaseModel]"
+
+// Not introduced until catch2 3.3.0
+#ifndef SKIP
+#define SKIP(msg)                                      \
+    do {                                               \
+        std::cerr << "Skipping test: " << msg << '\n'; \
+        return;                                        \
+    } while (false)
+#endif
+
+namespace {
+
+bool has_quantized_engine() {
+    const auto& engines = at::globalContext().supportedQEngines();
+    return std::any_of(engines.begin(), engines.end(),
+                       [](at::QEngine engine) { return engine != at::QEngine::NoQEngine; });
+}
+
+// Basecalls the single read test file on the CPU and calls its modified bases, with int8 modbase
+// inference if quantize is set. Returns the sequence and modified base probabilities of each
+// read, by read ID.
+std::map<std::string, std::pair<std::string, std::vector<uint8_t>>> call_test_reads(
+        const std::filesystem::path& model_path,
+        const std::filesystem::path& modbase_model_path,
+        bool quantize) {
+    auto model_config = dorado::basecall::load_crf_model_config(model_path);
+    model_config.basecaller.set_batch_size(8);
+    model_config.normalise_basecaller_params();
+    auto [runners, num_devices] = dorado::api::create_basecall_runners(
+            model_config, "cpu", 1, 1, 1.f, dorado::api::PipelineType::simplex, 0.f);
+
+    if (quantize) {
+        dorado::utils::details::extract_dev_options("modbase_cpu_int8=1");
+    }
+    auto modbase_runners = dorado::api::create_modbase_runners({modbase_model_path}, "cpu", 1, 32);
+    dorado::utils::details::g_dev_options.erase("modbase_cpu_int8");
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    dorado::api::create_simplex_pipeline(pipeline_desc, std::move(runners),
+                                         std::move(modbase_runners), 1, false, 1, false, 1, 1, sink,
+                                         dorado::PipelineDescriptor::InvalidNodeHandle);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+    dorado::DataLoader loader(*pipeline, "cpu", 1, 0, std::nullopt, {});
+    loader.load_reads(get_single_pod5_file_path(), false, dorado::ReadOrder::UNRESTRICTED);
+    pipeline.reset();
+
+    std::map<std::string, std::pair<std::string, std::vector<uint8_t>>> reads;
+    for (auto& read : ConvertMessages<dorado::SimplexReadPtr>(std::move(messages))) {
+        const auto& read_common = read->read_common;
+        reads[read_common.read_id] = {read_common.seq, read_common.dense_base_mod_probs()};
+    }
+    return reads;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": int8 linear matches fp32", CUT_TAG) {
+    if (!has_quantized_engine()) {
+        SKIP("No quantized engine available");
+    }
+    torch::manual_seed(1);
+    at::InferenceMode guard;
+
+    torch::nn::Linear linear(96, 64);
+    dorado::modbase::nn::DynamicQuantizedLinear int8_linear(linear->weight, linear->bias);
+
+    const auto x = torch::randn({3, 50, 96});
+    const auto expected = linear(x);
+    const auto actual = int8_linear.forward(x);
+    REQUIRE(actual.sizes() == expected.sizes());
+    CHECK(torch::allclose(actual, expected, 0.05, 0.05));
+}
+
+TEST_CASE(CUT_TAG ": int8 unpadded convolution matches fp32", CUT_TAG) {
+    if (!has_quantized_engine()) {
+        SKIP("No quantized engine available");
+    }
+    torch::manual_seed(2);
+    at::InferenceMode guard;
+
+    dorado::modbase::nn::UnpaddedConvolution conv(16, 64, 9, 3);
+    const auto x = torch::randn({4, 16, 100});
+    const auto expected = conv(x);
+    conv->quantize();
+    REQUIRE(conv->int8_conv.has_value());
+    const auto actual = conv(x);
+    REQUIRE(actual.sizes() == expected.sizes());
+    CHECK(torch::allclose(actual, expected, 0.05, 0.05));
+
+    // Too few inputs per output for int8 to pay off, so it stays in fp32.
+    dorado::modbase::nn::UnpaddedConvolution small_conv(1, 4, 11, 1);
+    small_conv->quantize();
+    CHECK_FALSE(small_conv->int8_conv.has_value());
+}
+
+TEST_CASE(CUT_TAG ": int8 modified base calls of the test reads match fp32", CUT_TAG) {
+    if (!has_quantized_engine()) {
+        SKIP("No quantized engine available");
+    }
+    const char model_name[] = "dna_r10.4.1_e8.2_400bps_fast@v4.1.0";
+    const char modbase_model_name[] = "dna_r10.4.1_e8.2_400bps_fast@v4.1.0_5mCG_5hmCG@v2";
+    auto temp_dir = make_temp_dir("model");
+    REQUIRE(dorado::models::download_models(temp_dir.m_path.string(), model_name));
+    REQUIRE(dorado::models::download_models(temp_dir.m_path.string(), modbase_model_name));
+
+    const auto fp32_reads = call_test_reads(temp_dir.m_path / model_name,
+                                            temp_dir.m_path / modbase_model_name, false);
+    const auto int8_reads = call_test_reads(temp_dir.m_path / model_name,
+                                            temp_dir.m_path / modbase_model_name, true);
+    REQUIRE(!fp32_reads.empty());
+    REQUIRE(int8_reads.size() == fp32_reads.size());
+
+    // Compare the probabilities at each CpG, where the model calls, in units of 1/255.
+    int max_delta = 0;
+    int64_t total_delta = 0;
+    size_t num_entries = 0;
+    size_t num_sites = 0;
+    size_t num_same_calls = 0;
+    for (const auto& [read_id, fp32_read] : fp32_reads) {
+        CAPTURE(read_id);
+        const auto& int8_read = int8_reads.at(read_id);
+        const auto& seq = fp32_read.first;
+        REQUIRE(int8_read.first == seq);
+        const auto& fp32_probs = fp32_read.second;
+        const auto& int8_probs = int8_read.second;
+        REQUIRE(fp32_probs.size() == int8_probs.size());
+        REQUIRE(fp32_probs.size() % seq.size() == 0);
+        const size_t num_states = fp32_probs.size() / seq.size();
+
+        for (size_t pos = 0; pos + 1 < seq.size(); ++pos) {
+            if (seq[pos] != 'C' || seq[pos + 1] != 'G') {
+                continue;
+            }
+            const auto fp32_row = fp32_probs.begin() + pos * num_states;
+            const auto int8_row = int8_probs.begin() + pos * num_states;
+            for (size_t i = 0; i < num_states; ++i) {
+                const int delta = std::abs(int(fp32_row[i]) - int(int8_row[i]));
+                max_delta = std::max(max_delta, delta);
+                total_delta += delta;
+                ++num_entries;
+            }
+            ++num_sites;
+            num_same_calls +=
+                    std::max_element(fp32_row, fp32_row + num_states) - fp32_row ==
+                    std::max_element(int8_row, int8_row + num_states) - int8_row;
+        }
+    }
+    REQUIRE(num_sites > 0);
+    const float mean_delta = float(total_delta) / float(num_entries) / 255.f;
+    const float same_call = float(num_same_calls) / float(num_sites);
+    WARN("int8 vs fp32 over " << num_sites << " CpGs: max probability delta "
+                              << float(max_delta) / 255.f << ", mean delta " << mean_delta
+                              << ", same call at " << same_call * 100 << "% of sites");
+    CHECK(mean_delta < 0.02f);
+    CHECK(same_call >= 0.95f);
+}
+
+TEST_CASE(CUT_TAG ": benchmark int8 CPU inference", "[!benchmark]" CUT_TAG) {
+    if (!has_quantized_engine()) {
+        SKIP("No quantized engine available");
+    }
+    const char model_name[] = "dna_r10.4.1_e8.2_400bps_fast@v4.2.0_5mCG_5hmCG@v2";
+    auto temp_dir = make_temp_dir("model");
+    REQUIRE(dorado::models::download_models(temp_dir.m_path.string(), model_name));
+    const auto model_path = temp_dir.m_path / model_name;
+
+    at::InferenceMode guard;
+    const auto options = at::TensorOptions().device(torch::kCPU).dtype(torch::kFloat32);
+    auto fp32_model = dorado::modbase::load_modbase_model(model_path, options, false);
+    auto int8_model = dorado::modbase::load_modbase_model(model_path, options, true);
+
+    // Normalised signal and random one-hot encoded kmers. The accuracy of int8 is checked on real
+    // reads above, so this only times it.
+    const auto params = dorado::modbase::load_modbase_model_config(model_path);
+    const int64_t batch_size = 128;
+    const auto sig_len = int64_t(params.context_before + params.context_after);
+    const auto kmer_len = int64_t(params.bases_before + params.bases_after + 1);
+    torch::manual_seed(3);
+    const auto sigs = torch::randn({batch_size, 1, sig_len});
+    const auto bases = torch::randint(dorado::utils::BaseInfo::NUM_BASES,
+                                      {batch_size, sig_len, kmer_len}, torch::kLong);
+    const auto seqs = torch::one_hot(bases, dorado::utils::BaseInfo::NUM_BASES)
+                              .flatten(2)
+                              .to(torch::kInt8);
+
+    BENCHMARK("fp32") { return fp32_model->forward(sigs, seqs); };
+    BENCHMARK("int8") { return int8_model->forward(sigs, seqs); };
+}
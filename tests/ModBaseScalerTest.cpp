@@ -0,0 +1,114 @@
+#include "modbase/ModbaseScaler.h"
+
+#include <torch/torch.h>
+// Catch2 must come after torch since both define CHECK()
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+
+#define CUT_TAG "[ModBaseScaler]"
+
+namespace {
+
+// Levels for every kmer of kmer_len bases, indexed with the first base most significant.
+std::vector<float> make_kmer_levels(size_t kmer_len) {
+    std::minstd_rand rng(kmer_len);
+    std::uniform_real_distribution<float> dist(-2.f, 2.f);
+    std::vector<float> kmer_levels(size_t(1) << (2 * kmer_len));
+    for (auto& level : kmer_levels) {
+        level = dist(rng);
+    }
+    return kmer_levels;
+}
+
+std::vector<int> make_seq_ints(size_t length, unsigned seed) {
+    std::minstd_rand rng(seed);
+    std::vector<int> seq_ints(length);
+    for (auto& base : seq_ints) {
+        base = int(rng() % 4);
+    }
+    return seq_ints;
+}
+
+// The kmer index computed independently at each position.
+std::vector<float> reference_levels(const std::vector<float>& kmer_levels,
+                                    const std::vector<int>& seq_ints,
+                                    size_t kmer_len,
+                                    size_t centre_index) {
+    std::vector<float> levels(seq_ints.size(), 0.f);
+    if (seq_ints.size() < kmer_len) {
+        return levels;
+    }
+    for (size_t pos = 0; pos < seq_ints.size() - kmer_len; ++pos) {
+        size_t index = 0;
+        for (size_t kmer_pos = 0; kmer_pos < kmer_len; ++kmer_pos) {
+            index += size_t(seq_ints[pos + kmer_len - kmer_pos - 1]) << (2 * kmer_pos);
+        }
+        levels[pos + centre_index] = kmer_levels[index];
+    }
+    return levels;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": extract_levels matches per-kmer indexing", CUT_TAG) {
+    auto kmer_len = GENERATE(size_t(1), size_t(4), size_t(9));
+    auto seq_len = GENERATE(size_t(0), size_t(3), size_t(9), size_t(10), size_t(1000));
+    CAPTURE(kmer_len, seq_len);
+
+    const auto kmer_levels = make_kmer_levels(kmer_len);
+    const size_t centre_index = kmer_len / 2;
+    dorado::modbase::ModBaseScaler scaler(kmer_levels, kmer_len, centre_index);
+
+    const auto seq_ints = make_seq_ints(seq_len, unsigned(seq_len));
+    CHECK(scaler.extract_levels(seq_ints) ==
+          reference_levels(kmer_levels, seq_ints, kmer_len, centre_index));
+}
+
+TEST_CASE(CUT_TAG ": scale_samples matches libtorch", CUT_TAG) {
+    torch::manual_seed(1);
+    // Lengths either side of the vector width.
+    auto num_samples = GENERATE(0, 1, 7, 8, 9, 4001);
+    CAPTURE(num_samples);
+    const float scale = 1.3f;
+    const float offset = -0.2f;
+
+    const auto signal = torch::randn({num_samples}).to(torch::kHalf);
+    auto scaled = torch::empty_like(signal);
+    dorado::modbase::details::scale_samples(scaled.data_ptr<c10::Half>(),
+                                            signal.data_ptr<c10::Half>(), size_t(num_samples),
+                                            scale, offset);
+
+    // libtorch's half arithmetic rounds to half after each op, so the results can be 1ulp apart.
+    const auto expected = signal * scale + offset;
+    CHECK(torch::allclose(scaled.to(torch::kFloat), expected.to(torch::kFloat), 1e-3, 1e-3));
+}
+
+TEST_CASE(CUT_TAG ": benchmark level extraction and scaling", "[!benchmark]" CUT_TAG) {
+    const size_t kmer_len = 9;
+    const size_t centre_index = 4;
+    const auto kmer_levels = make_kmer_levels(kmer_len);
+    dorado::modbase::ModBaseScaler scaler(kmer_levels, kmer_len, centre_index);
+
+    // A typical read: 10kb called at 6 samples per base.
+    const auto seq_ints = make_seq_ints(10000, 42);
+    torch::manual_seed(2);
+    const auto signal = torch::randn({int64_t(seq_ints.size() * 6)}).to(torch::kHalf);
+    const float scale = 1.3f;
+    const float offset = -0.2f;
+
+    BENCHMARK("extract_levels per-kmer index (before)") {
+        return reference_levels(kmer_levels, seq_ints, kmer_len, centre_index);
+    };
+    BENCHMARK("extract_levels rolling index (after)") { return scaler.extract_levels(seq_ints); };
+
+    BENCHMARK("scale libtorch ops (before)") { return signal * scale + offset; };
+    BENCHMARK("scale_samples (after)") {
+        auto scaled = torch::empty_like(signal);
+        dorado::modbase::details::scale_samples(scaled.data_ptr<c10::Half>(),
+                                                signal.data_ptr<c10::Half>(),
+                                                size_t(signal.numel()), scale, offset);
+        return scaled;
+    };
+}
@@ -0,0 +1,154 @@
+#include "TestUtils.h"
+#include "basecall/CRFModelConfig.h"
+#include "basecall/ModelRunner.h"
+#include "basecall/crf_utils.h"
+#include "basecall/decode/Decoder.h"
+#include "models/models.h"
+
+#include <torch/torch.h>
+// Catch2 must come after torch since both define CHECK()
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <future>
+#include <vector>
+
+#define TEST_GROUP "[ModelRunner]"
+
+using namespace std::chrono_literals;
+using dorado::basecall::ModelRunner;
+using dorado::basecall::decode::DecodedChunk;
+
+namespace {
+
+constexpr char kModelName[] = "dna_r10.4.1_e8.2_400bps_fast@v4.2.0";
+constexpr int kBatchSize = 4;
+constexpr int kChunkSize = 600;
+constexpr size_t kNumInputSlabs = 3;
+
+class ModelRunnerFixture {
+protected:
+    ModelRunnerFixture() {
+        REQUIRE(dorado::models::download_models(m_model_dir.m_path.string(), kModelName));
+        m_config = dorado::basecall::load_crf_model_config(m_model_dir.m_path / kModelName);
+        m_config.basecaller.set_batch_size(kBatchSize);
+        m_config.basecaller.set_chunk_size(kChunkSize);
+        m_config.normalise_basecaller_params();
+
+        // Distinct chunks for each batch, with the last one partly filled.
+        torch::manual_seed(42);
+        const int chunk_size = m_config.basecaller.chunk_size();
+        for (int i = 0; i < 5; ++i) {
+            m_batches.push_back(torch::randn({kBatchSize, m_config.num_features, chunk_size}));
+        }
+        m_num_chunks = {kBatchSize, kBatchSize, kBatchSize, kBatchSize, kBatchSize - 1};
+    }
+
+    void stage(ModelRunner &runner, size_t batch_idx) {
+        for (int i = 0; i < m_num_chunks[batch_idx]; ++i) {
+            runner.accept_chunk(i, m_batches[batch_idx][i]);
+        }
+    }
+
+    // Results of calling each batch on a runner with a single slab.
+    std::vector<std::vector<DecodedChunk>> call_synchronously() {
+        ModelRunner runner(m_config, "cpu", 2, 1);
+        std::vector<std::vector<DecodedChunk>> results;
+        for (size_t i = 0; i < m_batches.size(); ++i) {
+            stage(runner, i);
+            results.push_back(runner.call_chunks(m_num_chunks[i]));
+        }
+        return results;
+    }
+
+    static void check_equal(const std::vector<DecodedChunk> &results,
+                            const std::vector<DecodedChunk> &expected) {
+        REQUIRE(results.size() == expected.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            CAPTURE(i);
+            CHECK(results[i].sequence == expected[i].sequence);
+            CHECK(results[i].qstring == expected[i].qstring);
+            CHECK(results[i].moves == expected[i].moves);
+        }
+    }
+
+    TempDir m_model_dir = make_temp_dir("model_runner");
+    dorado::basecall::CRFModelConfig m_config;
+    std::vector<at::Tensor> m_batches;
+    std::vector<int> m_num_chunks;
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(ModelRunnerFixture,
+                 TEST_GROUP " batches in flight in several slabs match the single slab path",
+                 TEST_GROUP) {
+    const auto expected = call_synchronously();
+
+    ModelRunner runner(m_config, "cpu", 2, kNumInputSlabs);
+    REQUIRE(runner.num_input_slabs() == kNumInputSlabs);
+    // Stage and start every batch before collecting any results, so that each slab is used more
+    // than once.
+    std::vector<std::future<std::vector<DecodedChunk>>> results;
+    for (size_t i = 0; i < m_batches.size(); ++i) {
+        stage(runner, i);
+        results.push_back(runner.call_chunks_async(m_num_chunks[i]));
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+        CAPTURE(i);
+        check_equal(results[i].get(), expected[i]);
+    }
+
+    // The synchronous call goes through the same slabs.
+    stage(runner, 0);
+    check_equal(runner.call_chunks(m_num_chunks[0]), expected[0]);
+
+    const auto stats = runner.sample_stats();
+    CHECK(stats.at("batches_called") == double(m_batches.size() + 1));
+    CHECK(stats.at("forward_decode_overlap_ratio") >= 0.0);
+}
+
+TEST_CASE_METHOD(ModelRunnerFixture,
+                 TEST_GROUP " slabs are not reused before their batch is decoded",
+                 TEST_GROUP) {
+    const auto expected = call_synchronously();
+
+    ModelRunner runner(m_config, "cpu", 2, kNumInputSlabs);
+    std::vector<std::future<std::vector<DecodedChunk>>> results;
+    for (size_t i = 0; i < kNumInputSlabs; ++i) {
+        stage(runner, i);
+        results.push_back(runner.call_chunks_async(m_num_chunks[i]));
+    }
+
+    // Every slab is in flight, so staging the next batch waits for the first one to be decoded,
+    // and doesn't change its results.
+    runner.accept_chunk(0, m_batches[kNumInputSlabs][0]);
+    CHECK(results[0].wait_for(0s) == std::future_status::ready);
+    check_equal(results[0].get(), expected[0]);
+
+    stage(runner, kNumInputSlabs);
+    results.push_back(runner.call_chunks_async(m_num_chunks[kNumInputSlabs]));
+    for (size_t i = 1; i < results.size(); ++i) {
+        CAPTURE(i);
+        check_equal(results[i].get(), expected[i]);
+    }
+}
+
+TEST_CASE_METHOD(ModelRunnerFixture, TEST_GROUP " runners sharing one model", TEST_GROUP) {
+    const auto expected = call_synchronously();
+
+    const auto dtype = dorado::basecall::decode::create_decoder(c10::Device(c10::kCPU), m_config)
+                               ->dtype();
+    const auto module = dorado::basecall::load_crf_model(
+            m_config, at::TensorOptions().dtype(dtype).device(at::kCPU));
+    ModelRunner runner_a(m_config, "cpu", module, 2, kNumInputSlabs);
+    ModelRunner runner_b(m_config, "cpu", module, 2, 1);
+    for (size_t i = 0; i < m_batches.size(); ++i) {
+        CAPTURE(i);
+        stage(runner_a, i);
+        auto results_a = runner_a.call_chunks_async(m_num_chunks[i]);
+        stage(runner_b, i);
+        check_equal(runner_b.call_chunks(m_num_chunks[i]), expected[i]);
+        check_equal(results_a.get(), expected[i]);
+    }
+}
@@ -46,3 +46,30 @@ TEST_CASE(TEST_GROUP ": test motifs", TEST_GROUP) {
     auto hits = matcher.get_motif_hits(SEQ);
     CHECK(hits == expected_results);
 }
+
+TEST_CASE(TEST_GROUP ": test multiple motifs in one pass", TEST_GROUP) {
+    const std::vector<std::string> motifs{"CG", "C", "AA", "TAC", "DRACH"};
+    const std::vector<size_t> offsets{0, 0, 1, 2, 2};
+    dorado::modbase::MotifMatcher matcher(motifs, offsets);
+    auto hits = matcher.get_all_motif_hits(SEQ);
+
+    REQUIRE(hits.size() == motifs.size());
+    CHECK(hits[0] == std::vector<size_t>{3, 9});
+    CHECK(hits[1] == std::vector<size_t>{2, 3, 9, 15, 19, 21});
+    CHECK(hits[2] == std::vector<size_t>{1, 24, 25});
+    CHECK(hits[3] == std::vector<size_t>{9});
+    CHECK(hits[4] == std::vector<size_t>{14, 18});
+}
+
+TEST_CASE(TEST_GROUP ": test motifs spanning several state words", TEST_GROUP) {
+    // Long enough that each motif needs its own 64 bit state word.
+    const std::string long_motif = std::string(40, 'N') + "CG";
+    dorado::modbase::MotifMatcher matcher({long_motif, long_motif, "CG"}, {40, 41, 0});
+    const std::string seq = std::string(40, 'A') + "CGTTCG";
+    auto hits = matcher.get_all_motif_hits(seq);
+
+    REQUIRE(hits.size() == 3);
+    CHECK(hits[0] == std::vector<size_t>{40, 44});
+    CHECK(hits[1] == std::vector<size_t>{41, 45});
+    CHECK(hits[2] == std::vector<size_t>{40, 44});
+}
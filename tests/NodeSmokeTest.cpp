@@ -35,6 +35,7 @@
 #include <filesystem>
 #include <functional>
 #include <random>
+#include <string>
 
 #ifndef _WIN32
 #include <unistd.h>
@@ -228,6 +229,46 @@ DEFINE_TEST(NodeSmokeTestRead, "BasecallerNode") {
                                            1000, "BasecallerNode", 0);
 }
 
+DEFINE_TEST(NodeSmokeTestRead, "BasecallerNode with extra CPU chunk sizes") {
+    // BasecallerNode will skip reads that have already been basecalled.
+    set_read_mutator([](dorado::SimplexReadPtr& read) { read->read_common.seq.clear(); });
+    // CPU processing is very slow, so reduce the number of test reads we throw at it.
+    set_num_reads(5);
+    set_expected_messages(5);
+
+    const char model_name[] = "dna_r10.4.1_e8.2_400bps_fast@v4.2.0";
+    const auto model_dir = download_model(model_name);
+    auto model_config = dorado::basecall::load_crf_model_config(model_dir.m_path / model_name);
+    model_config.basecaller.set_batch_size(8);
+    model_config.normalise_basecaller_params();
+
+    // An unnormalised size, one which is too small to use, and a duplicate.
+    const size_t stride = model_config.stride_inner();
+    const auto extra_chunk_sizes = std::to_string(300 * stride + 1) + ";10;" +
+                                   std::to_string(600 * stride) + ";" +
+                                   std::to_string(300 * stride);
+    auto [runners, num_devices] = [&] {
+        const ScopedEnvVar extra_chunk_sizes_var("DORADO_EXTRA_CHUNK_SIZES", extra_chunk_sizes);
+        return dorado::api::create_basecall_runners(model_config, "cpu", 0, 2, 1.f,
+                                                    dorado::api::PipelineType::simplex, 0.f);
+    }();
+    CHECK(num_devices == 1);
+
+    // Each runner has a copy for every chunk size, largest first.
+    const size_t chunk_size = model_config.basecaller.chunk_size();
+    std::vector<size_t> chunk_sizes;
+    for (const auto& runner : runners) {
+        chunk_sizes.push_back(runner->chunk_size());
+    }
+    const std::vector<size_t> expected{chunk_size, 600 * stride, 300 * stride,
+                                       chunk_size, 600 * stride, 300 * stride};
+    CHECK(chunk_sizes == expected);
+
+    run_smoke_test<dorado::BasecallerNode>(std::move(runners),
+                                           dorado::utils::default_parameters.overlap, model_name,
+                                           1000, "BasecallerNode", 0);
+}
+
 DEFINE_TEST(NodeSmokeTestRead, "ModBaseCallerNode") {
     auto gpu = GENERATE(true, false);
     CAPTURE(gpu);
@@ -10,6 +10,11 @@
 #include <catch2/catch.hpp>
 
 #include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #define TEST_GROUP "[PairingNodeTest]"
 
@@ -45,6 +50,39 @@ auto make_read(int delay_ms, size_t seq_len) {
     return make_read(delay_ms, std::string(seq_len, 'A'));
 }
 
+std::string pore_read_id(int pore, int idx) {
+    return "pore_" + std::to_string(pore) + "_read_" + std::to_string(idx);
+}
+
+// Pushes a template with |temp_seq| and then a complement with |comp_seq| from each of |num_pores|
+// pores through a PairingNode, and returns every message it emits.
+std::vector<dorado::Message> pair_pore_reads(const dorado::DuplexPairingParameters& pairing_params,
+                                             int num_worker_threads,
+                                             int num_pores,
+                                             const std::string& temp_seq,
+                                             const std::string& comp_seq) {
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 1000, messages);
+    pipeline_desc.add_node<dorado::PairingNode>({sink}, pairing_params, num_worker_threads, 1000);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    for (int pore = 0; pore < num_pores; ++pore) {
+        auto temp = make_read(0, temp_seq);
+        auto comp = make_read(2550, comp_seq);
+        temp->read_common.attributes.channel_number = pore;
+        comp->read_common.attributes.channel_number = pore;
+        temp->read_common.read_id = pore_read_id(pore, 0);
+        comp->read_common.read_id = pore_read_id(pore, 1);
+        temp->next_read = comp->read_common.read_id;
+        comp->prev_read = temp->read_common.read_id;
+        pipeline->push_message(std::move(temp));
+        pipeline->push_message(std::move(comp));
+    }
+    pipeline.reset();
+    return messages;
+}
+
 }  // namespace
 
 TEST_CASE("Split read pairing", TEST_GROUP) {
@@ -68,20 +106,46 @@ TEST_CASE("Split read pairing", TEST_GROUP) {
             make_read(27500, seq_rc)  // truncated reverse complement of {5}
     };
 
+    // Pairing doesn't depend on whether there's room to keep the overlap indexes.
+    const size_t max_overlap_index_bytes =
+            GENERATE(as<size_t>{}, dorado::DEFAULT_MAX_OVERLAP_INDEX_BYTES, 0);
+    CAPTURE(max_overlap_index_bytes);
+
     dorado::PipelineDescriptor pipeline_desc;
     std::vector<dorado::Message> messages;
     auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 5, messages);
     // one thread, one read - force reads through in order
-    pipeline_desc.add_node<dorado::PairingNode>(
+    auto pairing_node = pipeline_desc.add_node<dorado::PairingNode>(
             {sink},
             dorado::DuplexPairingParameters{dorado::ReadOrder::BY_CHANNEL,
-                                            dorado::DEFAULT_DUPLEX_CACHE_DEPTH},
+                                            dorado::DEFAULT_DUPLEX_CACHE_DEPTH, 0, "",
+                                            max_overlap_index_bytes},
             1, 1);
     auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
 
     for (auto& read : reads) {
         pipeline->push_message(std::move(read));
     }
+    pipeline->terminate(dorado::DefaultFlushOptions());
+
+    // Each read is a candidate to pair with the one before it.
+    const auto stats = pipeline->get_node_ref(pairing_node).sample_stats();
+    CHECK(stats.at("candidate_pairs") == 6);
+    CHECK(stats.at("time_rejected_pairs") == 1);
+    CHECK(stats.at("length_or_qscore_rejected_pairs") == 2);
+    CHECK(stats.at("non_adjacent_pairs") + stats.at("time_rejected_pairs") +
+                  stats.at("length_or_qscore_rejected_pairs") + stats.at("early_accepted_pairs") +
+                  stats.at("overlap_accepted_pairs") + stats.at("overlap_rejected_pairs") ==
+          stats.at("candidate_pairs"));
+    CHECK(stats.at("overlap_count") ==
+          stats.at("overlap_accepted_pairs") + stats.at("overlap_rejected_pairs"));
+    CHECK(stats.at("pore_evicted_reads") == 0);
+    CHECK(stats.at("depth_evicted_reads") == 0);
+    CHECK(stats.at("overlap_indexes_built") > 0);
+    CHECK(stats.at("uncached_overlap_indexes") ==
+          (max_overlap_index_bytes == 0 ? stats.at("overlap_indexes_built") : 0));
+    // The indexes were freed along with the reads when the cache was flushed.
+    CHECK(stats.at("cached_overlap_index_mb") == 0);
     pipeline.reset();
 
     // the 4 split reads generate one additional readpair
@@ -97,3 +161,142 @@ TEST_CASE("Split read pairing", TEST_GROUP) {
             });
     CHECK(num_pairs == 2);
 }
+
+TEST_CASE("Pairing across many pores and threads", TEST_GROUP) {
+    // Each pore gets a pair of equal length reads 50ms apart, which are accepted without mapping.
+    const int num_pores = 64;
+    const auto read_order = GENERATE(dorado::ReadOrder::BY_CHANNEL, dorado::ReadOrder::BY_TIME);
+    const int num_worker_threads = GENERATE(1, 2, 4, 8);
+    CAPTURE(dorado::to_string(read_order), num_worker_threads);
+
+    // The cache has room for every pore and read, so nothing is evicted before its partner
+    // arrives, whichever order the workers take the reads in.
+    const auto messages =
+            pair_pore_reads(dorado::DuplexPairingParameters{read_order, size_t(num_pores)},
+                            num_worker_threads, num_pores, std::string(6000, 'A'),
+                            std::string(6000, 'A'));
+
+    std::set<std::string> read_ids;
+    std::multiset<std::pair<std::string, std::string>> pairs;
+    for (const auto& message : messages) {
+        if (std::holds_alternative<dorado::SimplexReadPtr>(message)) {
+            read_ids.insert(std::get<dorado::SimplexReadPtr>(message)->read_common.read_id);
+        } else if (std::holds_alternative<dorado::ReadPair>(message)) {
+            const auto& pair = std::get<dorado::ReadPair>(message);
+            pairs.emplace(pair.template_read.read_common.read_id,
+                          pair.complement_read.read_common.read_id);
+        }
+    }
+
+    std::set<std::string> expected_read_ids;
+    std::multiset<std::pair<std::string, std::string>> expected_pairs;
+    for (int pore = 0; pore < num_pores; ++pore) {
+        expected_read_ids.insert(pore_read_id(pore, 0));
+        expected_read_ids.insert(pore_read_id(pore, 1));
+        expected_pairs.emplace(pore_read_id(pore, 0), pore_read_id(pore, 1));
+    }
+    CHECK(messages.size() == 3 * size_t(num_pores));
+    CHECK(read_ids == expected_read_ids);
+    CHECK(pairs == expected_pairs);
+}
+
+TEST_CASE("Pairing benchmark across threads", "[!benchmark]" TEST_GROUP) {
+    // Every pair is mapped, so that the workers' time goes on the work which they share.
+    const std::string seq =
+            ReadFileIntoString(std::filesystem::path(get_aligner_data_dir()) / "long_target.fa");
+    auto seq_rc = dorado::utils::reverse_complement(seq);
+    seq_rc = seq_rc.substr(0, size_t(seq.length() * 0.8f));
+    const int num_pores = 256;
+    // Every pore fits in the cache, so the work is the same for each number of threads.
+    const dorado::DuplexPairingParameters pairing_params{dorado::ReadOrder::BY_CHANNEL,
+                                                         size_t(num_pores)};
+
+    for (int num_worker_threads : {1, 2, 4, 8}) {
+        BENCHMARK(std::to_string(num_worker_threads) + " threads") {
+            return pair_pore_reads(pairing_params, num_worker_threads, num_pores, seq, seq_rc)
+                    .size();
+        };
+    }
+}
+
+TEST_CASE("Pairing cache evictions", TEST_GROUP) {
+    // Every read is too short to pair, and the cache holds one pore or two reads per pore, so all
+    // but the last pore or the last two reads are evicted unpaired.
+    const auto read_order = GENERATE(dorado::ReadOrder::BY_CHANNEL, dorado::ReadOrder::BY_TIME);
+    CAPTURE(dorado::to_string(read_order));
+    const size_t cache_depth = read_order == dorado::ReadOrder::BY_CHANNEL ? 1 : 2;
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    auto pairing_node = pipeline_desc.add_node<dorado::PairingNode>(
+            {sink}, dorado::DuplexPairingParameters{read_order, cache_depth}, 1, 100);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    for (int i = 0; i < 4; ++i) {
+        auto read = make_read(i * 2550, 100);
+        if (read_order == dorado::ReadOrder::BY_CHANNEL) {
+            read->read_common.attributes.channel_number = i;
+        }
+        pipeline->push_message(std::move(read));
+    }
+    pipeline->terminate(dorado::DefaultFlushOptions());
+
+    const auto stats = pipeline->get_node_ref(pairing_node).sample_stats();
+    if (read_order == dorado::ReadOrder::BY_CHANNEL) {
+        CHECK(stats.at("pore_evicted_reads") == 3);
+        CHECK(stats.at("pore_evicted_unpaired_reads") == 3);
+        CHECK(stats.at("depth_evicted_reads") == 0);
+    } else {
+        CHECK(stats.at("pore_evicted_reads") == 0);
+        CHECK(stats.at("depth_evicted_reads") == 2);
+        CHECK(stats.at("depth_evicted_unpaired_reads") == 2);
+    }
+    pipeline.reset();
+    CHECK(messages.size() == 4);
+}
+
+TEST_CASE("Pairing with spilled signal", TEST_GROUP) {
+    auto temp_dir = dorado::tests::make_temp_dir("pairing_signal_spill");
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    // Spill the signal of every read once it's no longer being evaluated for pairs.
+    pipeline_desc.add_node<dorado::PairingNode>(
+            {sink},
+            dorado::DuplexPairingParameters{dorado::ReadOrder::BY_TIME,
+                                            dorado::DEFAULT_DUPLEX_CACHE_DEPTH, 1,
+                                            temp_dir.m_path.string()},
+            2, 100);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    std::map<std::string, at::Tensor> signals;
+    for (int i = 0; i < 4; ++i) {
+        auto read = make_read(i * 2550, 6000);
+        read->read_common.read_id = "read_" + std::to_string(i);
+        read->read_common.raw_data = at::randint(-1000, 1000, {4000 + i}, at::kShort);
+        signals[read->read_common.read_id] = read->read_common.raw_data.clone();
+        pipeline->push_message(std::move(read));
+    }
+    pipeline.reset();
+
+    size_t num_reads = 0;
+    size_t num_pairs = 0;
+    for (const auto& message : messages) {
+        if (std::holds_alternative<dorado::SimplexReadPtr>(message)) {
+            const auto& read = std::get<dorado::SimplexReadPtr>(message);
+            CHECK(at::equal(read->read_common.raw_data, signals.at(read->read_common.read_id)));
+            ++num_reads;
+        } else if (std::holds_alternative<dorado::ReadPair>(message)) {
+            const auto& pair = std::get<dorado::ReadPair>(message);
+            for (const auto* read_data : {&pair.template_read, &pair.complement_read}) {
+                CHECK(at::equal(read_data->read_common.raw_data,
+                                signals.at(read_data->read_common.read_id)));
+            }
+            ++num_pairs;
+        }
+    }
+    CHECK(num_reads == 4);
+    CHECK(num_pairs == 3);
+}
@@ -0,0 +1,137 @@
+#include "read_pipeline/read_chunking.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#define TEST_GROUP "[read_chunking]"
+
+using dorado::utils::place_read_chunks;
+using dorado::utils::suggest_chunk_sizes;
+using dorado::utils::tail_chunk_size_idx;
+
+namespace {
+
+constexpr size_t kStride = 6;
+constexpr size_t kOverlap = 498;
+// Deliberately unsorted, as the runners list them.
+const std::vector<size_t> kChunkSizes{9996, 1998, 4998};
+
+}  // namespace
+
+TEST_CASE(TEST_GROUP " tail chunk goes to the smallest fitting chunk size", TEST_GROUP) {
+    CHECK(tail_chunk_size_idx(kChunkSizes, 1, 9996) == 1);
+    CHECK(tail_chunk_size_idx(kChunkSizes, 1998, 9996) == 1);
+    CHECK(tail_chunk_size_idx(kChunkSizes, 1999, 9996) == 2);
+    CHECK(tail_chunk_size_idx(kChunkSizes, 4999, 9996) == 0);
+    // Nothing fits, so the tail gets the read's chunk size.
+    CHECK(tail_chunk_size_idx(kChunkSizes, 20000, 9996) == 0);
+    // Chunk sizes larger than the read's aren't used, even if they would fit.
+    CHECK(tail_chunk_size_idx(kChunkSizes, 3000, 1998) == 1);
+    CHECK(tail_chunk_size_idx(kChunkSizes, 1998, 1998) == 1);
+}
+
+TEST_CASE(TEST_GROUP " short reads are a single chunk", TEST_GROUP) {
+    size_t tail_size = 0;
+    const auto chunks = place_read_chunks(kChunkSizes, 1500, kOverlap, kStride, tail_size);
+    REQUIRE(chunks.size() == 1);
+    CHECK(chunks[0].offset == 0);
+    CHECK(chunks[0].chunk_size_idx == 1);
+    CHECK(tail_size == 1500);
+}
+
+TEST_CASE(TEST_GROUP " tail chunk with a short tail", TEST_GROUP) {
+    // The second full chunk would start at 9498 and overrun the read, so the tail needs
+    // 10100 - 9996 + 498 + 6 = 608 samples and gets the smallest chunk size.
+    size_t tail_size = 0;
+    const auto chunks = place_read_chunks(kChunkSizes, 10100, kOverlap, kStride, tail_size);
+    REQUIRE(chunks.size() == 2);
+    CHECK(chunks[0].offset == 0);
+    CHECK(chunks[0].chunk_size_idx == 0);
+    CHECK(chunks[1].chunk_size_idx == 1);
+    // 10100 - 1998 = 8102, moved up to the next stride boundary.
+    CHECK(chunks[1].offset == 8106);
+    CHECK(tail_size == 608);
+}
+
+TEST_CASE(TEST_GROUP " tail chunks overlap the previous chunk after stride alignment",
+          TEST_GROUP) {
+    std::minstd_rand rng(42);
+    std::uniform_int_distribution<size_t> read_sizes(1, 40000);
+    size_t num_resized = 0;
+    for (int i = 0; i < 10000; ++i) {
+        const size_t raw_size = read_sizes(rng);
+        CAPTURE(raw_size);
+        size_t tail_size = 0;
+        const auto chunks = place_read_chunks(kChunkSizes, raw_size, kOverlap, kStride, tail_size);
+        REQUIRE(!chunks.empty());
+        CHECK(chunks.front().offset == 0);
+
+        const size_t read_chunk_size = kChunkSizes[chunks.front().chunk_size_idx];
+        for (size_t j = 0; j < chunks.size(); ++j) {
+            CAPTURE(j);
+            const size_t chunk_size = kChunkSizes[chunks[j].chunk_size_idx];
+            CHECK(chunks[j].offset % kStride == 0);
+            CHECK(chunk_size <= read_chunk_size);
+            if (j + 1 < chunks.size()) {
+                CHECK(chunk_size == read_chunk_size);
+            }
+            if (j > 0) {
+                // Each chunk starts after the one before, and overlaps it by at least kOverlap.
+                CHECK(chunks[j].offset > chunks[j - 1].offset);
+                CHECK(chunks[j - 1].offset + read_chunk_size >= chunks[j].offset + kOverlap);
+            }
+        }
+
+        const auto& tail = chunks.back();
+        const size_t tail_chunk_size = kChunkSizes[tail.chunk_size_idx];
+        if (chunks.size() == 1) {
+            // The whole read fits in one chunk, which is padded.
+            CHECK(tail_chunk_size >= raw_size);
+        } else {
+            // The last chunk reaches the end of the read, padded by less than a stride.
+            CHECK(tail.offset + tail_chunk_size >= raw_size);
+            CHECK(tail.offset + tail_chunk_size < raw_size + kStride);
+            // No smaller chunk size would have fitted the tail, and a smaller one than the read's
+            // is only used if it does fit.
+            for (const size_t chunk_size : kChunkSizes) {
+                if (chunk_size < tail_chunk_size) {
+                    CHECK(chunk_size < tail_size);
+                }
+            }
+            if (tail_chunk_size != read_chunk_size) {
+                CHECK(tail_size <= tail_chunk_size);
+                ++num_resized;
+            }
+        }
+    }
+    // Make sure the smaller tail chunk sizes were exercised.
+    CHECK(num_resized > 1000);
+}
+
+TEST_CASE(TEST_GROUP " suggested chunk sizes for a known histogram", TEST_GROUP) {
+    // 64 bins of 100 samples, with tails just below 1000 and 4000 samples.
+    constexpr size_t max_chunk_size = 6400;
+    std::vector<int64_t> hist(64, 0);
+    hist[9] = 100;
+    hist[39] = 100;
+
+    // With sizes to spare, the tails each get a chunk size at the top of their bin, and no more
+    // sizes are suggested than help.
+    CHECK(suggest_chunk_sizes(hist, max_chunk_size, 5, 4) == std::vector<size_t>{6400, 4000, 1000});
+    // With one extra size, it goes to the tails which would otherwise be padded more. Sending the
+    // short tails to 4000 pads them by about 3000 samples each, but sending the long tails to
+    // 6400 only pads them by about 2500.
+    CHECK(suggest_chunk_sizes(hist, max_chunk_size, 5, 2) == std::vector<size_t>{6400, 1000});
+    CHECK(suggest_chunk_sizes(hist, max_chunk_size, 5, 1) == std::vector<size_t>{6400});
+
+    // Sizes are rounded up to the stride.
+    CHECK(suggest_chunk_sizes(hist, max_chunk_size, 6, 3) == std::vector<size_t>{6400, 4002, 1002});
+
+    // Tails which only fit the largest chunk size need no other sizes.
+    std::vector<int64_t> long_tails(64, 0);
+    long_tails[63] = 100;
+    CHECK(suggest_chunk_sizes(long_tails, max_chunk_size, 5, 3) == std::vector<size_t>{6400});
+}
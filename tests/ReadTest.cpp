@@ -5,6 +5,8 @@
 #include <catch2/catch.hpp>
 #include <htslib/sam.h>
 
+#include <algorithm>
+
 #define TEST_GROUP "[ReadTest]"
 
 using Catch::Matchers::Equals;
@@ -336,6 +338,76 @@ TEST_CASE(TEST_GROUP ": Methylation tag generation", TEST_GROUP) {
     }
 }
 
+TEST_CASE(TEST_GROUP ": Methylation tag generation from sparse probabilities", TEST_GROUP) {
+    std::vector<std::string> modbase_alphabet = {"A", "a", "C", "m", "G", "T"};
+    std::string modbase_long_names = "6mA 5mC";
+    // Rows for only the called bases, the rest being canonical.
+    dorado::utils::SparseModBaseProbs sparse_probs(modbase_alphabet.size(), {0, 6, 7, 12});
+    const std::vector<std::vector<uint8_t>> rows = {
+            {235, 20, 0, 0, 0, 0},   // A 6mA (weak call)
+            {1, 254, 0, 0, 0, 0},    // A 6mA
+            {0, 0, 3, 252, 0, 0},    // C 5mC
+            {0, 0, 3, 252, 0, 0},    // C 5mC
+    };
+    for (size_t row_idx = 0; row_idx < rows.size(); ++row_idx) {
+        std::copy(rows[row_idx].begin(), rows[row_idx].end(), sparse_probs.row(row_idx));
+    }
+
+    dorado::ReadCommon read_common;
+    read_common.read_id = "read";
+    read_common.seq = "ACAGTGACTAAACTC";
+    read_common.qstring = "***************";
+    read_common.sparse_base_mod_probs = sparse_probs;
+    read_common.is_duplex = false;
+
+    auto extract_tags = [](const dorado::ReadCommon& read, uint8_t threshold) {
+        auto lines = read.extract_sam_lines(false, threshold, false);
+        REQUIRE(!lines.empty());
+        bam1_t* aln = lines[0].get();
+        std::string mm = bam_aux2Z(bam_aux_get(aln, "MM"));
+        const uint8_t* ml = bam_aux_get(aln, "ML");
+        std::vector<int64_t> probs(bam_auxB_len(ml));
+        for (size_t i = 0; i < probs.size(); ++i) {
+            probs[i] = bam_auxB2i(ml, uint32_t(i));
+        }
+        return std::make_pair(mm, probs);
+    };
+
+    SECTION("Tags match those from the dense probabilities") {
+        for (const std::string context : {"", "XC:_:_:_", "DRXCH:_:_:_"}) {
+            for (bool is_duplex : {false, true}) {
+                CAPTURE(context, is_duplex);
+                read_common.is_duplex = is_duplex;
+                read_common.mod_base_info = std::make_shared<dorado::ModBaseInfo>(
+                        modbase_alphabet, modbase_long_names, context);
+                auto dense_read_common = read_common;
+                dense_read_common.base_mod_probs = read_common.dense_base_mod_probs();
+                CHECK(dense_read_common.base_mod_probs.size() ==
+                      read_common.seq.size() * modbase_alphabet.size());
+
+                for (uint8_t threshold : {0, 1, 10, 50, 255}) {
+                    CAPTURE(threshold);
+                    CHECK(extract_tags(read_common, threshold) ==
+                          extract_tags(dense_read_common, threshold));
+                }
+            }
+        }
+    }
+
+    SECTION("Trimmed probabilities") {
+        read_common.mod_base_info =
+                std::make_shared<dorado::ModBaseInfo>(modbase_alphabet, modbase_long_names, "");
+        read_common.seq = read_common.seq.substr(6, 7);  // ACTAAAC
+        read_common.qstring = read_common.qstring.substr(6, 7);
+        read_common.sparse_base_mod_probs.trim({6, 13});
+        CHECK(read_common.sparse_base_mod_probs.positions() == std::vector<uint32_t>{0, 1, 6});
+
+        auto [mm, ml] = extract_tags(read_common, 10);
+        CHECK(mm == "A+a.,0;C+m.,0,0;");
+        CHECK(ml == std::vector<int64_t>{254, 252, 252});
+    }
+}
+
 TEST_CASE(TEST_GROUP ": Test mean q-score generation", TEST_GROUP) {
     dorado::ReadCommon read_common;
     read_common.read_id = "read1";
@@ -55,3 +55,42 @@ TEST_CASE(TEST_TAG " Test Scaled Dot Product Attention", TEST_TAG) {
     }
 #endif  // #if TORCH_VERSION_MAJOR < 2
 }
+
+namespace {
+
+// Checks local_attention_cpu against rotary embedding followed by naive attention with the window
+// mask. qkv is drawn from N(0, qkv_scale^2), so that larger scales spread the attention scores.
+void check_local_attention(int64_t T, std::pair<int, int> attn_window, float qkv_scale) {
+    const auto options = at::TensorOptions().dtype(torch::kFloat32).device(c10::kCPU);
+    const int64_t N = 2, H = 4, D = 16;
+
+    const auto qkv_NT3HD = torch::randn({N, T, 3, H, D}, options) * qkv_scale;
+    RotaryEmbedding rotary_emb(static_cast<int>(D), 10000.0f, 2048, options);
+    auto buffers = rotary_emb->named_buffers();
+    const auto res = local_attention_cpu(qkv_NT3HD, buffers["cos_freqs"], buffers["sin_freqs"],
+                                         attn_window);
+
+    auto qkv_NT3HD_copy = qkv_NT3HD.clone();
+    const auto qkv_3NHTD = rotary_emb(qkv_NT3HD_copy);
+    const auto [win_upper, win_lower] = attn_window;
+    const auto mask = at::ones({T, T}, options).triu_(-win_upper).tril_(win_lower).to(at::kBool);
+    const auto naive_res =
+            scaled_dot_product_attention_naive(qkv_3NHTD[0], qkv_3NHTD[1], qkv_3NHTD[2], mask)
+                    .transpose(1, 2);
+    CHECK(at::allclose(res, naive_res, 1e-4, 1e-5));
+}
+
+}  // namespace
+
+TEST_CASE(TEST_TAG " Test CPU local attention matches naive attention", TEST_TAG) {
+    torch::manual_seed(2);
+    check_local_attention(100, {7, 19}, 1.0f);
+}
+
+TEST_CASE(TEST_TAG " Test CPU local attention across key blocks matches naive attention",
+          TEST_TAG) {
+    // Each query's window spans several of local_attention_cpu's 64-key blocks, so the running
+    // softmax is rescaled as later blocks raise its maximum.
+    torch::manual_seed(3);
+    check_local_attention(300, {100, 100}, 2.0f);
+}
@@ -1,14 +1,20 @@
 #include "utils/sequence_utils.h"
 
 #include <catch2/catch.hpp>
+#include <minimap.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <optional>
+#include <random>
+#include <string>
+#include <vector>
 
 #define TEST_GROUP "[seq_utils]"
 
 using std::make_tuple;
+using dorado::MmTbufPtr;
 using namespace dorado::utils;
 
 TEST_CASE(TEST_GROUP ": Test base_to_int", TEST_GROUP) {
@@ -222,3 +228,118 @@ TEST_CASE("Test sequence to move table index", TEST_GROUP) {
         CHECK(res < 0);
     }
 }
+
+namespace {
+
+// The overlap of a pair of reads as it was computed before OverlapIndex existed, building and
+// destroying a minimap2 index of |query_seq| inline for the one mapping.
+std::optional<OverlapResult> reference_overlap(const std::string& query_seq,
+                                               const std::string& target_seq,
+                                               MmTbufPtr& working_buffer) {
+    mm_idxopt_t idx_opt;
+    mm_mapopt_t map_opt;
+    mm_set_opt(0, &idx_opt, &map_opt);
+    mm_set_opt("map-hifi", &idx_opt, &map_opt);
+    map_opt.cap_kalloc = 100'000'000;
+    map_opt.max_sw_mat = 50'000'000;
+
+    const char* seqs[] = {query_seq.c_str()};
+    const char* names[] = {"query"};
+    mm_idx_t* index = mm_idx_str(idx_opt.w, idx_opt.k, 0, idx_opt.bucket_bits, 1, seqs, names);
+    mm_mapopt_update(&map_opt, index);
+
+    if (!working_buffer) {
+        working_buffer = MmTbufPtr(mm_tbuf_init());
+    }
+    int hits = 0;
+    mm_reg1_t* reg = mm_map(index, int(target_seq.length()), target_seq.c_str(), &hits,
+                            working_buffer.get(), &map_opt, "target");
+    mm_idx_destroy(index);
+
+    std::optional<OverlapResult> overlap_result;
+    if (hits > 0) {
+        const auto best_map = std::max_element(
+                reg, reg + hits,
+                [](const mm_reg1_t& l, const mm_reg1_t& r) { return l.mapq < r.mapq; });
+        OverlapResult result;
+        result.target_start = best_map->rs;
+        result.target_end = best_map->re;
+        result.query_start = best_map->qs;
+        result.query_end = best_map->qe;
+        result.mapq = best_map->mapq;
+        result.rev = best_map->rev;
+        overlap_result = result;
+    }
+    for (int i = 0; i < hits; ++i) {
+        free(reg[i].p);
+    }
+    free(reg);
+    return overlap_result;
+}
+
+}  // namespace
+
+TEST_CASE(TEST_GROUP ": OverlapIndex matches a per-pair minimap2 index", TEST_GROUP) {
+    std::minstd_rand rng(42);
+    auto random_seq = [&rng](size_t len) {
+        std::uniform_int_distribution<int> base_dist(0, 3);
+        std::string seq(len, 'A');
+        for (auto& base : seq) {
+            base = "ACGT"[base_dist(rng)];
+        }
+        return seq;
+    };
+    // Substitute roughly one base in |every|.
+    auto mutate = [&rng](std::string seq, int every) {
+        std::uniform_int_distribution<int> dist(0, every - 1);
+        for (auto& base : seq) {
+            if (dist(rng) == 0) {
+                base = base == 'A' ? 'C' : 'A';
+            }
+        }
+        return seq;
+    };
+
+    const auto temp_seq = random_seq(8000);
+    const auto temp_rc = reverse_complement(temp_seq);
+    // Candidate complements covering accepted and rejected pairs: full and truncated reverse
+    // complements, a noisy one, a forward copy, and unrelated sequence.
+    const std::vector<std::string> candidates{
+            temp_rc,
+            temp_rc.substr(0, 6400),
+            temp_rc.substr(1500),
+            mutate(temp_rc, 20),
+            temp_seq.substr(1000, 5000),
+            random_seq(7000),
+    };
+
+    const OverlapIndex temp_index(temp_seq, "temp");
+    CHECK(temp_index.memory_bytes() > temp_seq.length() / 2);
+    MmTbufPtr shared_buffer;
+    size_t num_overlaps = 0;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        CAPTURE(i);
+        const auto name = "comp" + std::to_string(i);
+        MmTbufPtr buffer;
+        const auto expected = reference_overlap(temp_seq, candidates[i], buffer);
+        // One index and one buffer reused for every candidate, and an index built for the pair.
+        const std::vector<std::optional<OverlapResult>> results{
+                temp_index.map(candidates[i], name, shared_buffer),
+                compute_overlap(temp_seq, "temp", candidates[i], name, buffer)};
+        for (const auto& result : results) {
+            REQUIRE(result.has_value() == expected.has_value());
+            if (expected) {
+                CHECK(result->target_start == expected->target_start);
+                CHECK(result->target_end == expected->target_end);
+                CHECK(result->query_start == expected->query_start);
+                CHECK(result->query_end == expected->query_end);
+                CHECK(result->mapq == expected->mapq);
+                CHECK(result->rev == expected->rev);
+            }
+        }
+        num_overlaps += expected.has_value();
+    }
+    // The candidates cover both mapped and unmapped cases.
+    CHECK(num_overlaps > 0);
+    CHECK(num_overlaps < candidates.size());
+}
@@ -0,0 +1,81 @@
+#include "TestUtils.h"
+#include "utils/signal_spill_file.h"
+
+#include <torch/torch.h>
+// Catch2 must come after torch since both define CHECK()
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+#define CUT_TAG "[SignalSpillFile]"
+
+using namespace dorado::utils;
+
+// Spilling isn't supported on Windows, where tensors are returned unchanged.
+#ifndef _WIN32
+
+TEST_CASE(CUT_TAG ": spilled tensors keep their contents", CUT_TAG) {
+    auto temp_dir = dorado::tests::make_temp_dir("signal_spill_contents");
+    SignalSpillFile spill_file(temp_dir.m_path);
+
+    const std::vector<at::Tensor> signals{
+            torch::randint(-2000, 2000, {12345}, torch::kInt16),
+            torch::rand({3, 1001}, torch::kFloat).to(torch::kHalf),
+            torch::randint(-2000, 2000, {8, 9}, torch::kInt16).transpose(0, 1),
+    };
+    std::vector<at::Tensor> spilled;
+    for (const auto& signal : signals) {
+        spilled.push_back(spill_file.spill(signal));
+    }
+    for (size_t i = 0; i < signals.size(); ++i) {
+        CHECK(spilled[i].data_ptr() != signals[i].data_ptr());
+        CHECK(spilled[i].scalar_type() == signals[i].scalar_type());
+        CHECK(torch::equal(spilled[i], signals[i]));
+    }
+    CHECK(spill_file.spilled_bytes() == SignalSpillFile::SEGMENT_SIZE);
+}
+
+TEST_CASE(CUT_TAG ": segments are released with their tensors", CUT_TAG) {
+    auto temp_dir = dorado::tests::make_temp_dir("signal_spill_release");
+    SignalSpillFile spill_file(temp_dir.m_path);
+
+    // Each signal fills most of a segment, so each one gets its own.
+    const auto num_samples = int64_t(SignalSpillFile::SEGMENT_SIZE / sizeof(int16_t) * 3 / 4);
+    auto first = spill_file.spill(torch::zeros({num_samples}, torch::kInt16));
+    auto second = spill_file.spill(torch::ones({num_samples}, torch::kInt16));
+    CHECK(spill_file.spilled_bytes() == 2 * SignalSpillFile::SEGMENT_SIZE);
+
+    // The segment being filled stays in use, the other is released.
+    first.reset();
+    second.reset();
+    CHECK(spill_file.spilled_bytes() == SignalSpillFile::SEGMENT_SIZE);
+
+    // Moving on to a new segment releases the old one, as nothing refers to it any more.
+    auto third = spill_file.spill(torch::full({num_samples}, 3, torch::kInt16));
+    auto fourth = spill_file.spill(torch::full({16}, 4, torch::kInt16));
+    CHECK(spill_file.spilled_bytes() == SignalSpillFile::SEGMENT_SIZE);
+    CHECK(third.eq(3).all().item<bool>());
+    CHECK(fourth.eq(4).all().item<bool>());
+}
+
+TEST_CASE(CUT_TAG ": spilled tensors can outlive the file", CUT_TAG) {
+    auto temp_dir = dorado::tests::make_temp_dir("signal_spill_outlive");
+    const auto signal = torch::randint(-2000, 2000, {4000}, torch::kInt16);
+    at::Tensor spilled;
+    {
+        SignalSpillFile spill_file(temp_dir.m_path);
+        spilled = spill_file.spill(signal);
+    }
+    CHECK(torch::equal(spilled, signal));
+}
+
+TEST_CASE(CUT_TAG ": tensors larger than a segment aren't spilled", CUT_TAG) {
+    auto temp_dir = dorado::tests::make_temp_dir("signal_spill_large");
+    SignalSpillFile spill_file(temp_dir.m_path);
+
+    const auto signal = torch::zeros({int64_t(SignalSpillFile::SEGMENT_SIZE) + 1}, torch::kInt8);
+    CHECK(spill_file.spill(signal).is_same(signal));
+    CHECK(spill_file.spilled_bytes() == 0);
+}
+
+#endif  // _WIN32
@@ -2,6 +2,7 @@
 #include "read_pipeline/NullNode.h"
 #include "read_pipeline/ReadPipeline.h"
 #include "read_pipeline/StereoDuplexEncoderNode.h"
+#include "read_pipeline/stereo_features.h"
 
 #include <torch/torch.h>
 // Catch2 must come after torch since both define CHECK()
@@ -87,3 +88,76 @@ TEST_CASE(TEST_GROUP "Encoder") {
     // Check if the encoded signal is NOT equal to the expected stereo_raw_data
     REQUIRE(!torch::equal(stereo_raw_data, swapped_stereo_read->read_common.raw_data));
 }
+
+// Tests the layout of the stereo features for a small alignment with an insertion either way.
+TEST_CASE(TEST_GROUP "Features layout") {
+    dorado::DuplexRead::StereoFeatureInputs inputs;
+    inputs.signal_stride = 2;
+    // Template bases cover samples [0, 4), [4, 6) and [6, 8).
+    inputs.template_seq = "ACG";
+    inputs.template_qstring = "+5?";
+    inputs.template_moves = {1, 0, 1, 1};
+    inputs.template_signal = torch::arange(1, 9, torch::kFloat16);
+    inputs.template_seq_start = 0;
+    // The complement signal is flipped, so its bases cover samples [0, 2), [2, 6) and [6, 8).
+    inputs.complement_seq = "GTA";
+    inputs.complement_qstring = "?5+";
+    inputs.complement_moves = {1, 1, 0, 1};
+    inputs.complement_signal = torch::arange(11, 19, torch::kFloat16);
+    inputs.complement_seq_start = 0;
+    // A match, then a template base with no complement base, then the reverse.
+    inputs.alignment = {0, 1, 2};
+
+    const auto features = dorado::generate_stereo_features(inputs);
+
+    const auto pad = static_cast<float>(c10::Half(0.8f));
+    auto expected = torch::zeros({13, 10}, torch::kFloat16);
+    expected[0] = pad;
+    expected[1] = pad;
+    using torch::indexing::Slice;
+    // Template signal, bases and q scores.
+    expected.index_put_({0, Slice(0, 6)}, inputs.template_signal.slice(0, 0, 6));
+    expected.index_put_({2, Slice(0, 4)}, 1);
+    expected.index_put_({3, Slice(4, 6)}, 1);
+    expected.index_put_({11, Slice(0, 4)}, 10 / 90.f);
+    expected.index_put_({11, Slice(4, 6)}, 20 / 90.f);
+    // Complement signal, bases and q scores, the latter read from the end of the qstring.
+    expected.index_put_({1, Slice(0, 2)}, inputs.complement_signal.slice(0, 0, 2));
+    expected.index_put_({1, Slice(6, 10)}, inputs.complement_signal.slice(0, 2, 6));
+    expected.index_put_({8, Slice(0, 4)}, 1);
+    expected.index_put_({9, Slice(6, 10)}, 1);
+    expected.index_put_({12, Slice(0, 4)}, 10 / 90.f);
+    expected.index_put_({12, Slice(6, 10)}, 20 / 90.f);
+    // Move table.
+    expected.index_put_({10, 0}, 1);
+    expected.index_put_({10, 4}, 1);
+    expected.index_put_({10, 6}, 1);
+
+    REQUIRE(torch::equal(features, expected));
+
+    // An alignment which runs past the last base is rejected.
+    inputs.alignment = {0, 0, 0, 0};
+    CHECK_THROWS(dorado::generate_stereo_features(inputs));
+}
+
+TEST_CASE(TEST_GROUP "Features benchmark", "[!benchmark]" TEST_GROUP) {
+    dorado::DuplexRead::StereoFeatureInputs inputs;
+    inputs.template_seq = ReadFileIntoString(DataPath("template_seq"));
+    inputs.template_qstring = ReadFileIntoString(DataPath("template_qstring"));
+    inputs.template_moves = ReadFileIntoVector(DataPath("template_moves"));
+    torch::load(inputs.template_signal, DataPath("template_raw_data.tensor").string());
+    inputs.template_signal = inputs.template_signal.to(torch::kFloat16);
+    inputs.template_seq_start = 0;
+    inputs.complement_seq = ReadFileIntoString(DataPath("complement_seq"));
+    inputs.complement_qstring = ReadFileIntoString(DataPath("complement_qstring"));
+    inputs.complement_moves = ReadFileIntoVector(DataPath("complement_moves"));
+    torch::load(inputs.complement_signal, DataPath("complement_raw_data.tensor").string());
+    inputs.complement_signal = inputs.complement_signal.to(torch::kFloat16).flip(0);
+    inputs.complement_seq_start = 0;
+    inputs.signal_stride = 5;
+    // A gapless alignment of the shorter read against the start of the longer one.
+    const auto num_bases = std::min(inputs.template_seq.size(), inputs.complement_seq.size()) - 1;
+    inputs.alignment.assign(num_bases, 0);
+
+    BENCHMARK("generate_stereo_features") { return dorado::generate_stereo_features(inputs); };
+}
@@ -39,10 +39,12 @@ A        C        G     T     C           G        C     G  T           C
 1, 0, 0, 1, 0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0, 1, 0, 1, 1, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 1, 0
 */
 // clang-format on
-TEST_CASE("Test stitch_chunks", TEST_GROUP) {
-    constexpr size_t CHUNK_SIZE = 10;
-    constexpr size_t OVERLAP = 3;
+namespace {
+
+constexpr size_t CHUNK_SIZE = 10;
+constexpr size_t OVERLAP = 3;
 
+std::vector<std::unique_ptr<dorado::utils::Chunk>> make_called_chunks() {
     std::vector<std::unique_ptr<dorado::utils::Chunk>> called_chunks;
 
     size_t offset = 0;
@@ -64,19 +66,61 @@ TEST_CASE("Test stitch_chunks", TEST_GROUP) {
         chunk->moves = MOVES[chunk_idx];
         called_chunks.push_back(std::move(chunk));
     }
+    return called_chunks;
+}
+
+const std::string expected_sequence = "ACGTCGCGTCGTCGTCCGT";
+const std::string expected_qstring = "!&.-&.&.-&.-&.-&&.-";
+const std::vector<uint8_t> expected_moves = {1, 0, 0, 1, 0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0,
+                                             1, 0, 1, 1, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 1, 0, 0,
+                                             1, 0, 1, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 1};
+
+}  // namespace
+
+TEST_CASE("Test stitch_chunks", TEST_GROUP) {
+    auto called_chunks = make_called_chunks();
 
     dorado::ReadCommon read_common;
     read_common.model_stride = static_cast<int>(dorado::utils::div_round_closest(
             called_chunks[0]->raw_chunk_size, called_chunks[0]->moves.size()));
     REQUIRE_NOTHROW(dorado::utils::stitch_chunks(read_common, called_chunks));
 
-    const std::string expected_sequence = "ACGTCGCGTCGTCGTCCGT";
-    const std::string expected_qstring = "!&.-&.&.-&.-&.-&&.-";
-    const std::vector<uint8_t> expected_moves = {1, 0, 0, 1, 0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0,
-                                                 1, 0, 1, 1, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 1, 0, 0,
-                                                 1, 0, 1, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0, 1};
-
     REQUIRE(read_common.seq == expected_sequence);
     REQUIRE(read_common.qstring == expected_qstring);
     REQUIRE(read_common.moves == expected_moves);
 }
+
+TEST_CASE("Test ChunkStitcher with out of order chunks", TEST_GROUP) {
+    auto called_chunks = make_called_chunks();
+    const int model_stride = static_cast<int>(dorado::utils::div_round_closest(
+            called_chunks[0]->raw_chunk_size, called_chunks[0]->moves.size()));
+    std::vector<size_t> chunk_offsets;
+    for (const auto &chunk : called_chunks) {
+        chunk_offsets.push_back(chunk->input_offset);
+    }
+
+    // The read can only be stitched once the first chunk arrives, which is last here.
+    dorado::utils::ChunkStitcher stitcher(chunk_offsets, RAW_SIGNAL_SIZE, model_stride);
+    const std::vector<size_t> order{3, 1, 6, 2, 5, 4, 0};
+    for (size_t i = 0; i < order.size(); ++i) {
+        const bool all_added = stitcher.add_chunk(order[i], std::move(called_chunks[order[i]]));
+        CHECK(all_added == (i + 1 == order.size()));
+    }
+
+    dorado::ReadCommon read_common;
+    read_common.model_stride = model_stride;
+    stitcher.finalise(read_common);
+
+    // The full signal length is known here, so the final move isn't dropped as an overhang.
+    auto expected_full_moves = expected_moves;
+    expected_full_moves.push_back(0);
+    REQUIRE(read_common.seq == expected_sequence);
+    REQUIRE(read_common.qstring == expected_qstring);
+    REQUIRE(read_common.moves == expected_full_moves);
+
+    // The buffers are reserved for the whole read up front, rather than grown or trimmed.
+    const size_t max_moves = RAW_SIGNAL_SIZE / model_stride + 1;
+    CHECK(read_common.seq.capacity() >= max_moves);
+    CHECK(read_common.qstring.capacity() >= max_moves);
+    CHECK(read_common.moves.capacity() >= max_moves);
+}
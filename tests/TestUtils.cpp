@@ -61,6 +61,33 @@ TempDir make_temp_dir(const std::string& prefix) {
     return TempDir(std::move(path));
 }
 
+namespace {
+
+// Sets |name| to |value|, or unsets it if |value| is empty.
+void set_env_var(const std::string& name, const std::optional<std::string>& value) {
+#ifdef _WIN32
+    // An empty value removes the variable on Windows.
+    _putenv_s(name.c_str(), value ? value->c_str() : "");
+#else
+    if (value) {
+        setenv(name.c_str(), value->c_str(), 1);
+    } else {
+        unsetenv(name.c_str());
+    }
+#endif
+}
+
+}  // namespace
+
+ScopedEnvVar::ScopedEnvVar(std::string name, const std::string& value) : m_name(std::move(name)) {
+    if (const char* previous_value = std::getenv(m_name.c_str())) {
+        m_previous_value = previous_value;
+    }
+    set_env_var(m_name, value);
+}
+
+ScopedEnvVar::~ScopedEnvVar() { set_env_var(m_name, m_previous_value); }
+
 std::string ReadFileIntoString(const std::filesystem::path& path) {
     const auto num_bytes = std::filesystem::file_size(path);
     std::string content;
@@ -4,6 +4,7 @@
 
 #include <cstring>
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -54,6 +55,21 @@ public:
 
 TempDir make_temp_dir(const std::string& prefix);
 
+// Sets an environment variable for as long as it exists, then restores its previous value, or
+// unsets it if it wasn't set before.
+class ScopedEnvVar {
+public:
+    ScopedEnvVar(std::string name, const std::string& value);
+    ~ScopedEnvVar();
+
+    ScopedEnvVar(const ScopedEnvVar&) = delete;
+    ScopedEnvVar& operator=(const ScopedEnvVar&) = delete;
+
+private:
+    std::string m_name;
+    std::optional<std::string> m_previous_value;
+};
+
 class TraceLogger {
 public:
     TraceLogger() { spdlog::set_level(spdlog::level::trace); }
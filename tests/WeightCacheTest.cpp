@@ -0,0 +1,76 @@
+#include "TestUtils.h"
+#include "utils/weight_cache.h"
+
+#include <torch/torch.h>
+// Catch2 must come after torch since both define CHECK()
+#include <catch2/catch.hpp>
+
+#include <fstream>
+
+#define CUT_TAG "[WeightCache]"
+
+using namespace dorado::utils;
+
+TEST_CASE(CUT_TAG ": round trip", CUT_TAG) {
+    auto temp_dir = dorado::tests::make_temp_dir("weight_cache_round_trip");
+    const auto cache_path = temp_dir.m_path / "model.weights";
+
+    const std::vector<at::Tensor> weights{
+            torch::rand({3, 5}, torch::kFloat),
+            torch::rand({7}, torch::kFloat).to(torch::kHalf),
+            torch::randint(0, 100, {2, 2, 2}, torch::kInt64),
+            torch::rand({4, 6}, torch::kFloat).transpose(0, 1),
+    };
+    save_weight_cache(cache_path, "fingerprint", weights);
+
+    auto loaded = load_weight_cache(cache_path, "fingerprint");
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->size() == weights.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        CHECK(loaded->at(i).scalar_type() == weights[i].scalar_type());
+        CHECK(torch::equal(loaded->at(i), weights[i]));
+        CHECK(reinterpret_cast<uintptr_t>(loaded->at(i).data_ptr()) % 64 == 0);
+    }
+
+    // Writes to the loaded tensors don't modify the cache.
+    loaded->at(0).zero_();
+    auto reloaded = load_weight_cache(cache_path, "fingerprint");
+    REQUIRE(reloaded.has_value());
+    CHECK(torch::equal(reloaded->at(0), weights[0]));
+}
+
+TEST_CASE(CUT_TAG ": invalid caches are rejected", CUT_TAG) {
+    auto temp_dir = dorado::tests::make_temp_dir("weight_cache_invalid");
+    const auto cache_path = temp_dir.m_path / "model.weights";
+
+    CHECK_FALSE(load_weight_cache(cache_path, "fingerprint").has_value());
+
+    save_weight_cache(cache_path, "fingerprint", {torch::rand({16}, torch::kFloat)});
+    CHECK_FALSE(load_weight_cache(cache_path, "other fingerprint").has_value());
+
+    // Truncate the data.
+    std::filesystem::resize_file(cache_path, std::filesystem::file_size(cache_path) - 4);
+    CHECK_FALSE(load_weight_cache(cache_path, "fingerprint").has_value());
+}
+
+TEST_CASE(CUT_TAG ": directory fingerprint tracks contents", CUT_TAG) {
+    auto temp_dir = dorado::tests::make_temp_dir("weight_cache_fingerprint");
+    std::ofstream(temp_dir.m_path / "a.tensor") << "abc";
+    const auto fingerprint = directory_fingerprint(temp_dir.m_path);
+    CHECK(directory_fingerprint(temp_dir.m_path) == fingerprint);
+
+    std::ofstream(temp_dir.m_path / "a.tensor", std::ios::app) << "def";
+    const auto modified_fingerprint = directory_fingerprint(temp_dir.m_path);
+    CHECK(modified_fingerprint != fingerprint);
+
+    std::ofstream(temp_dir.m_path / "b.tensor") << "abc";
+    CHECK(directory_fingerprint(temp_dir.m_path) != modified_fingerprint);
+}
+
+TEST_CASE(CUT_TAG ": cache file stem", CUT_TAG) {
+    const std::filesystem::path model_path = "/models/dna_r10.4.1_e8.2_400bps_hac@v4.2.0";
+    const auto stem = cache_file_stem(model_path, "key");
+    // The first 8 bytes of SHA-256("key").
+    CHECK(stem == "dna_r10.4.1_e8.2_400bps_hac@v4.2.0_2c70e12b7a0646f9");
+    CHECK(cache_file_stem(model_path, "other key") != stem);
+}
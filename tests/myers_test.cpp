@@ -2,11 +2,65 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
 #define CUT_TAG "[myers]"
 #define DEFINE_TEST(name) TEST_CASE(CUT_TAG " " name, CUT_TAG)
 
 using dorado::splitter::EdistResult;
 using dorado::splitter::myers_align;
+using dorado::splitter::myers_align_multi;
+using dorado::splitter::myers_best_edists;
+
+namespace {
+
+// The edit distance of the best match of the whole of query to any part of seq, by full DP.
+std::size_t best_edist_dp(std::string_view query, std::string_view seq) {
+    // Column over the query, with a free start anywhere in seq.
+    std::vector<std::size_t> column(query.size() + 1);
+    std::iota(column.begin(), column.end(), std::size_t{0});
+    std::size_t best = column.back();
+    for (const char c : seq) {
+        std::size_t diag = column[0];
+        for (std::size_t i = 1; i <= query.size(); ++i) {
+            const auto up = column[i];
+            column[i] = std::min({diag + (query[i - 1] == c ? 0 : 1), up + 1, column[i - 1] + 1});
+            diag = up;
+        }
+        best = std::min(best, column.back());
+    }
+    return best;
+}
+
+std::string random_sequence(std::minstd_rand& rng, std::size_t length) {
+    std::string seq(length, 'A');
+    for (auto& c : seq) {
+        c = "ACGT"[rng() % 4];
+    }
+    return seq;
+}
+
+// A sequence with a mutated copy of each of |queries| planted in it.
+std::string sequence_with_queries(std::minstd_rand& rng,
+                                  const std::vector<std::string>& queries,
+                                  std::size_t length) {
+    auto seq = random_sequence(rng, length);
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        auto planted = queries[i];
+        if (planted.size() > 2) {
+            planted[planted.size() / 2] = 'T';
+            planted.erase(planted.size() / 3, 1);
+        }
+        seq.replace((i + 1) * length / (queries.size() + 1), planted.size(), planted);
+    }
+    return seq;
+}
+
+}  // namespace
 
 DEFINE_TEST("Basic alignment, single hit") {
     const std::string_view query = "AAA";
@@ -93,3 +147,110 @@ DEFINE_TEST("Complex alignment, doesn't crash when high edist near start") {
     const auto alignments = myers_align(query, seq, max_edist);
     CHECK(!alignments.empty());
 }
+
+DEFINE_TEST("Best edists of many sequences match DP") {
+    std::minstd_rand rng(42);
+    // Short enough for one word, the longest that fits, and long enough to need edlib.
+    const auto query_len = GENERATE(std::size_t{3}, std::size_t{24}, std::size_t{63},
+                                    std::size_t{80});
+    CAPTURE(query_len);
+    const auto query = random_sequence(rng, query_len);
+
+    std::vector<std::string> seqs;
+    seqs.push_back("");
+    // More sequences than fit in one scan, in no particular order of length.
+    for (std::size_t len : {1, 20, 100, 250, 7, 180, 64}) {
+        auto seq = random_sequence(rng, len);
+        // Plant a mutated copy of the query in the longer sequences.
+        if (len > 2 * query_len) {
+            auto planted = query;
+            planted[planted.size() / 2] = 'N';
+            planted.erase(planted.size() / 3, 1);
+            seq.replace(len / 3, planted.size(), planted);
+        }
+        seqs.push_back(std::move(seq));
+    }
+    const std::vector<std::string_view> seq_views(seqs.begin(), seqs.end());
+
+    const auto edists = myers_best_edists(query, seq_views);
+    REQUIRE(edists.size() == seqs.size());
+    for (std::size_t i = 0; i < seqs.size(); ++i) {
+        CAPTURE(i);
+        CHECK(edists[i] == best_edist_dp(query, seqs[i]));
+    }
+}
+
+DEFINE_TEST("Multiple queries match aligning one at a time") {
+    std::minstd_rand rng(42);
+    // More queries than fit in one scan, including an empty one and one longer than the sequence.
+    const auto seq_len = GENERATE(std::size_t{0}, std::size_t{40}, std::size_t{1000});
+    CAPTURE(seq_len);
+    std::vector<std::string> queries;
+    for (std::size_t len : {24, 1, 63, 0, 14, 50, 5}) {
+        queries.push_back(random_sequence(rng, len));
+    }
+    // Only the longest sequence has room for copies of the queries.
+    const auto seq = seq_len > 400 ? sequence_with_queries(rng, queries, seq_len)
+                                   : random_sequence(rng, seq_len);
+    const std::vector<std::string_view> query_views(queries.begin(), queries.end());
+
+    const auto max_edist = GENERATE(std::size_t{0}, std::size_t{2}, std::size_t{5});
+    CAPTURE(max_edist);
+    const auto results = myers_align_multi(query_views, seq, max_edist);
+    REQUIRE(results.size() == queries.size());
+    CHECK(results[3].empty());
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        if (queries[i].empty()) {
+            continue;
+        }
+        CAPTURE(i);
+        const auto expected = myers_align(queries[i], seq, max_edist);
+        REQUIRE(results[i].size() == expected.size());
+        for (std::size_t j = 0; j < expected.size(); ++j) {
+            CHECK(results[i][j].begin == expected[j].begin);
+            CHECK(results[i][j].end == expected[j].end);
+            CHECK(results[i][j].edist == expected[j].edist);
+        }
+    }
+}
+
+TEST_CASE(CUT_TAG " benchmark multiple queries", "[!benchmark]" CUT_TAG) {
+    std::minstd_rand rng(42);
+    std::vector<std::string> queries;
+    for (std::size_t len : {24, 14, 24, 40}) {
+        queries.push_back(random_sequence(rng, len));
+    }
+    const auto seq = sequence_with_queries(rng, queries, 100000);
+    const std::vector<std::string_view> query_views(queries.begin(), queries.end());
+
+    BENCHMARK("one at a time") {
+        std::vector<std::vector<EdistResult>> results;
+        for (const auto query : query_views) {
+            results.push_back(myers_align(query, seq, 5));
+        }
+        return results;
+    };
+    BENCHMARK("together") { return myers_align_multi(query_views, seq, 5); };
+}
+
+TEST_CASE(CUT_TAG " benchmark best edists", "[!benchmark]" CUT_TAG) {
+    std::minstd_rand rng(42);
+    const auto query = random_sequence(rng, 24);
+    // Spans of the sizes searched for an adapter around possible pore regions, some holding it.
+    std::vector<std::string> seqs;
+    for (std::size_t i = 0; i < 64; ++i) {
+        const auto len = 100 + rng() % 400;
+        seqs.push_back(i % 2 ? sequence_with_queries(rng, {query}, len)
+                             : random_sequence(rng, len));
+    }
+    const std::vector<std::string_view> seq_views(seqs.begin(), seqs.end());
+
+    BENCHMARK("one at a time") {
+        std::vector<std::size_t> edists;
+        for (const auto seq : seq_views) {
+            edists.push_back(myers_best_edists(query, {seq}).front());
+        }
+        return edists;
+    };
+    BENCHMARK("together") { return myers_best_edists(query, seq_views); };
+}